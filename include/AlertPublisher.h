@@ -0,0 +1,106 @@
+/**
+ * @file      AlertPublisher.h
+ * @brief     Compact zone/TTC event stream over UDP or a unix datagram socket
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef ALERT_PUBLISHER_H
+#define ALERT_PUBLISHER_H
+
+#include <atomic>
+#include <string>
+#include <sys/socket.h>
+#include <stdint.h>
+#include "ZoneDangerDetector.h"
+
+#define ALERT_RECORD_MAGIC   0x4c415341  /* "ASAL" */
+#define ALERT_RECORD_VERSION 1
+
+#define ALERT_ZONE_VALID    0x01    /* the zone had valid depth */
+#define ALERT_ZONE_WARN     0x02    /* nearest depth below the zone threshold */
+#define ALERT_ZONE_TTC_WARN 0x04    /* time to collision at or below the TTC threshold */
+
+/* wire record, little endian, python struct format '<IHHIIQQ32s' + 3 * 'HBxff' */
+#pragma pack(push, 1)
+struct AlertZoneRecord {
+    uint16_t min_depth;     /* mm, 0 when the zone has no valid depth */
+    uint8_t flags;          /* ALERT_ZONE_* */
+    uint8_t reserved;
+    float velocity;         /* m/s, negative when approaching */
+    float ttc;              /* s, negative when not approaching */
+};
+
+struct AlertRecord {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;          /* sizeof(AlertRecord) */
+    uint32_t camera_id;     /* index of the camera in this ascamera process */
+    uint32_t frame_id;
+    uint64_t timestamp;     /* capture timestamp of the depth frame (AS_Frame_s::ts) */
+    uint64_t sequence;      /* records sent for this camera, gaps mean lost records */
+    char serial[32];        /* camera serial number, NUL padded */
+    AlertZoneRecord zones[ZONE_COUNT];
+};
+#pragma pack(pop)
+
+/*
+ * Sends one fixed size AlertRecord per frame, or only when a zone changes
+ * state (plus a keepalive), to a UDP address or a unix datagram socket path.
+ * Sends never block: a missing or slow listener only loses records.
+ */
+class AlertPublisher
+{
+public:
+    AlertPublisher();
+    ~AlertPublisher();
+
+    /**
+     * @brief     open the event socket
+     * @param[in]target : "udp://host:port" or "unix:///path/to/socket"
+     * @param[in]on_change : send only on zone state changes and keepalives
+     * @return    true on success
+     */
+    bool open(const std::string &target, bool on_change);
+    void close();
+    bool isOpen() const
+    {
+        return m_socket >= 0;
+    }
+
+    /* per camera state, owned by the caller */
+    struct Channel {
+        uint32_t camera_id;
+        std::string serial;
+        uint64_t sequence;
+        uint64_t last_sent;     /* steady clock ms of the last record */
+        uint8_t last_flags[ZONE_COUNT];
+    };
+
+    void publish(Channel &channel, const ZoneDangerResult &result);
+
+    uint64_t sentCount() const
+    {
+        return m_sent;
+    }
+    uint64_t failedCount() const
+    {
+        return m_failed;
+    }
+
+private:
+    int m_socket;
+    bool m_on_change;
+    struct sockaddr_storage m_address;
+    socklen_t m_address_len;
+    std::atomic<uint64_t> m_sent;
+    std::atomic<uint64_t> m_failed;
+
+    static const uint64_t KEEPALIVE_MS = 1000;
+};
+
+#endif // ALERT_PUBLISHER_H
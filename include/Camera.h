@@ -10,11 +10,24 @@
 
  */
 #pragma once
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <thread>
+#include <memory>
+#include <vector>
 #include "Logger.h"
 #include "as_camera_sdk_api.h"
 #include "common.h"
+#include "FramePool.h"
+#include "ImageWriter.h"
+#include "VirtualCamera.h"
+#include "CameraCalibration.h"
+#include "Undistortion.h"
+#include "LatencyTracer.h"
+#include "EventTracer.h"
 #ifdef CFG_OPENCV_ON
 #include "opencv2/opencv.hpp"
 #include "opencv2/highgui/highgui_c.h"
@@ -31,27 +44,45 @@ public:
     };
     ~CheckFps() {};
 public:
-    double checkFps(const std::string &sn, const std::string &Info)
+    /* counts a frame, returns the rate once every m_duration and 0 in between */
+    double checkFps()
     {
         double fps = 0.0;
         auto t_cur = std::chrono::steady_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(t_cur - t_last).count();
         if (duration > m_duration) {
-            fps = frameCount / (duration / 1000);
+            fps = frameCount * 1000.0 / duration;
             frameCount = 0;
             t_last = t_cur;
-            LOG(INFO) << "#camera[" << Info << "] SN[" << sn << "]'s FrameRate:" << fps << std::endl;
+            m_fps = fps;
         }
         ++frameCount;
         return fps;
     }
+    /* rate of the last complete window, read from any thread */
+    double getFps() const
+    {
+        return m_fps;
+    }
 private:
     AS_CAM_PTR m_pCamera;
     unsigned int frameCount = 0;
     std::chrono::steady_clock::time_point t_last;
+    std::atomic<double> m_fps {0.0};
     const unsigned int m_duration = 2000; /* ms */
 };
 
+struct CameraStats {
+    uint64_t frames;            /* SDK callbacks */
+    uint64_t depth_frames;      /* callbacks with a depth plane */
+    uint64_t callback_ns;       /* time spent in the callbacks */
+    double fps;                 /* callback rate of the last two seconds */
+    uint64_t pool_exhausted;    /* frames lost because every pooled slot was in use */
+};
+
+/* serial number and the snapshot just published, called on the camera's background thread */
+typedef std::function<void(const std::string &serialno, const CameraCalibration &calibration)> CalibrationCallback;
+
 class Camera
 {
 public:
@@ -59,13 +90,34 @@ public:
     ~Camera();
 public:
     int init();
-    double checkFps();
+    /* counts a frame for the frame rate, logs it every two seconds when log is set */
+    double checkFps(bool log);
+    /* counts one SDK callback and the time it took */
+    void countFrame(const AS_SDK_Data_s *pstData, uint64_t callback_ns);
+    void getStats(CameraStats &stats);
     int enableSaveImage(bool enable);
     int enableDisplay(bool enable);
     bool getDisplayStatus();
     int getSerialNo(std::string &sn);
+    AS_SDK_CAM_MODEL_E getCameraType();
+    /* replayed or synthetic, not known to the SDK */
+    bool isVirtual();
     int getCameraAttrs(AS_CAM_ATTR_S &attr);
-    void saveImage(const AS_SDK_Data_s *pstData);
+    /* latest calibration, nullptr until the first fetch; a snapshot is never changed and lives as long as the camera */
+    const CameraCalibration *getCalibration() const;
+    /* fetch the calibration again on the background thread */
+    void refreshCalibration();
+    /* before init(), told about every snapshot published */
+    void setCalibrationCallback(const CalibrationCallback &callback);
+    /* before init(), rectify the planes of every frame; the published calibration then has no distortion */
+    void enableUndistortion(bool enable);
+    /* copy the SDK frame into a pooled slot shared by every consumer, arrival_ns stamps its trace */
+    FrameRef acquireFrame(const AS_SDK_Data_s *pstData, uint64_t arrival_ns = 0);
+    /* bytes per plane of the current stream mode, indexed by AS_FRAME_Type_e, 0 when unknown */
+    void getPlaneCapacity(size_t capacity[AS_FRAME_TYPE_BUTT]);
+    /* images are saved by this writer, shared by every camera */
+    void setImageWriter(const std::shared_ptr<ImageWriter> &writer);
+    void saveImage(const FrameRef &frame);
     void saveMergeImage(const AS_SDK_MERGE_s *pstData);
     void displayImage(const std::string &serialno, const std::string &info, const AS_SDK_Data_s *pstData);
     void displayMergeImage(const std::string &serialno, const std::string &info, const AS_SDK_MERGE_s *pstData);
@@ -88,19 +140,40 @@ public:
 
 private:
     int backgroundThread();
+    void createFramePool();
+    void queryPlaneCapacity();
+    bool fetchCalibration(CameraCalibration &calibration);
+    void publishCalibration(const CameraCalibration &calibration);
+    void logCalibration(const CameraCalibration &calibration);
+    void queueImage(const std::string &name, const FrameRef &frame, const void *data, size_t size);
     void YV16toBGR(unsigned char *yv16Data, unsigned char *bgrData, unsigned int width, unsigned int height);
 
 private:
     AS_CAM_PTR m_handle = nullptr;
+    bool m_virtual = false;
+    uint32_t m_trace_id = LatencyTracer::NO_CAMERA;
+    VirtualCameraInfo m_virtual_info;
     std::string m_serialno;
     CheckFps *m_check_fps = nullptr;
+    /* bumped by the SDK callback thread only, read by the metrics scrape */
+    std::atomic<uint64_t> m_frames {0};
+    std::atomic<uint64_t> m_depth_frames {0};
+    std::atomic<uint64_t> m_callback_ns {0};
     bool m_save_img = false;
     bool m_save_merge_img = false;
     /* display image by opecv show */
     bool m_display = false;
     bool m_display_merge = false;
     AS_CAM_ATTR_S m_attr;
-    AS_CAM_Parameter_s m_cam_parameter;
+    /* every snapshot ever published, only the newest one is handed out */
+    std::vector<std::unique_ptr<CameraCalibration>> m_calibrations;
+    std::atomic<const CameraCalibration *> m_calibration {nullptr};
+    CalibrationCallback m_calibration_callback;
+    /* rectifies planes as frames are pooled, built from the unrectified snapshot, nullptr when off */
+    std::unique_ptr<FrameUndistorter> m_undistorter;
+    /* depth resolution of the last frame, a change asks for a refresh (SDK callback thread only) */
+    uint32_t m_depth_width = 0;
+    uint32_t m_depth_height = 0;
     AS_SDK_CAM_MODEL_E m_cam_type = AS_SDK_CAM_MODEL_UNKNOWN;
     int m_cnt = 0; /* for kunlun a to save odd even */
     int m_depthindex = 0;
@@ -110,6 +183,15 @@ private:
     int m_peakindex = 0;
     int m_mjpegindex = 0;
     int m_yuyvindex = 0;
+    /* the background thread waits for refresh requests */
+    std::mutex m_thread_mutex;
+    std::condition_variable m_thread_cond;
     bool m_is_thread = false;
+    bool m_refresh_calibration = false;
     std::thread m_backgroundThread;
+    std::shared_ptr<FramePool> m_frame_pool;
+    std::shared_ptr<ImageWriter> m_writer;
+    size_t m_plane_capacity[AS_FRAME_TYPE_BUTT] = {0};
+    /* stream ring (10), plus queued and in flight frames of every pipeline sink */
+    static const size_t FRAME_POOL_SLOTS = 24;
 };
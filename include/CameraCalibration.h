@@ -0,0 +1,31 @@
+/**
+ * @file      CameraCalibration.h
+ * @brief     Immutable snapshot of a camera's intrinsics and IR to RGB extrinsics
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef CAMERA_CALIBRATION_H
+#define CAMERA_CALIBRATION_H
+
+#include <stdint.h>
+#include "as_camera_sdk_def.h"
+
+/*
+ * Fetched from the camera once when it opens, and again only when asked to
+ * or when the depth stream changes resolution. Every fetch is a new snapshot
+ * that is never modified after it is published, so frame consumers read it
+ * through a plain pointer without any lock (see Camera::getCalibration()).
+ */
+struct CameraCalibration {
+    uint32_t version;                   /* 1 for the first fetch, bumped on every refresh */
+    uint32_t width;                     /* depth stream the parameters belong to, 0 when unknown */
+    uint32_t height;
+    AS_CAM_Parameter_s parameter;
+};
+
+#endif // CAMERA_CALIBRATION_H
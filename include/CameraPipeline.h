@@ -0,0 +1,84 @@
+/**
+ * @file      CameraPipeline.h
+ * @brief     Per-camera worker threads fed from the SDK frame callback
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef CAMERA_PIPELINE_H
+#define CAMERA_PIPELINE_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FramePool.h"
+#include "FrameQueue.h"
+
+/*
+ * Every sink (display, saving, streaming, ...) runs on its own thread behind
+ * its own FrameQueue, so the SDK callback only copies the frame into a pooled
+ * slot and pushes a reference to each queue. A slow sink only loses frames
+ * itself, it never stalls the capture thread or the other sinks.
+ */
+class CameraPipeline
+{
+public:
+    struct SinkStats {
+        std::string name;
+        uint64_t processed;
+        uint64_t dropped;       /* overwritten in the queue before the sink took them */
+        size_t queued;          /* waiting in the queue now */
+        size_t depth;
+    };
+
+    typedef std::function<void(const FrameRef &frame)> Sink;
+
+    /* threaded false runs every sink inline in push(), for debugging */
+    CameraPipeline(const std::string &name, bool threaded = true);
+    ~CameraPipeline();
+
+    /**
+     * @brief     add a sink, only before start()
+     * @param[in]name : sink name, also the worker thread name
+     * @param[in]depth : frames the sink may fall behind before the oldest is dropped
+     * @param[in]sink : called on the worker thread for every frame it takes
+     */
+    void addSink(const std::string &name, size_t depth, const Sink &sink);
+
+    void start();
+    /* closes the queues, the workers finish what is queued and exit */
+    void stop();
+
+    /* called from the SDK callback, never blocks */
+    void push(const FrameRef &frame);
+
+    void logStats();
+    /* counters of every sink, safe to call from any thread while running */
+    void getSinkStats(std::vector<SinkStats> &stats);
+
+private:
+    struct Worker {
+        std::string name;
+        Sink sink;
+        std::unique_ptr<FrameQueue> queue;
+        std::thread thread;
+        std::atomic<uint64_t> processed;
+        const char *trace_name;     /* interned, outlives the worker in the trace rings */
+    };
+
+    void workerThread(Worker *worker);
+
+    std::string m_name;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    bool m_threaded;
+    bool m_running;
+};
+
+#endif // CAMERA_PIPELINE_H
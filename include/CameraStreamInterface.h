@@ -2,89 +2,185 @@
 #define CAMERA_STREAM_INTERFACE_H
 
 #include <memory>
-#include <mutex>
-#include <condition_variable>
 #include <atomic>
 #include <string>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
 
 struct StreamFrameData {
     // Frame metadata
     uint64_t timestamp;
     uint32_t frame_id;
-    uint32_t width;
+    uint32_t width;                 // depth plane, same as plane_width[0]
     uint32_t height;
-    
+
     // Data sizes
     uint32_t depth_size;
     uint32_t rgb_size;
     uint32_t ir_size;
-    
+
+    // Shape of each plane, indexed by CameraStreamInterface::Plane. Planes may
+    // differ in resolution; bytes_per_pixel is 0 when the plane is not a raw
+    // width x height pixel array (e.g. MJPEG) or its shape is unknown.
+    uint32_t plane_width[3];
+    uint32_t plane_height[3];
+    uint32_t plane_bytes_per_pixel[3];
+
     // Data pointers (will point to shared memory)
     uint8_t* depth_data;
     uint8_t* rgb_data;
     uint8_t* ir_data;
-    
+
     // Frame validity
     bool has_depth;
     bool has_rgb;
     bool has_ir;
+
+    // Slot and seqlock value the pointers were taken at, see isFrameValid()
+    uint32_t slot;
+    uint32_t sequence;
 };
 
+/*
+ * POSIX shared memory transport. The camera process creates the region with
+ * initialize() and publishes with updateFrame(), readers map it with attach().
+ *
+ * The region is a ring of SLOT_COUNT slots, each guarded by a sequence
+ * counter (seqlock): the writer makes it odd while it fills the slot and even
+ * again when done, so it never waits for readers, and a reader never blocks
+ * the writer, it only retries when the slot was rewritten under it.
+ *
+ * Planes are sized per camera. When a frame no longer fits, the writer grows
+ * the region and bumps the layout generation (odd while resizing); readers
+ * notice the new generation and remap before they read the next frame.
+ *
+ * Every initialize() unlinks the name and creates a new object, so readers
+ * still mapping the one of a previous run keep a valid (if stale) mapping.
+ * The writer clears the magic when it shuts down; readers re-attach when the
+ * magic is gone or, checked once a second, the name refers to another object.
+ */
 class CameraStreamInterface {
 public:
+    enum Plane {
+        PLANE_DEPTH = 0,
+        PLANE_RGB,
+        PLANE_IR,
+        PLANE_COUNT
+    };
+
     CameraStreamInterface();
     ~CameraStreamInterface();
-    
-    // Initialize the shared memory interface
-    bool initialize(const std::string& shared_memory_name = "angstrong_camera_stream");
-    
-    // Update frame data (called from camera callback)
+
+    // Initialize the shared memory interface (writer side, creates the region).
+    // plane_capacity holds the bytes reserved per Plane, nullptr or 0 sizes the
+    // plane on the first frame that carries it.
+    bool initialize(const std::string& shared_memory_name = "angstrong_camera_stream",
+                    const uint32_t* plane_capacity = nullptr);
+
+    // Map an existing region read only (reader side)
+    bool attach(const std::string& shared_memory_name = "angstrong_camera_stream");
+
+    // Update frame data (called from camera callback). width and height hold
+    // the resolution per Plane, 0 when unknown. timestamp is the capture time
+    // of the frame (AS_Frame_s::ts), readers get it back unchanged.
     void updateFrame(const void* depth_data, uint32_t depth_size,
                     const void* rgb_data, uint32_t rgb_size,
                     const void* ir_data, uint32_t ir_size,
-                    uint32_t width, uint32_t height);
-    
-    // Get latest frame (for Python interface)
+                    const uint32_t width[PLANE_COUNT], const uint32_t height[PLANE_COUNT],
+                    uint64_t timestamp);
+
+    // Get latest frame (for Python interface). The data pointers point into the
+    // slot, which the writer may reuse; check isFrameValid() after reading them.
     bool getLatestFrame(StreamFrameData& frame_data);
-    
+
+    // Block until a frame newer than frame_id is published (frame ids start at
+    // 1, pass 0 for any frame). timeout_ms < 0 waits forever. Returns false on
+    // timeout. Sleeps on a futex on frame_count, waking once a second to see
+    // whether the writer restarted; frame ids start over then.
+    bool waitForFrame(uint32_t frame_id, int timeout_ms);
+    bool isFrameValid(const StreamFrameData& frame_data) const;
+
+    // Copy one plane of the frame selected by the last getLatestFrame().
+    // Returns the bytes copied, or -1 when the slot was overwritten meanwhile.
+    int copyPlane(int plane, void* buffer, uint32_t buffer_size);
+
+    // Shape of one plane of the frame selected by the last getLatestFrame()
+    bool getPlaneInfo(int plane, uint32_t& width, uint32_t& height, uint32_t& bytes_per_pixel) const;
+
     // Status and control
     bool isActive() const { return active_; }
-    uint32_t getFrameCount() const { return frame_count_; }
-    
+    uint32_t getFrameCount() const;
+    uint32_t getPlaneCapacity(int plane) const;
+    uint32_t getGeneration() const { return generation_; }
+
     // Cleanup
     void shutdown();
 
 private:
+    struct SlotHeader {
+        std::atomic<uint32_t> sequence;     // odd while the writer fills the slot
+        uint32_t frame_id;
+        uint64_t timestamp;
+        uint32_t plane_size[PLANE_COUNT];
+        uint32_t plane_width[PLANE_COUNT];
+        uint32_t plane_height[PLANE_COUNT];
+        uint32_t plane_bytes_per_pixel[PLANE_COUNT]; // 0 when not width * height pixels
+    };
+
     struct SharedMemoryLayout {
-        // Header with metadata
-        volatile uint64_t timestamp;
-        volatile uint32_t frame_id;
-        volatile uint32_t width;
-        volatile uint32_t height;
-        volatile uint32_t depth_size;
-        volatile uint32_t rgb_size;
-        volatile uint32_t ir_size;
-        volatile bool has_new_frame;
-        volatile bool has_depth;
-        volatile bool has_rgb;
-        volatile bool has_ir;
-        
-        // Data follows after header
-        uint8_t data[0];  // Flexible array member
+        uint32_t magic;
+        uint32_t version;
+        std::atomic<uint32_t> generation;   // odd while the writer resizes the region
+        uint32_t slot_count;
+        uint64_t region_size;               // bytes to map, grows with the planes
+        uint32_t slot_stride;               // bytes from one slot header to the next
+        uint32_t plane_offset[PLANE_COUNT]; // plane start, relative to its slot header
+        uint32_t plane_capacity[PLANE_COUNT]; // bytes reserved per plane in a slot
+        std::atomic<uint32_t> frame_count;  // frames published so far, futex word readers wait on
+
+        // Slots follow after header
+    };
+
+    // Layout as of generation_, the region may only be used through these
+    struct LayoutView {
+        uint32_t slot_count;
+        uint32_t slot_stride;
+        uint32_t plane_offset[PLANE_COUNT];
+        uint32_t plane_capacity[PLANE_COUNT];
     };
-    
+
+    SlotHeader* slotAt(uint32_t index) const;
+    uint8_t* planeAt(uint32_t index, int plane) const;
+    bool mapRegion(size_t size, bool writable);
+    void buildLayout(const uint32_t plane_capacity[PLANE_COUNT]);
+    bool growRegion(const uint32_t plane_size[PLANE_COUNT]);
+    bool readLayout(uint32_t generation);
+    bool remap();
+    bool reattachIfReplaced();
+
     void* shared_memory_;
     SharedMemoryLayout* layout_;
     size_t shared_memory_size_;
     std::string shared_memory_name_;
     int shared_memory_fd_;
-    
-    std::mutex frame_mutex_;
+    // reader side: the object mapped, and when the name was last checked against it
+    dev_t shared_memory_dev_;
+    ino_t shared_memory_ino_;
+    struct timespec replaced_check_;
+    bool owner_;
+    LayoutView view_;
+    uint32_t generation_;
+
     std::atomic<bool> active_;
-    std::atomic<uint32_t> frame_count_;
-    
-    static const size_t MAX_FRAME_SIZE = 640 * 480 * 4; // Max size per channel
-    static const size_t SHARED_MEMORY_SIZE = sizeof(SharedMemoryLayout) + (MAX_FRAME_SIZE * 3); // depth + rgb + ir
+
+    // reader side: frame picked by the last getLatestFrame()
+    StreamFrameData current_;
+    bool has_current_;
+
+    static const uint32_t MAGIC = 0x41534d53; // "ASMS"
+    static const uint32_t VERSION = 3;
+    static const uint32_t SLOT_COUNT = 4;
 };
 
 // C interface for easier Python integration
@@ -92,18 +188,21 @@ extern "C" {
     // Create/destroy interface
     void* camera_stream_create();
     void camera_stream_destroy(void* interface);
-    
-    // Initialize
+
+    // Initialize (writer) or attach to an existing region (reader)
     int camera_stream_initialize(void* interface, const char* shared_memory_name);
-    
-    // Update frame (called from camera callback)
+    int camera_stream_attach(void* interface, const char* shared_memory_name);
+
+    // Update frame (called from camera callback), stamped with the time of the
+    // call in microseconds since the epoch. width and height are the depth
+    // resolution, the RGB and IR planes are published without a shape.
     int camera_stream_update_frame(void* interface,
                                   const void* depth_data, uint32_t depth_size,
                                   const void* rgb_data, uint32_t rgb_size,
                                   const void* ir_data, uint32_t ir_size,
                                   uint32_t width, uint32_t height);
-    
-    // Get frame info for Python
+
+    // Select the newest frame and get its info, -1 if nothing was published yet
     int camera_stream_get_frame_info(void* interface,
                                     uint64_t* timestamp,
                                     uint32_t* frame_id,
@@ -112,16 +211,31 @@ extern "C" {
                                     uint32_t* depth_size,
                                     uint32_t* rgb_size,
                                     uint32_t* ir_size);
-    
-    // Get frame data
+
+    // Shape of a plane (0 depth, 1 rgb, 2 ir) of the selected frame;
+    // bytes_per_pixel is 0 when the plane is not raw pixels. -1 without a frame
+    int camera_stream_get_plane_info(void* interface, int plane,
+                                     uint32_t* width, uint32_t* height, uint32_t* bytes_per_pixel);
+
+    // Copy a plane of the selected frame, returns bytes copied or -1 when the
+    // writer has overwritten it (call camera_stream_get_frame_info again)
     int camera_stream_get_depth_data(void* interface, void* buffer, uint32_t buffer_size);
     int camera_stream_get_rgb_data(void* interface, void* buffer, uint32_t buffer_size);
     int camera_stream_get_ir_data(void* interface, void* buffer, uint32_t buffer_size);
-    
+
+    // Wait for a frame newer than frame_id: 0 when one is there, 1 on
+    // timeout, -1 when not attached. timeout_ms < 0 waits forever.
+    int camera_stream_wait_frame(void* interface, uint32_t frame_id, int timeout_ms);
+
     // Status
     int camera_stream_is_active(void* interface);
     uint32_t camera_stream_get_frame_count(void* interface);
-    
+
+    // Bytes reserved for a plane (0 depth, 1 rgb, 2 ir) and the layout
+    // generation they belong to; size read buffers from these
+    uint32_t camera_stream_get_plane_capacity(void* interface, int plane);
+    uint32_t camera_stream_get_generation(void* interface);
+
     // Shutdown
     void camera_stream_shutdown(void* interface);
 }
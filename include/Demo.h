@@ -25,6 +25,21 @@
 #include "CameraSrv.h"
 #include "Camera.h"
 #include "PythonStreamServer.h"
+#include "CameraStreamInterface.h"
+#include "ZoneDangerDetector.h"
+#include "TtcEstimator.h"
+#include "AlertPublisher.h"
+#include "CameraPipeline.h"
+#include "Recorder.h"
+#include "SessionReplay.h"
+#include "SyntheticCamera.h"
+#include "LatencyTracer.h"
+#include "Metrics.h"
+#include "EventTracer.h"
+#include "PointCloud.h"
+#include "DepthRegistration.h"
+#include "GroundPlane.h"
+#include "OccupancyGrid.h"
 
 class Demo : public ICameraStatus
 {
@@ -41,6 +56,16 @@ public:
     void logFps(bool enable);
     bool getLogFps();
     void logCfgParameter();
+    void record(bool enable);
+    bool getRecordStatus();
+    /* next frame of a stepped replay */
+    void step();
+    /* per-stage latency percentiles of every camera */
+    void logLatency();
+    /* timeline of every thread as Chrome trace JSON */
+    void dumpTrace();
+    /* read every camera's parameters again */
+    void refreshCalibration();
 
 private:
     virtual int onCameraAttached(AS_CAM_PTR pCamera, const AS_SDK_CAM_MODEL_E &cam_type) override;
@@ -56,12 +81,96 @@ private:
     bool virtualMachine();
 #endif
 
+    struct ZoneState;
+    void createPipeline(AS_CAM_PTR pCamera, const std::shared_ptr<Camera> &camera);
+    void processZones(ZoneState &zone, const std::string &serialno, ZoneDangerResult &result);
+    void collectMetrics(Metrics::Writer &out);
+    static void collectCameraMetrics(Metrics::Writer &out, const std::string &serialno, Camera &camera,
+                                     CameraPipeline &pipeline, Recorder &recorder);
+    void removeCameraMetrics(AS_CAM_PTR pCamera);
+
 private:
     CameraSrv *server = nullptr;
+    /* replaces the server when ASCAMERA_REPLAY names recorded sessions */
+    std::unique_ptr<SessionReplay> m_replay;
+    /* or by generated cameras when ASCAMERA_SYNTHETIC is set */
+    std::unique_ptr<SyntheticCameras> m_synthetic;
     /* log the average frame rate */
     bool m_logfps = false;
     std::unordered_map<AS_CAM_PTR, std::shared_ptr<Camera>> m_camera_map;
     
+    /* rectify depth, IR and RGB as frames arrive */
+    bool m_undistort = false;
+    
     /* Python streaming server */
     std::unique_ptr<PythonStreamServer> m_python_server;
+    /* send the projected depth after every frame while clients are connected */
+    bool m_stream_pointcloud = false;
+    /* depth/RGB registration streamed after every frame, 0 when off */
+    int m_register_mode = 0;
+    size_t m_register_threads = 4;
+
+    /* shared memory sinks, one region per camera when ASCAMERA_SHM is set */
+    bool m_shm_enable = false;
+    std::string m_shm_name;
+    std::unordered_map<AS_CAM_PTR, std::shared_ptr<CameraStreamInterface>> m_shm_map;
+
+    /* per-camera left/center/right obstacle detection on the depth plane */
+    struct ZoneState {
+        ZoneDangerDetector detector;
+        TtcEstimator ttc;
+        ZoneDangerResult last;
+        AlertPublisher::Channel alert;
+        /* the depth without the floor, when the ground plane is tracked */
+        GroundMask ground;
+        std::vector<uint16_t> above_ground;
+        /* obstacles kept in robot coordinates, the zones query it instead of the pixels */
+        std::unique_ptr<OccupancyGrid> grid;
+        ZoneState(uint16_t center_threshold, uint16_t side_threshold, double ticks_per_second, float warn_ttc)
+            : detector(center_threshold, side_threshold), ttc(ticks_per_second, warn_ttc), last(), alert() {}
+    };
+    bool m_zone_enable = true;
+    uint16_t m_zone_center_threshold = ZoneDangerDetector::DEFAULT_CENTER_THRESHOLD;
+    uint16_t m_zone_side_threshold = ZoneDangerDetector::DEFAULT_SIDE_THRESHOLD;
+    /* unit of AS_Frame_s::ts, and the TTC in s that raises a warning */
+    double m_ts_per_second = 1000.0;
+    float m_ttc_warn = 4.0f;
+    std::unordered_map<AS_CAM_PTR, std::shared_ptr<ZoneState>> m_zone_map;
+    /* track the floor, drop it from the zones and stream what stands above it */
+    bool m_ground = false;
+    uint16_t m_ground_height = 50;
+    uint16_t m_ground_tolerance = GroundPlaneEstimator::DEFAULT_TOLERANCE;
+    /* zones from a voxel grid fed with every frame, mounted where the floor is or at a fixed height and pitch */
+    bool m_occupancy = false;
+    OccupancyGridConfig m_occupancy_config = {};
+    float m_mount_height = 900.0f;
+    float m_mount_pitch = 0.0f;
+    uint32_t m_next_camera_id = 0;
+
+    /* compact zone/TTC event stream, open when ASCAMERA_ALERT is set */
+    AlertPublisher m_alerts;
+
+    /* saves images for every camera off the frame path */
+    std::shared_ptr<ImageWriter> m_image_writer;
+
+    /* per-camera sink threads, the SDK callback only copies and enqueues */
+    bool m_pipeline_threads = true;
+    size_t m_queue_depth = 2;
+    std::unordered_map<AS_CAM_PTR, std::shared_ptr<CameraPipeline>> m_pipeline_map;
+
+    /* continuous recording of every plane, one session file set per camera */
+    bool m_record = false;
+    std::string m_record_dir;
+    size_t m_record_chunk_bytes = 16 << 20;
+    size_t m_record_chunks = 4;
+    uint64_t m_record_file_bytes = 1ULL << 30;
+    std::unordered_map<AS_CAM_PTR, std::shared_ptr<Recorder>> m_recorder_map;
+
+    /* where dumpTrace() writes when ASCAMERA_TRACE is set */
+    std::string m_trace_file;
+
+    /* Prometheus scrape endpoint, open when ASCAMERA_METRICS is set */
+    MetricsServer m_metrics_server;
+    uint32_t m_metrics_id = 0;
+    std::unordered_map<AS_CAM_PTR, uint32_t> m_metrics_map;
 };
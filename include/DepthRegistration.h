@@ -0,0 +1,143 @@
+/**
+ * @file      DepthRegistration.h
+ * @brief     Aligns depth and RGB of one camera through the IR to RGB extrinsics
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef DEPTH_REGISTRATION_H
+#define DEPTH_REGISTRATION_H
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "as_camera_sdk_def.h"
+#include "CameraCalibration.h"
+#include "PointCloud.h"
+#include "RecyclePool.h"
+
+/* depth and colour of one frame on a common pixel grid */
+struct RegisteredFrame {
+    uint64_t timestamp;             /* of the depth frame */
+    uint32_t frame_id;
+    /* depth in mm seen from the RGB camera at RGB resolution, 0 where nothing projects */
+    uint32_t depth_width;
+    uint32_t depth_height;
+    std::vector<uint16_t> depth;
+    /* BGR of every depth pixel at depth resolution, black where the RGB camera does not see it */
+    uint32_t rgb_width;
+    uint32_t rgb_height;
+    std::vector<uint8_t> rgb;
+};
+
+/*
+ * Every depth pixel is moved into the RGB camera, X' = R (d ray) + T, and
+ * projected with the RGB intrinsics and distortion. R ray is kept per pixel
+ * next to the ray table of PointCloudProjector, so a pixel costs three
+ * multiply-adds and one divide. Several depth pixels may land on one RGB
+ * pixel, the nearest wins (z-buffer), which also hides background the RGB
+ * camera cannot see. The depth rows are split into bands processed on
+ * worker threads: each band sorts its splats by output band, then every
+ * output band is merged by one thread, so no two threads write a pixel.
+ * T is in mm like the depth.
+ */
+class DepthRegistration
+{
+public:
+    enum Mode {
+        /* depth warped into the RGB image (RegisteredFrame::depth) */
+        DEPTH_TO_RGB = 1,
+        /* colour sampled for every depth pixel (RegisteredFrame::rgb) */
+        RGB_TO_DEPTH = 2,
+        BOTH = DEPTH_TO_RGB | RGB_TO_DEPTH,
+    };
+    /* "depth", "rgb" or "both", false for anything else */
+    static bool parseMode(const std::string &name, Mode &mode);
+
+    /* threads including the caller's, 1 registers on the calling thread only */
+    DepthRegistration(Mode mode, size_t threads);
+    ~DepthRegistration();
+
+    /**
+     * @brief     register the depth and RGB planes of a frame
+     * @param[in]data : frame with a 16 bit depth plane and, for RGB_TO_DEPTH, a BGR24 RGB plane
+     * @param[in]calibration : intrinsics and extrinsics of the camera the frame came from
+     * @param[out]frame : resized to the frame
+     * @return    false when a plane is missing or the calibration has no intrinsics
+     */
+    bool process(const AS_SDK_Data_s &data, const CameraCalibration &calibration, RegisteredFrame &frame);
+
+    /* the same into a pooled frame no one else holds any more, nullptr on failure */
+    std::shared_ptr<const RegisteredFrame> process(const AS_SDK_Data_s &data, const CameraCalibration &calibration);
+
+private:
+    /* one z-buffer write, a run of count pixels from index on */
+    struct Splat {
+        uint32_t index;
+        uint16_t z;
+        uint16_t count;
+    };
+
+    bool prepare(const CameraCalibration &calibration, uint32_t depth_width, uint32_t depth_height,
+                 uint32_t rgb_width, uint32_t rgb_height);
+    void splatBand(size_t band, const uint16_t *depth);
+    void mergeBand(size_t band, RegisteredFrame &frame);
+    void sampleBand(size_t band, const uint8_t *bgr, RegisteredFrame &frame);
+    /* job(band) for every band, band 0 on the calling thread */
+    void runBands(const std::function<void(size_t band)> &job);
+    void workerThread(size_t band);
+
+    Mode m_mode;
+    size_t m_bands;
+
+    /* tables of the calibration version and resolutions below */
+    uint32_t m_version;
+    uint32_t m_depth_width;
+    uint32_t m_depth_height;
+    uint32_t m_rgb_width;
+    uint32_t m_rgb_height;
+    PointCloudProjector m_projector;
+    /* R (ray x, ray y, 1) per depth pixel */
+    std::vector<float> m_rotated_x;
+    std::vector<float> m_rotated_y;
+    std::vector<float> m_rotated_z;
+    /* RGB intrinsics scaled to the RGB plane, distortion and T */
+    float m_fx, m_fy, m_cx, m_cy;
+    float m_k1, m_k2, m_k3, m_p1, m_p2;
+    bool m_distorted;
+    float m_t[3];
+    /* splat footprint, RGB pixels per depth pixel rounded up */
+    uint16_t m_footprint_x;
+    uint16_t m_footprint_y;
+
+    /* m_splats[input band][output band] */
+    std::vector<std::vector<std::vector<Splat>>> m_splats;
+    /* where each depth pixel landed, for the occlusion test of RGB_TO_DEPTH, -1 for nowhere */
+    std::vector<int32_t> m_target;
+    std::vector<uint16_t> m_target_z;
+    /* depth in the RGB frame when the caller did not ask for it */
+    std::vector<uint16_t> m_zbuffer;
+
+    RecyclePool<RegisteredFrame> m_pool;
+
+    /* band workers, woken once per job */
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_start_cond;
+    std::condition_variable m_done_cond;
+    const std::function<void(size_t band)> *m_job;
+    uint64_t m_generation;
+    size_t m_pending;
+    bool m_stopping;
+};
+
+#endif // DEPTH_REGISTRATION_H
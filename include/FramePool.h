@@ -0,0 +1,203 @@
+/**
+ * @file      FramePool.h
+ * @brief     Fixed capacity pool of refcounted frame buffers
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include "as_camera_sdk_def.h"
+
+class FramePool;
+class FrameQueue;
+
+/* the plane of an SDK frame that carries an AS_FRAME_Type_e, shared by the pool, the recorder and the replay */
+inline AS_Frame_s &framePlane(AS_SDK_Data_s &data, int type)
+{
+    switch (type) {
+    case AS_FRAME_TYPE_DEPTH:
+        return data.depthImg;
+    case AS_FRAME_TYPE_RGB:
+        return data.rgbImg;
+    case AS_FRAME_TYPE_IR:
+        return data.irImg;
+    case AS_FRMAE_TYPE_POINTCLOUD:
+        return data.pointCloud;
+    case AS_FRAME_TYPE_YUYV:
+        return data.yuyvImg;
+    case AS_FRAME_TYPE_PEAK:
+        return data.peakImg;
+    default:
+        return data.mjpegImg;
+    }
+}
+
+inline const AS_Frame_s &framePlane(const AS_SDK_Data_s &data, int type)
+{
+    return framePlane(const_cast<AS_SDK_Data_s &>(data), type);
+}
+
+/* where and when a frame entered the process, for latency tracing */
+struct FrameTrace {
+    uint32_t camera;
+    uint64_t arrival_ns;        /* steady clock at the SDK callback, 0 when not traced */
+    uint64_t enqueue_ns;        /* steady clock when the copy was handed to the sinks */
+};
+
+/* writes a plane into a slot in place of the plain copy, e.g. rectified (see FrameUndistorter) */
+class PlaneFilter
+{
+public:
+    virtual ~PlaneFilter() = default;
+    /**
+     * @brief     fill dst from an SDK plane of the same size
+     * @param[in]type : AS_FRAME_Type_e of the plane
+     * @param[in]src : the SDK plane
+     * @param[out]dst : src.size bytes of the slot
+     * @return    false to have the plane copied unchanged
+     */
+    virtual bool filter(int type, const AS_Frame_s &src, void *dst) = 0;
+};
+
+/*
+ * One recycled slot of a FramePool. It holds a private copy of every image
+ * plane of an SDK frame and exposes it as an AS_SDK_Data_s whose plane
+ * pointers point into the slot, so existing consumers can read it unchanged.
+ */
+class FrameBuffer
+{
+public:
+    const AS_SDK_Data_s *data() const
+    {
+        return &m_data;
+    }
+    /* sequence assigned by the pool when the slot was filled */
+    uint64_t sequence() const
+    {
+        return m_sequence;
+    }
+    const FrameTrace &trace() const
+    {
+        return m_trace;
+    }
+
+private:
+    friend class FramePool;
+    friend class FrameRef;
+
+    FrameBuffer();
+    FrameBuffer(const FrameBuffer &) = delete;
+    FrameBuffer &operator = (const FrameBuffer &) = delete;
+
+    struct Plane {
+        std::unique_ptr<uint8_t[]> buffer;
+        size_t capacity;
+    };
+
+    std::atomic<int> m_refs;
+    /* keeps the pool alive while the slot is referenced, empty when free */
+    std::shared_ptr<FramePool> m_owner;
+    uint64_t m_sequence;
+    FrameTrace m_trace;
+    AS_SDK_Data_s m_data;
+    Plane m_planes[AS_FRAME_TYPE_BUTT];
+};
+
+/* intrusive reference to a FrameBuffer, the slot returns to its pool with the last reference */
+class FrameRef
+{
+public:
+    FrameRef() : m_buffer(nullptr) {}
+    FrameRef(const FrameRef &other);
+    FrameRef(FrameRef &&other);
+    ~FrameRef();
+
+    FrameRef &operator = (const FrameRef &other);
+    FrameRef &operator = (FrameRef &&other);
+
+    void reset();
+    const FrameBuffer *get() const
+    {
+        return m_buffer;
+    }
+    const AS_SDK_Data_s *data() const
+    {
+        return m_buffer ? m_buffer->data() : nullptr;
+    }
+    explicit operator bool() const
+    {
+        return m_buffer != nullptr;
+    }
+    /* only by the producer, before the frame is shared */
+    void setTrace(const FrameTrace &trace)
+    {
+        if (m_buffer != nullptr) {
+            m_buffer->m_trace = trace;
+        }
+    }
+
+private:
+    friend class FramePool;
+    friend class FrameQueue;
+    explicit FrameRef(FrameBuffer *buffer) : m_buffer(buffer) {}
+
+    FrameBuffer *m_buffer;
+};
+
+class FramePool : public std::enable_shared_from_this<FramePool>
+{
+public:
+    /**
+     * @brief     create a pool
+     * @param[in]slots : number of frame slots
+     * @param[in]capacity : initial bytes reserved per plane, indexed by AS_FRAME_Type_e
+     * @return    the pool
+     */
+    static std::shared_ptr<FramePool> create(size_t slots, const size_t capacity[AS_FRAME_TYPE_BUTT]);
+
+    /**
+     * @brief     copy an SDK frame into a free slot
+     * @param[in]pstData : the SDK frame, only valid during the stream callback
+     * @param[in]filter : writes the planes it handles instead of the copy, may be nullptr
+     * @return    reference to the filled slot, empty when every slot is in use
+     */
+    FrameRef acquire(const AS_SDK_Data_s *pstData, PlaneFilter *filter = nullptr);
+
+    size_t slotCount() const
+    {
+        return m_slots.size();
+    }
+    /* frames that could not be copied because every slot was referenced */
+    uint64_t exhaustedCount() const
+    {
+        return m_exhausted;
+    }
+
+private:
+    friend class FrameRef;
+
+    FramePool() : m_sequence(0), m_exhausted(0) {}
+    FramePool(const FramePool &) = delete;
+    FramePool &operator = (const FramePool &) = delete;
+
+    static void recycle(FrameBuffer *buffer);
+
+    std::vector<std::unique_ptr<FrameBuffer>> m_slots;
+    std::mutex m_free_mutex;
+    std::vector<FrameBuffer *> m_free;
+    uint64_t m_sequence;
+    std::atomic<uint64_t> m_exhausted;
+};
+
+#endif // FRAME_POOL_H
@@ -0,0 +1,86 @@
+/**
+ * @file      FrameQueue.h
+ * @brief     Bounded lock-free single producer/single consumer frame queue
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include "FramePool.h"
+
+/*
+ * Hands pooled frames from the SDK callback (the only producer) to one worker
+ * thread (the only consumer). Latest wins: push() never blocks, when the
+ * consumer is behind it overwrites the oldest unread frame. Every slot is an
+ * atomic pointer swapped in and out, so neither side ever takes a lock; the
+ * consumer sleeps on a futex only when the queue is empty.
+ */
+class FrameQueue
+{
+public:
+    /* capacity is rounded up to a power of two */
+    explicit FrameQueue(size_t capacity);
+    ~FrameQueue();
+
+    /* producer side, false when an unread frame had to be dropped */
+    bool push(const FrameRef &frame);
+
+    /* consumer side, waits up to timeout_ms (< 0 forever), false on timeout or after close() */
+    bool pop(FrameRef &frame, int timeout_ms);
+
+    /* wakes the consumer, pop() fails from now on once the queue is drained */
+    void close();
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+    /* unread frames, a snapshot for monitoring */
+    size_t size() const
+    {
+        uint64_t pending = m_tail.load(std::memory_order_relaxed) - m_consumed.load(std::memory_order_relaxed);
+        return (pending > capacity()) ? capacity() : pending;
+    }
+    /* frames overwritten before the consumer got to them */
+    uint64_t droppedCount() const
+    {
+        return m_dropped;
+    }
+
+private:
+    FrameQueue(const FrameQueue &) = delete;
+    FrameQueue &operator = (const FrameQueue &) = delete;
+
+    bool tryPop(FrameRef &frame);
+    void wake();
+
+    std::unique_ptr<std::atomic<FrameBuffer *>[]> m_slots;
+    size_t m_mask;
+
+    /* producer */
+    std::atomic<uint64_t> m_tail;
+    char m_pad0[64];
+
+    /* consumer only */
+    uint64_t m_head;
+    uint64_t m_last_sequence;
+    bool m_has_last;
+    std::atomic<uint64_t> m_consumed;   /* m_head, published for size() */
+    char m_pad1[64];
+
+    std::atomic<uint32_t> m_signal;     /* futex word, bumped on every push */
+    std::atomic<bool> m_waiting;
+    std::atomic<bool> m_closed;
+    std::atomic<uint64_t> m_dropped;
+};
+
+#endif // FRAME_QUEUE_H
@@ -0,0 +1,119 @@
+/**
+ * @file      GroundPlane.h
+ * @brief     Floor plane fitted to the depth by RANSAC, and the pixels above it
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef GROUND_PLANE_H
+#define GROUND_PLANE_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include "as_camera_sdk_def.h"
+#include "CameraCalibration.h"
+#include "PointCloud.h"
+#include "RecyclePool.h"
+
+/* n . p + offset = height of the point p (camera frame, mm) above the floor */
+struct GroundPlane {
+    bool valid;
+    float normal[3];            /* unit, pointing from the floor towards the camera */
+    float offset;               /* mm, the camera's height above the floor */
+    float inlier_ratio;         /* of the sampled points on the last frame */
+    uint32_t fits;              /* RANSAC runs so far */
+};
+
+/*
+ * Samples a grid of a few thousand depth pixels, back-projects them
+ * through the ray table and checks how many still lie on the current plane.
+ * Only when that share drops well below what it was at the last fit is the
+ * plane fitted again: random point triples whose normal is within the tilt
+ * limit of the camera's down axis, the one with the most inliers refined by
+ * least squares and blended into the previous plane unless it jumped. A
+ * jump needs about the support the floor had when it was found, anything
+ * less is taken for an obstacle hiding the floor. A frame costs a grid
+ * pass, a refit about 100 of them.
+ */
+class GroundPlaneEstimator
+{
+public:
+    static const uint16_t DEFAULT_TOLERANCE = 30;   /* mm off the plane that still counts as floor */
+
+    explicit GroundPlaneEstimator(uint16_t tolerance = DEFAULT_TOLERANCE);
+
+    /**
+     * @brief     track the floor in one more depth frame, on one thread only
+     * @param[in]depth : 16 bit depth image in mm
+     * @param[in]calibration : intrinsics of the camera the frame came from
+     * @return    true when the frame was refitted
+     */
+    bool update(const AS_Frame_s &depth, const CameraCalibration &calibration);
+
+    /* latest plane, safe to call from any thread */
+    GroundPlane plane();
+
+private:
+    struct Point {
+        float x;
+        float y;
+        float z;
+    };
+
+    size_t countInliers(const float normal[3], float offset) const;
+    bool fit(GroundPlane &plane, float &ratio);
+    uint32_t random();
+
+    float m_tolerance;
+    PointCloudProjector m_projector;
+    std::vector<Point> m_points;
+    uint32_t m_seed;
+    /* inlier ratio right after the last fit */
+    float m_fit_ratio;
+    /* inlier ratio when the floor was found, a different plane needs about as much */
+    float m_floor_ratio;
+    /* refits in a row that found no floor */
+    uint32_t m_unsupported;
+    GroundPlane m_plane;
+
+    std::mutex m_plane_mutex;
+    GroundPlane m_latest;
+};
+
+/* per depth pixel 255 when it lies more than the height above the floor, else 0 */
+struct GroundMaskFrame {
+    uint64_t timestamp;             /* of the depth frame */
+    uint32_t frame_id;
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> mask;
+};
+
+/* applies a plane to whole depth frames, one per consuming thread */
+class GroundMask
+{
+public:
+    GroundMask();
+
+    /* 0 for pixels without depth or at most height mm above the plane, false when the plane or frame is unusable */
+    bool build(const AS_Frame_s &depth, const CameraCalibration &calibration, const GroundPlane &plane, float height,
+               GroundMaskFrame &mask);
+    /* the same into a pooled frame no one else holds any more, nullptr on failure */
+    std::shared_ptr<const GroundMaskFrame> build(const AS_Frame_s &depth, const CameraCalibration &calibration,
+                                                 const GroundPlane &plane, float height);
+    /* the depth with those pixels set to 0, for detectors that skip zero depth */
+    bool removeGround(const AS_Frame_s &depth, const CameraCalibration &calibration, const GroundPlane &plane,
+                      float height, std::vector<uint16_t> &out);
+
+private:
+    PointCloudProjector m_projector;
+    RecyclePool<GroundMaskFrame> m_pool;
+};
+
+#endif // GROUND_PLANE_H
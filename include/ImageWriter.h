@@ -0,0 +1,115 @@
+/**
+ * @file      ImageWriter.h
+ * @brief     Background image writer with a bounded queue and batched fsync
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "FramePool.h"
+
+/*
+ * Saves images off the frame path. Requests go into a fixed ring of jobs and
+ * return at once; when the ring is full the request is dropped and counted,
+ * it never waits for the disk. Pooled frames are written straight from their
+ * slot, other data is copied into the job's buffer, which is kept and reused.
+ * Files are synced in batches by the writer thread, a file counts as
+ * completed once it is on disk.
+ */
+class ImageWriter
+{
+public:
+    ImageWriter(size_t depth = 16, size_t sync_batch = 8);
+    ~ImageWriter();
+
+    void start();
+    /* writes what is queued, syncs and joins the thread */
+    void stop();
+
+    /**
+     * @brief     queue a raw image
+     * @param[in]path : file name, relative to the working directory
+     * @param[in]frame : pooled frame that owns data, kept until written; empty to copy data
+     * @param[in]data : image bytes
+     * @param[in]size : bytes to write
+     * @return    false when the queue is full and the image was dropped
+     */
+    bool writeRaw(const std::string &path, const FrameRef &frame, const void *data, size_t size);
+
+    /* same for a point cloud of x,y,z floats, written in PCD format */
+    bool writePointCloud(const std::string &path, const FrameRef &frame, const float *points, size_t length);
+
+    uint64_t completedCount() const
+    {
+        return m_completed;
+    }
+    uint64_t failedCount() const
+    {
+        return m_failed;
+    }
+    uint64_t droppedCount() const
+    {
+        return m_dropped;
+    }
+    /* images queued and not written yet */
+    size_t backlog();
+    void logStats();
+
+private:
+    enum JobType {
+        JOB_RAW,
+        JOB_POINT_CLOUD,
+    };
+
+    struct Job {
+        JobType type;
+        std::string path;
+        FrameRef frame;
+        const void *data;
+        size_t size;
+        /* owned copy when no frame keeps data alive, capacity is reused */
+        std::vector<uint8_t> buffer;
+    };
+
+    struct PendingSync {
+        int fd;
+        std::string path;
+    };
+
+    bool enqueue(JobType type, const std::string &path, const FrameRef &frame, const void *data, size_t size);
+    void writerThread();
+    bool process(Job &job);
+    void syncPending();
+
+    std::vector<Job> m_jobs;
+    size_t m_head;
+    size_t m_count;
+    size_t m_sync_batch;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+    bool m_running;
+
+    /* writer thread only */
+    std::vector<PendingSync> m_pending;
+    std::string m_cwd;
+
+    std::atomic<uint64_t> m_completed;
+    std::atomic<uint64_t> m_failed;
+    std::atomic<uint64_t> m_dropped;
+};
+
+#endif // IMAGE_WRITER_H
@@ -0,0 +1,65 @@
+/**
+ * @file      LatencyTracer.h
+ * @brief     Per-stage frame latency histograms, from capture to client delivery
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef LATENCY_TRACER_H
+#define LATENCY_TRACER_H
+
+#include <string>
+#include <stdint.h>
+#include "FramePool.h"
+
+/*
+ * Latencies are recorded into log-linear (HDR style, 16 sub-buckets per
+ * power of two, about 6% resolution) histograms of nanoseconds. Each thread
+ * writes its own histograms without locks or read-modify-write atomics; a
+ * report sums them. A frame carries its camera and the steady clock time of
+ * its callback entry (FrameTrace), every later stage is measured from there.
+ */
+class LatencyTracer
+{
+public:
+    enum Stage {
+        STAGE_CAPTURE,      /* SDK capture timestamp to callback entry */
+        STAGE_ENQUEUE,      /* callback entry to the pooled copy handed to the sinks */
+        STAGE_PROCESSED,    /* callback entry to the zone decision */
+        STAGE_FIRST_BYTE,   /* callback entry to the first byte sent to a stream client */
+        STAGE_LAST_BYTE,    /* callback entry to the last byte sent to a stream client */
+        STAGE_COUNT
+    };
+
+    static const uint32_t MAX_CAMERAS = 8;
+    static const uint32_t NO_CAMERA = UINT32_MAX;
+
+    static void setEnabled(bool enable);
+    static bool enabled();
+    /**
+     * @brief     how to read AS_Frame_s::ts for STAGE_CAPTURE
+     * @param[in]ticks_per_second : unit of the timestamp
+     * @param[in]system_clock : the SDK stamps wall clock time, otherwise the steady clock
+     */
+    static void setCaptureClock(double ticks_per_second, bool system_clock);
+
+    /* steady clock in ns */
+    static uint64_t now();
+    /* id of a camera's histograms, NO_CAMERA once MAX_CAMERAS are in use */
+    static uint32_t registerCamera(const std::string &serial);
+
+    static void record(uint32_t camera, Stage stage, uint64_t latency_ns);
+    /* STAGE_CAPTURE of a frame arriving now */
+    static void recordCapture(uint32_t camera, uint64_t ts);
+    /* a stage of a traced frame, measured from its callback entry until now */
+    static void recordFrame(const FrameBuffer *frame, Stage stage);
+
+    /* count, p50, p99, p999 and max per camera and stage, in us */
+    static std::string report();
+};
+
+#endif // LATENCY_TRACER_H
@@ -0,0 +1,108 @@
+/**
+ * @file      Metrics.h
+ * @brief     Counters and gauges of every camera, served as Prometheus text
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * The components keep their own counters (atomics bumped on the frame path,
+ * read with their xxxCount() accessors), nothing is pushed anywhere. A scrape
+ * calls every registered collector, which reads those counters and adds one
+ * sample per series, so the cost of the metrics is paid by the scraper.
+ */
+class Metrics
+{
+public:
+    enum Type {
+        COUNTER,
+        GAUGE,
+    };
+
+    /* samples of one scrape, grouped by metric name */
+    class Writer
+    {
+    public:
+        /**
+         * @param[in]name : metric name, e.g. ascamera_frames_received_total
+         * @param[in]type : counter or gauge, the first sample of a name sets it
+         * @param[in]help : description, the first sample of a name sets it
+         * @param[in]labels : from label(), joined by ',', empty for none
+         */
+        void add(const char *name, Type type, const char *help, const std::string &labels, double value);
+        std::string text() const;
+
+    private:
+        struct Family {
+            Type type;
+            std::string help;
+            std::string samples;
+        };
+        std::vector<std::string> m_order;
+        std::map<std::string, Family> m_families;
+    };
+
+    typedef std::function<void(Writer &out)> Collector;
+
+    /* a collector runs on the scraping thread, it must not add or remove collectors */
+    static uint32_t addCollector(const Collector &collector);
+    /* waits for a scrape in progress, the collector is never called afterwards */
+    static void removeCollector(uint32_t id);
+
+    /* one scrape in the Prometheus text format */
+    static std::string render();
+
+    /* key="value" with the value escaped */
+    static std::string label(const char *key, const std::string &value);
+};
+
+/*
+ * Answers every HTTP GET of /metrics (or /) with Metrics::render(), one
+ * connection at a time on its own thread. Scrapes are seconds apart, so the
+ * server has no need for keep-alive or concurrency.
+ */
+class MetricsServer
+{
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    /**
+     * @brief     listen for scrapes
+     * @param[in]address : http://host:port (host defaults to 127.0.0.1) or unix:///path/to/socket
+     * @return    false when the socket could not be bound
+     */
+    bool start(const std::string &address);
+    void stop();
+
+private:
+    MetricsServer(const MetricsServer &) = delete;
+    MetricsServer &operator = (const MetricsServer &) = delete;
+
+    void serverThread();
+    void serve(int client);
+
+    int m_socket;
+    int m_event_fd;                 /* signalled by stop */
+    std::string m_unix_path;        /* unlinked again on stop */
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,96 @@
+/**
+ * @file      OccupancyGrid.h
+ * @brief     Voxel occupancy grid in robot coordinates with log-odds and time decay
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+
+#include <vector>
+#include <stdint.h>
+#include "as_camera_sdk_def.h"
+#include "CameraCalibration.h"
+#include "GroundPlane.h"
+#include "PointCloud.h"
+#include "ZoneDangerDetector.h"
+
+/* size of the grid, fixed for its lifetime */
+struct OccupancyGridConfig {
+    uint16_t voxel;         /* mm edge of a voxel */
+    uint16_t range;         /* mm ahead of the robot, and to each side */
+    uint16_t min_height;    /* mm above the floor, lower points are floor */
+    uint16_t max_height;    /* mm above the floor, higher points pass over the robot */
+    uint16_t hold;          /* ms a confirmed obstacle stays occupied once nothing sees it any more */
+    uint16_t stride;        /* every stride-th depth pixel in both directions is inserted */
+};
+
+/*
+ * Dense voxel grid in robot coordinates: x right, y forward and z up in mm,
+ * the origin on the floor below the camera. The mount comes as a floor plane
+ * in camera coordinates, the tracked one or one built from a fixed height
+ * and pitch. Every voxel keeps a Q8 log-odds: the points of a frame add a
+ * hit, three when there are enough of them to be a surface, a voxel the frame
+ * looks through adds a miss, and each second without a hit takes off enough
+ * for a saturated voxel to clear after the hold time. A surface is occupied
+ * at once, scattered points only after three frames in a row, so IR speckle
+ * never reaches the zones while a fast obstacle is not lost between voxels.
+ * Voxels above zero are kept in a list sized at startup: decay, free space
+ * and the zone query only visit those, so a frame costs its inserted points
+ * plus the voxels currently held.
+ */
+class OccupancyGrid
+{
+public:
+    explicit OccupancyGrid(const OccupancyGridConfig &config);
+
+    /* floor plane of a camera mounted height mm above the floor, pitched down by pitch degrees */
+    static GroundPlane mountPlane(float height, float pitch);
+
+    /**
+     * @brief     insert one depth frame and find the nearest obstacle of each zone
+     * @param[in]depth : 16 bit depth image in mm
+     * @param[in]calibration : intrinsics of the camera the frame came from
+     * @param[in]mount : floor plane in camera coordinates, must be valid
+     * @param[in]seconds : capture time of the frame
+     * @param[out]nearest : per zone the forward distance in mm of the nearest occupied voxel, 0 for none;
+     *                      the zones split the view like ZoneDangerDetector, by bearing
+     * @return    false when the frame or the calibration is unusable, the grid is left untouched
+     */
+    bool update(const AS_Frame_s &depth, const CameraCalibration &calibration, const GroundPlane &mount,
+                double seconds, uint16_t nearest[ZONE_COUNT]);
+
+    /* voxels above zero log-odds */
+    size_t activeVoxels() const
+    {
+        return m_active.size();
+    }
+
+private:
+    struct Voxel {
+        int16_t log_odds;       /* Q8, 0 when inactive */
+        uint8_t flags;
+        uint8_t points;         /* of the current frame, up to a surface patch */
+    };
+
+    OccupancyGridConfig m_config;
+    uint32_t m_size_x;
+    uint32_t m_size_y;
+    uint32_t m_size_z;
+    std::vector<Voxel> m_voxels;        /* z fastest, then x, then y */
+    std::vector<uint32_t> m_active;     /* indices of the voxels above zero, capacity fixed */
+    PointCloudProjector m_projector;
+
+    /* decay rate in Q8 per second, and what is left over from the last frame */
+    float m_decay_rate;
+    float m_decay_carry;
+    double m_last_seconds;
+    bool m_has_last;
+};
+
+#endif // OCCUPANCY_GRID_H
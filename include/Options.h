@@ -0,0 +1,58 @@
+/**
+ * @file      Options.h
+ * @brief     Runtime options read from ASCAMERA_* environment variables
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <string>
+
+/* looks up ASCAMERA_<name>, returns nullptr when it is not set */
+inline const char *optionValue(const char *name)
+{
+    std::string key = std::string("ASCAMERA_") + name;
+    const char *value = getenv(key.c_str());
+    if ((value == nullptr) || (value[0] == '\0')) {
+        return nullptr;
+    }
+    return value;
+}
+
+inline std::string optionString(const char *name, const std::string &def)
+{
+    const char *value = optionValue(name);
+    return value ? std::string(value) : def;
+}
+
+inline long optionInt(const char *name, long def)
+{
+    const char *value = optionValue(name);
+    return value ? strtol(value, nullptr, 0) : def;
+}
+
+inline double optionDouble(const char *name, double def)
+{
+    const char *value = optionValue(name);
+    return value ? strtod(value, nullptr) : def;
+}
+
+inline bool optionBool(const char *name, bool def)
+{
+    const char *value = optionValue(name);
+    if (value == nullptr) {
+        return def;
+    }
+    return (strcmp(value, "0") != 0) && (strcasecmp(value, "false") != 0) && (strcasecmp(value, "off") != 0);
+}
+
+#endif // OPTIONS_H
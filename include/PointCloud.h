@@ -0,0 +1,83 @@
+/**
+ * @file      PointCloud.h
+ * @brief     Depth to point cloud projection through a per-pixel ray table
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef POINT_CLOUD_H
+#define POINT_CLOUD_H
+
+#include <memory>
+#include <vector>
+#include <stdint.h>
+#include "as_camera_sdk_def.h"
+#include "CameraCalibration.h"
+#include "RecyclePool.h"
+
+/*
+ * One point per depth pixel in the depth camera's frame, x right, y down and
+ * z forward in mm, as structure of arrays. Pixels without depth are (0, 0, 0).
+ */
+struct PointCloud {
+    uint64_t timestamp;             /* of the depth frame */
+    uint32_t frame_id;
+    uint32_t width;
+    uint32_t height;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+};
+
+/*
+ * Back-projects depth images of one camera. The ray (x/z, y/z, 1) of every
+ * pixel is computed once per calibration and resolution, with the IR lens
+ * distortion already inverted, so a point costs one multiply per component:
+ * AVX2 or SSE2 on x86 (picked at runtime), NEON on arm. Intrinsics fetched
+ * for another resolution of the same sensor are scaled to the frame.
+ */
+class PointCloudProjector
+{
+public:
+    PointCloudProjector();
+
+    /**
+     * @brief     project a depth plane into cloud, reusing its buffers
+     * @param[in]depth : 16 bit depth image in mm
+     * @param[in]calibration : intrinsics of the camera the frame came from
+     * @param[out]cloud : resized to the frame
+     * @return    false when the frame has no usable depth plane or the calibration no IR intrinsics
+     */
+    bool project(const AS_Frame_s &depth, const CameraCalibration &calibration, PointCloud &cloud);
+
+    /* the same into a pooled cloud no one else holds any more, nullptr on failure */
+    std::shared_ptr<const PointCloud> project(const AS_Frame_s &depth, const CameraCalibration &calibration);
+
+    /* builds the ray table for width x height unless it is current, false without IR intrinsics */
+    bool prepare(const CameraCalibration &calibration, uint32_t width, uint32_t height);
+    /* ray table of the last projection, x/z and y/z per pixel */
+    const std::vector<float> &raysX() const
+    {
+        return m_ray_x;
+    }
+    const std::vector<float> &raysY() const
+    {
+        return m_ray_y;
+    }
+
+private:
+    /* what the table was built for */
+    uint32_t m_version;
+    uint32_t m_width;
+    uint32_t m_height;
+    std::vector<float> m_ray_x;
+    std::vector<float> m_ray_y;
+    /* clouds handed out by the pooled project() */
+    RecyclePool<PointCloud> m_pool;
+};
+
+#endif // POINT_CLOUD_H
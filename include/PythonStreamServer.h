@@ -16,34 +16,114 @@
 #include <mutex>
 #include <atomic>
 #include <memory>
-#include <queue>
+#include <vector>
+#include <map>
+#include <deque>
+#include <string>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include "as_camera_sdk_def.h"
+#include "FramePool.h"
+#include "CameraCalibration.h"
+#include "PointCloud.h"
+#include "DepthRegistration.h"
+#include "GroundPlane.h"
 
 struct StreamFrame {
-    uint64_t timestamp;
+    uint64_t timestamp;             /* SDK capture timestamp (AS_Frame_s::ts) */
     uint32_t frame_id;
     
-    // Depth data
+    // Depth, RGB and IR planes are read straight from the pooled slot
+    FrameRef buffer;
+    // Projected depth, sent right after the frame when set
+    std::shared_ptr<const PointCloud> cloud;
+    // Depth and RGB aligned to each other, sent after the cloud when set
+    std::shared_ptr<const RegisteredFrame> registered;
+    // What stands above the floor, sent after the registration when set
+    std::shared_ptr<const GroundMaskFrame> ground;
+};
+
+/* what a subscriber does when it falls behind the broadcast ring */
+enum StreamDropPolicy {
+    /* resume from the oldest frame still held by the ring */
+    STREAM_DROP_OLDEST = 0,
+    /* skip straight to the newest frame */
+    STREAM_LATEST_ONLY,
+};
+
+/* per client read cursor into the broadcast ring */
+struct StreamSubscriber {
+    uint64_t cursor;            /* sequence of the next frame to read */
+    StreamDropPolicy policy;
+    uint64_t delivered;
+    uint64_t dropped;
+};
+
+/* counters of one connected client */
+struct StreamClientStats {
+    std::string address;        /* ip:port */
+    uint64_t delivered;
+    uint64_t dropped;
+    uint64_t bytes_sent;
+};
+
+/* wire header sent in front of every frame */
+struct StreamFrameHeader {
+    uint64_t timestamp;
+    uint32_t frame_id;
     uint32_t depth_width;
     uint32_t depth_height;
     uint32_t depth_size;
-    std::shared_ptr<uint8_t> depth_data;
-    
-    // RGB data
     uint32_t rgb_width;
     uint32_t rgb_height;
     uint32_t rgb_size;
-    std::shared_ptr<uint8_t> rgb_data;
-    
-    // IR data (optional)
     uint32_t ir_width;
     uint32_t ir_height;
     uint32_t ir_size;
-    std::shared_ptr<uint8_t> ir_data;
+};
+
+/*
+ * Sent in place of a frame before the first frame, and again whenever a
+ * camera's calibration is refreshed: a StreamFrameHeader with frame_id
+ * STREAM_CALIBRATION_ID, all widths, heights and the other sizes 0, and
+ * depth_size bytes of StreamCalibration, one message per camera.
+ */
+static const uint32_t STREAM_CALIBRATION_ID = 0xFFFFFFFF;
+
+/*
+ * Follows the frame it was projected from: a StreamFrameHeader with frame_id
+ * STREAM_POINTCLOUD_ID, the frame's timestamp, depth_width and depth_height
+ * of the cloud and depth_size bytes of float x, y and z planes in mm (see
+ * PointCloud), the other sizes 0.
+ */
+static const uint32_t STREAM_POINTCLOUD_ID = 0xFFFFFFFE;
+
+/*
+ * Follows the frame (and its cloud) it was registered from: a
+ * StreamFrameHeader with frame_id STREAM_REGISTERED_ID and the frame's
+ * timestamp, the depth plane seen from the RGB camera and the RGB plane
+ * sampled for every depth pixel (see RegisteredFrame), either may be empty.
+ * No IR plane.
+ */
+static const uint32_t STREAM_REGISTERED_ID = 0xFFFFFFFD;
+
+/*
+ * Follows the frame it was computed from: a StreamFrameHeader with frame_id
+ * STREAM_GROUND_ID, the frame's timestamp, depth_width and depth_height of
+ * the mask and depth_size bytes of it, 255 per pixel standing above the
+ * floor (see GroundMaskFrame), the other sizes 0.
+ */
+static const uint32_t STREAM_GROUND_ID = 0xFFFFFFFC;
+
+struct StreamCalibration {
+    char serial[32];                /* NUL terminated */
+    uint32_t version;
+    uint32_t width;                 /* depth stream the parameters belong to, 0 when unknown */
+    uint32_t height;
+    uint32_t reserved;
+    AS_CAM_Parameter_s parameter;
 };
 
 class PythonStreamServer {
@@ -54,30 +134,114 @@ public:
     bool start();
     void stop();
     
-    // Called from camera callback to push new frame data
-    void pushFrame(const AS_SDK_Data_s *pstData);
+    // Called from camera callback to publish a pooled frame, no data is copied
+    void pushFrame(const FrameRef &frame, const std::shared_ptr<const PointCloud> &cloud = nullptr,
+                   const std::shared_ptr<const RegisteredFrame> &registered = nullptr,
+                   const std::shared_ptr<const GroundMaskFrame> &ground = nullptr);
     
     bool isRunning() const { return m_running; }
     int getConnectedClients() const { return m_connected_clients; }
+    // Bytes sent to every client since start, and counters of the connected ones
+    uint64_t bytesSentCount() const { return m_bytes_sent; }
+    void getClientStats(std::vector<StreamClientStats> &stats);
+
+    // Sent to every client on connect, and to the connected ones right away
+    void setCalibration(const std::string &serialno, const CameraCalibration &calibration);
+
+    // Drop policy applied to clients that connect afterwards
+    void setDropPolicy(StreamDropPolicy policy) { m_drop_policy = policy; }
+    // Send frames with MSG_ZEROCOPY to clients that connect afterwards
+    void setZeroCopy(bool enable) { m_zero_copy = enable; }
 
 private:
+    // A frame handed to sendmsg. It stays queued until it is fully written
+    // and, with MSG_ZEROCOPY, until the kernel reports it no longer needs
+    // the pages, which keeps both the pooled slot and the header alive.
+    struct PendingFrame {
+        StreamFrame frame;
+        std::shared_ptr<const StreamCalibration> calibration;   /* sent instead of the frame's planes */
+        std::shared_ptr<const PointCloud> cloud;                /* likewise */
+        std::shared_ptr<const RegisteredFrame> registered;      /* likewise */
+        std::shared_ptr<const GroundMaskFrame> ground;          /* likewise */
+        StreamFrameHeader header;
+        size_t sent;                /* bytes accepted by the kernel */
+        size_t total;               /* header plus planes */
+        bool zerocopy;              /* at least one MSG_ZEROCOPY send */
+        uint32_t zerocopy_id;       /* notification id of the last such send */
+    };
+
+    // Published copy of a client's counters, written by the I/O thread only
+    struct ClientCounters {
+        std::string address;
+        std::atomic<uint64_t> delivered;
+        std::atomic<uint64_t> dropped;
+        std::atomic<uint64_t> bytes_sent;
+    };
+
+    // Send state of one client, only touched by the I/O thread
+    struct ClientConnection {
+        int socket;
+        std::shared_ptr<ClientCounters> counters;
+        StreamSubscriber subscriber;
+        bool want_write;            /* EPOLLOUT is armed */
+        bool zerocopy;              /* SO_ZEROCOPY is enabled on the socket */
+        bool zerocopy_copied;       /* kernel copied anyway, stop pinning pages */
+        uint32_t zerocopy_next;     /* id the kernel assigns to the next MSG_ZEROCOPY send */
+        uint32_t zerocopy_done;     /* every id below this one has completed */
+        std::deque<PendingFrame> pending;
+        uint64_t calibration_generation;                        /* of the calibrations queued last */
+        std::deque<std::shared_ptr<const StreamCalibration>> calibrations;  /* to send before the next frame */
+        std::shared_ptr<const PointCloud> cloud;                /* of the frame just queued */
+        std::shared_ptr<const RegisteredFrame> registered;      /* likewise, after the cloud */
+        std::shared_ptr<const GroundMaskFrame> ground;          /* likewise, after the registration */
+    };
+
     void serverThread();
-    void clientHandler(int client_socket);
+    void acceptClients();
+    void closeClient(int client_socket);
+    bool flushClient(ClientConnection &client);
+    bool readCompletions(ClientConnection &client);
+    void releaseCompleted(ClientConnection &client);
+    void updateWriteInterest(ClientConnection &client, bool want_write);
     
-    bool sendFrameToClient(int client_socket, const StreamFrame& frame);
-    StreamFrame convertToStreamFrame(const AS_SDK_Data_s *pstData);
+    void queueCalibrations(ClientConnection &client);
+    void subscribe(StreamSubscriber &subscriber);
+    bool nextFrame(StreamSubscriber &subscriber, StreamFrame &frame);
+    int sendFrameToClient(ClientConnection &client);
     
     int m_port;
     int m_server_socket;
+    int m_epoll_fd;
+    int m_event_fd;                 /* signalled by pushFrame and stop */
     std::atomic<bool> m_running;
     std::atomic<int> m_connected_clients;
     
     std::thread m_server_thread;
-    std::mutex m_frame_mutex;
-    std::queue<StreamFrame> m_frame_queue;
+    std::map<int, ClientConnection> m_clients;
+    std::atomic<StreamDropPolicy> m_drop_policy;
+    std::atomic<bool> m_zero_copy;
+    std::atomic<uint64_t> m_bytes_sent;
     
-    static const size_t MAX_QUEUE_SIZE = 10;
+    // Counters of the connected clients, changed on connect and disconnect
+    std::mutex m_stats_mutex;
+    std::vector<std::shared_ptr<ClientCounters>> m_client_counters;
+
+    // Latest calibration of every camera, m_calibration_generation counts the changes
+    std::mutex m_calibration_mutex;
+    std::map<std::string, std::shared_ptr<const StreamCalibration>> m_calibrations;
+    std::atomic<uint64_t> m_calibration_generation;
+
+    // Broadcast ring: every frame is published once, each client reads it
+    // through its own cursor. m_publish_seq is the sequence of the next frame.
+    std::mutex m_frame_mutex;
+    std::vector<StreamFrame> m_frame_ring;
+    uint64_t m_publish_seq;
+    /* frame_id of the last published frame, under m_frame_mutex like the sequence */
     uint32_t m_frame_counter;
+    
+    static const size_t RING_CAPACITY = 10;
+    /* frames a zero copy client may have in the kernel before it waits for completions */
+    static const size_t MAX_ZEROCOPY_INFLIGHT = 4;
 };
 
 #endif // PYTHON_STREAM_SERVER_H
@@ -0,0 +1,135 @@
+/**
+ * @file      Recorder.h
+ * @brief     Continuous session recorder writing chunked, indexed .asrec files
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "as_camera_sdk_def.h"
+#include "CameraCalibration.h"
+#include "SessionFormat.h"
+
+/*
+ * Records every plane of every frame with its AS_Frame_s metadata. Frames
+ * are packed into preallocated, block aligned chunk buffers; full chunks go
+ * to a writer thread that appends them with one large O_DIRECT write each
+ * (buffered writes where O_DIRECT is not supported) into space reserved with
+ * fallocate. Files rotate at a size limit and when the camera calibration
+ * changes, so each file header holds the calibration of all its frames (a
+ * file without frames yet just gets its header rewritten). A frame is dropped, and counted,
+ * only when every chunk buffer is still waiting for the disk.
+ */
+class Recorder
+{
+public:
+    /**
+     * @param[in]chunk_bytes : size of one chunk buffer, rounded up to SESSION_BLOCK
+     * @param[in]chunk_count : chunk buffers, how much a slow disk may lag behind
+     * @param[in]file_bytes : a new file is started once a file grows past this, 0 for never
+     */
+    Recorder(size_t chunk_bytes = 16 << 20, size_t chunk_count = 4, uint64_t file_bytes = 1ULL << 30);
+    ~Recorder();
+
+    /**
+     * @brief     start a recording
+     * @param[in]directory : where the files go
+     * @param[in]serial : camera serial, used in the file names and header
+     * @param[in]camera_type : AS_SDK_CAM_MODEL_E stored in the header
+     * @return    true when the first file could be created
+     */
+    bool start(const std::string &directory, const std::string &serial, uint32_t camera_type);
+    /* seals the open chunk, writes everything queued and closes the file */
+    void stop();
+    bool isRecording() const
+    {
+        return m_recording;
+    }
+
+    /* copy one frame into the current chunk, called from a single thread;
+       calibration is what the frame was captured under, nullptr when unknown */
+    bool record(const AS_SDK_Data_s *data, uint64_t sequence, const CameraCalibration *calibration);
+
+    uint64_t framesCount() const
+    {
+        return m_frames;
+    }
+    /* frames lost because every chunk was waiting for the disk */
+    uint64_t droppedCount() const
+    {
+        return m_dropped;
+    }
+    uint64_t bytesCount() const
+    {
+        return m_bytes;
+    }
+    /* sealed chunks waiting for the writer thread */
+    size_t backlog();
+    void logStats();
+
+private:
+    struct Chunk {
+        uint8_t *buffer;
+        size_t used;
+        /* written behind the frames when the chunk is sealed */
+        std::vector<SessionIndexEntry> index;
+        /* shared by every frame in the chunk */
+        CameraCalibration calibration;
+        bool full;
+    };
+
+    bool openFile();
+    bool writeHeader();
+    void closeFile();
+    bool writeAll(const uint8_t *data, size_t size);
+    void sealChunk(Chunk &chunk);
+    void writerThread();
+
+    size_t m_chunk_bytes;
+    uint64_t m_file_bytes;
+    std::vector<Chunk> m_chunks;
+    size_t m_fill;              /* chunk the recording thread fills */
+    size_t m_flush;             /* next chunk the writer thread writes */
+    uint8_t *m_header_block;
+
+    /* serialises record() against stop() */
+    std::mutex m_record_mutex;
+    /* chunk hand-off between the two threads */
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::thread m_thread;
+    std::atomic<bool> m_recording;
+    bool m_stopping;
+
+    /* writer thread while recording */
+    std::string m_directory;
+    std::string m_serial;
+    std::string m_session;
+    uint32_t m_camera_type;
+    uint32_t m_file_index;
+    int m_fd;
+    bool m_direct;
+    uint64_t m_written;
+    uint64_t m_allocated;
+    /* in the header of the open file */
+    CameraCalibration m_calibration;
+
+    std::atomic<uint64_t> m_frames;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_bytes;
+};
+
+#endif // RECORDER_H
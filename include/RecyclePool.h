@@ -0,0 +1,58 @@
+/**
+ * @file      RecyclePool.h
+ * @brief     Buffers handed out as shared_ptr and reused once every reader let go
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef RECYCLE_POOL_H
+#define RECYCLE_POOL_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <stddef.h>
+
+/*
+ * For results a stage produces per frame (point clouds, registered images)
+ * that other threads read for a while, e.g. until a stream client has been
+ * sent one. acquire() is called by the producing thread only; the readers
+ * just drop their shared_ptr, after which the object and its buffers are
+ * handed out again without allocating.
+ */
+template <typename T>
+class RecyclePool
+{
+public:
+    explicit RecyclePool(size_t limit)
+        : m_limit(limit)
+    {
+    }
+
+    /* an object no one else holds, or a new one, nullptr when all limit objects are in use */
+    std::shared_ptr<T> acquire()
+    {
+        for (size_t i = 0; i < m_items.size(); i++) {
+            // only the pool holds it, no reader can pick it up again
+            if (m_items[i].use_count() == 1) {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return m_items[i];
+            }
+        }
+        if (m_items.size() >= m_limit) {
+            return nullptr;
+        }
+        m_items.push_back(std::make_shared<T>());
+        return m_items.back();
+    }
+
+private:
+    size_t m_limit;
+    std::vector<std::shared_ptr<T>> m_items;
+};
+
+#endif // RECYCLE_POOL_H
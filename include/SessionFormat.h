@@ -0,0 +1,95 @@
+/**
+ * @file      SessionFormat.h
+ * @brief     On-disk layout of recorded camera sessions (.asrec)
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef SESSION_FORMAT_H
+#define SESSION_FORMAT_H
+
+#include <stdint.h>
+#include "CameraCalibration.h"
+
+/*
+ * A session file is a SessionFileHeader block followed by chunks, appended
+ * in order. Each chunk is a multiple of SESSION_BLOCK bytes so it can be
+ * written with O_DIRECT:
+ *
+ *   SessionChunkHeader | frame record | frame record | ... | index | padding
+ *
+ * A frame record is a SessionFrameHeader, one SessionPlane per image plane,
+ * then the plane data. Records and plane data start on SESSION_ALIGN
+ * boundaries, so a reader that maps the file can hand the planes out in
+ * place. The per-chunk index (SessionIndexEntry[frame_count]) lets a reader
+ * seek by time without touching the frames. All fields are little endian.
+ *
+ * Every frame of a file was captured under the calibration in its header; a
+ * refreshed calibration starts a new file. Version 1 files have no
+ * calibration.
+ */
+
+#define SESSION_FILE_MAGIC  0x43525341  /* "ASRC" */
+#define SESSION_CHUNK_MAGIC 0x4b435341  /* "ASCK" */
+#define SESSION_FRAME_MAGIC 0x52465341  /* "ASFR" */
+#define SESSION_VERSION     2
+
+#define SESSION_BLOCK 4096
+#define SESSION_ALIGN 64
+
+struct SessionFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_bytes;      /* SESSION_BLOCK, chunks start here */
+    uint32_t camera_type;       /* AS_SDK_CAM_MODEL_E */
+    uint64_t created_us;        /* wall clock, microseconds since the epoch */
+    uint32_t file_index;        /* position of this file in a rotated session */
+    uint32_t reserved;
+    char serial[64];
+    CameraCalibration calibration;  /* version 0 when the camera had none yet */
+};
+
+struct SessionChunkHeader {
+    uint32_t magic;
+    uint32_t frame_count;
+    uint64_t chunk_bytes;       /* whole chunk including index and padding */
+    uint64_t index_offset;      /* from the chunk start */
+    uint64_t first_timestamp;
+    uint64_t last_timestamp;
+    uint64_t first_sequence;
+    uint8_t reserved[16];
+};
+
+struct SessionIndexEntry {
+    uint64_t offset;            /* frame record, from the chunk start */
+    uint64_t timestamp;
+    uint64_t sequence;
+    uint32_t bytes;
+    uint32_t reserved;
+};
+
+struct SessionFrameHeader {
+    uint32_t magic;
+    uint32_t bytes;             /* whole record including plane data */
+    uint64_t sequence;
+    uint64_t timestamp;         /* capture timestamp of the first plane */
+    uint32_t plane_count;
+    uint32_t reserved;
+};
+
+/* AS_Frame_s metadata of one plane */
+struct SessionPlane {
+    uint32_t type;              /* AS_FRAME_Type_e */
+    uint32_t width;
+    uint32_t height;
+    uint32_t size;
+    uint32_t frame_id;
+    uint32_t data_offset;       /* from the frame record start */
+    uint64_t timestamp;
+};
+
+#endif // SESSION_FORMAT_H
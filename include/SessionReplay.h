@@ -0,0 +1,123 @@
+/**
+ * @file      SessionReplay.h
+ * @brief     Replays recorded sessions through ICameraStatus from a memory mapping
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef SESSION_REPLAY_H
+#define SESSION_REPLAY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "CameraSrv.h"
+#include "SessionFormat.h"
+
+/*
+ * Stands in for CameraSrv. Session files written by Recorder are mapped read
+ * only; files of the same camera serial become one virtual camera, played in
+ * the order they were written. Every camera is attached, opened and started
+ * like a live one, then the frames of all cameras are fired on one thread in
+ * capture time order, with AS_SDK_Data_s planes pointing straight into the
+ * mapping. The callee must treat the plane data as read only.
+ */
+class SessionReplay
+{
+public:
+    enum Pacing {
+        PACE_REALTIME,  /* capture intervals, divided by the speed factor */
+        PACE_FAST,      /* as fast as the callee consumes frames */
+        PACE_STEP,      /* one frame per step() */
+    };
+
+    /**
+     * @param[in]cameraStatus : receives the camera events and frames
+     * @param[in]paths : session files, or directories holding .asrec files
+     * @param[in]ticks_per_second : unit of the recorded timestamps
+     */
+    SessionReplay(ICameraStatus *cameraStatus, const std::vector<std::string> &paths, double ticks_per_second);
+    ~SessionReplay();
+
+    SessionReplay(const SessionReplay &) = delete;
+    SessionReplay &operator = (const SessionReplay &) = delete;
+
+    void setPacing(Pacing pacing, double speed = 1.0);
+    /* start over at the end instead of detaching the cameras */
+    void setLoop(bool loop);
+
+    /* map the files and start the replay thread, non-zero when nothing could be replayed */
+    int start();
+    /* stops, and stops/closes/detaches the cameras */
+    void stop();
+    /* release the next frame in PACE_STEP */
+    void step();
+    bool isFinished() const
+    {
+        return m_finished;
+    }
+
+    static Pacing parsePacing(const std::string &name);
+
+private:
+    struct Mapping {
+        std::string path;
+        uint8_t *base;
+        size_t size;
+        uint64_t created_us;
+        uint32_t file_index;
+        /* version 0 when the file has none */
+        CameraCalibration calibration;
+    };
+
+    struct ReplayCamera {
+        std::string serial;
+        uint32_t camera_type;
+        std::vector<Mapping> files;
+        size_t plane_capacity[AS_FRAME_TYPE_BUTT];
+        AS_SDK_Data_s data;
+        uint64_t frames;
+    };
+
+    struct ReplayFrame {
+        ReplayCamera *camera;
+        const SessionFrameHeader *record;
+        /* replay clock in ticks, gaps and clock jumps are clamped */
+        uint64_t time;
+    };
+
+    bool mapFile(const std::string &path);
+    void indexCamera(ReplayCamera &camera);
+    void fire(const ReplayFrame &frame);
+    void replayThread();
+    void detachCameras();
+
+    ICameraStatus *m_camera_status;
+    std::vector<std::string> m_paths;
+    double m_ticks_per_second;
+    Pacing m_pacing;
+    double m_speed;
+    bool m_loop;
+
+    std::vector<std::unique_ptr<ReplayCamera>> m_cameras;
+    std::vector<ReplayFrame> m_frames;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_running;
+    uint64_t m_steps;
+    bool m_attached;
+    std::atomic<bool> m_finished;
+};
+
+#endif // SESSION_REPLAY_H
@@ -0,0 +1,89 @@
+/**
+ * @file      SyntheticCamera.h
+ * @brief     Procedural virtual cameras feeding ICameraStatus without a device
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef SYNTHETIC_CAMERA_H
+#define SYNTHETIC_CAMERA_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include "CameraSrv.h"
+
+/*
+ * Stands in for CameraSrv on machines without a camera. Each virtual camera
+ * is attached, opened and started like a live one and then streams depth
+ * (uint16 mm), RGB (BGR) and IR (8 bit) frames from its own thread, like
+ * the SDK streams each device. The scene is a floor and a back wall with an
+ * obstacle moving through it; the static parts are rendered once, so a frame
+ * costs little more than a copy and the measurements are of the pipeline.
+ */
+class SyntheticCameras
+{
+public:
+    enum Scene {
+        SCENE_APPROACH,     /* obstacle closing in at 1 m/s, one zone per camera */
+        SCENE_CROSSING,     /* obstacle sweeping left to right at 1.5 m */
+        SCENE_STATIC,       /* floor and wall only */
+    };
+
+    struct Config {
+        size_t cameras;
+        uint32_t width;
+        uint32_t height;
+        /* frames per second per camera, 0 for as fast as they are consumed */
+        double fps;
+        Scene scene;
+        /* unit of AS_Frame_s::ts */
+        double ticks_per_second;
+    };
+
+    SyntheticCameras(ICameraStatus *cameraStatus, const Config &config);
+    ~SyntheticCameras();
+
+    SyntheticCameras(const SyntheticCameras &) = delete;
+    SyntheticCameras &operator = (const SyntheticCameras &) = delete;
+
+    int start();
+    /* stops the streams, then stops/closes/detaches the cameras */
+    void stop();
+
+    static Scene parseScene(const std::string &name);
+
+private:
+    struct Device {
+        size_t index;
+        std::string serial;
+        std::vector<uint16_t> background_depth;
+        std::vector<uint8_t> background_rgb;
+        std::vector<uint8_t> background_ir;
+        std::vector<uint16_t> depth;
+        std::vector<uint8_t> rgb;
+        std::vector<uint8_t> ir;
+        AS_SDK_Data_s data;
+        uint64_t frames;
+        std::thread thread;
+    };
+
+    void renderBackground(Device &device);
+    void renderFrame(Device &device, double seconds);
+    void streamThread(Device *device);
+
+    ICameraStatus *m_camera_status;
+    Config m_config;
+    std::vector<std::unique_ptr<Device>> m_devices;
+    std::atomic<bool> m_running;
+    bool m_attached;
+};
+
+#endif // SYNTHETIC_CAMERA_H
@@ -0,0 +1,70 @@
+/**
+ * @file      TtcEstimator.h
+ * @brief     Per-zone time to collision from the nearest obstacle distance
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef TTC_ESTIMATOR_H
+#define TTC_ESTIMATOR_H
+
+#include <stdint.h>
+#include "ZoneDangerDetector.h"
+
+/*
+ * Fits the closing velocity of each zone by least squares over the last
+ * HISTORY_SIZE distances, keyed by the capture timestamp of the frame. The
+ * sums are updated as samples enter and leave the ring, so a frame costs
+ * O(1); they are rebuilt once per lap of the ring to shed rounding drift.
+ *
+ * Same rules as TTCCalculator in python_live_client.py: at least 3 samples,
+ * only approaching objects faster than min_velocity, TTC in 0.1..60 s.
+ */
+class TtcEstimator
+{
+public:
+    static const int HISTORY_SIZE = 10;
+
+    /**
+     * @param[in]ticks_per_second : unit of the timestamps given to update()
+     * @param[in]warn_ttc : TTC in s at or below which ttc_warn is set
+     * @param[in]min_velocity : closing speed in m/s below which no TTC is given
+     */
+    TtcEstimator(double ticks_per_second = 1000.0, float warn_ttc = 4.0f, float min_velocity = 0.01f);
+
+    /* add the zone distances of result and fill in velocity, ttc and ttc_warn */
+    void update(ZoneDangerResult &result);
+    void reset();
+
+private:
+    struct Sample {
+        double t;
+        double d;
+    };
+
+    struct ZoneHistory {
+        Sample ring[HISTORY_SIZE];
+        int head;
+        int count;
+        /* origin of t in the ring, keeps the sums well conditioned */
+        uint64_t origin;
+        double sum_t;
+        double sum_d;
+        double sum_tt;
+        double sum_td;
+    };
+
+    void push(ZoneHistory &zone, uint64_t timestamp, double distance);
+    void rebuild(ZoneHistory &zone, uint64_t origin);
+
+    double m_ticks_per_second;
+    float m_warn_ttc;
+    float m_min_velocity;
+    ZoneHistory m_zones[ZONE_COUNT];
+};
+
+#endif // TTC_ESTIMATOR_H
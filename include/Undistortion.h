@@ -0,0 +1,66 @@
+/**
+ * @file      Undistortion.h
+ * @brief     Lens distortion removed from depth, IR and RGB planes through remap tables
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef UNDISTORTION_H
+#define UNDISTORTION_H
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include "as_camera_sdk_def.h"
+#include "CameraCalibration.h"
+#include "FramePool.h"
+
+/*
+ * Rectifies the planes of a camera's frames while they are copied into the
+ * frame pool, so every consumer sees images of an ideal pinhole camera with
+ * the original intrinsics. For every output pixel the distorted source
+ * position is computed once per calibration and resolution and kept as the
+ * index of its top left source pixel plus 8 bit x and y fractions. At run
+ * time the 16 bit depth takes the nearest pixel (interpolating depth would
+ * invent surfaces at edges), 8 bit IR and BGR24 RGB are interpolated
+ * bilinearly in integers, with AVX2 gathers where the CPU has them. Depth
+ * and IR use the IR coefficients, RGB its own; other formats are copied.
+ */
+class FrameUndistorter : public PlaneFilter
+{
+public:
+    FrameUndistorter();
+
+    /* the unrectified snapshot to build the tables from, must outlive the undistorter; from any thread */
+    void setCalibration(const CameraCalibration *calibration);
+    /* what a calibration describes once its frames went through the undistorter */
+    static void removeDistortion(CameraCalibration &calibration);
+
+    /* on the SDK callback thread only */
+    virtual bool filter(int type, const AS_Frame_s &src, void *dst) override;
+
+private:
+    struct RemapTable {
+        uint32_t version;           /* of the calibration, 0 for none */
+        uint32_t width;
+        uint32_t height;
+        bool identity;              /* no distortion, the plane is copied */
+        std::vector<int32_t> index;     /* top left source pixel, -1 outside the source */
+        std::vector<uint16_t> weight;   /* x fraction | y fraction << 8, in 1/256 pixel */
+    };
+
+    /* false when the lens is unknown or the plane too small */
+    static bool prepare(RemapTable &table, const CameraCalibration &calibration, bool rgb, uint32_t width,
+                        uint32_t height);
+
+    std::atomic<const CameraCalibration *> m_calibration;
+    RemapTable m_depth;
+    RemapTable m_ir;
+    RemapTable m_rgb;
+};
+
+#endif // UNDISTORTION_H
@@ -0,0 +1,43 @@
+/**
+ * @file      VirtualCamera.h
+ * @brief     Registry of camera handles that are not backed by the SDK
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef VIRTUAL_CAMERA_H
+#define VIRTUAL_CAMERA_H
+
+#include <string>
+#include <stddef.h>
+#include "as_camera_sdk_def.h"
+#include "CameraCalibration.h"
+
+/*
+ * Frame sources other than CameraSrv (session replay, synthetic cameras)
+ * drive ICameraStatus with handles of their own. They register each handle
+ * here before attaching it, and Camera answers serial number, attributes and
+ * plane sizes from the registry instead of calling AS_SDK_* on a handle the
+ * SDK does not know.
+ */
+struct VirtualCameraInfo {
+    std::string serial;
+    AS_SDK_CAM_MODEL_E type;
+    /* shown where the USB port or IP address of a real camera would be */
+    std::string location;
+    /* largest plane in bytes, indexed by AS_FRAME_Type_e */
+    size_t plane_capacity[AS_FRAME_TYPE_BUTT];
+    /* what Camera publishes instead of AS_SDK_GetCamParameter, version 0 when there is none */
+    CameraCalibration calibration;
+};
+
+void registerVirtualCamera(AS_CAM_PTR pCamera, const VirtualCameraInfo &info);
+void unregisterVirtualCamera(AS_CAM_PTR pCamera);
+/* false when pCamera is an SDK camera */
+bool findVirtualCamera(AS_CAM_PTR pCamera, VirtualCameraInfo &info);
+
+#endif // VIRTUAL_CAMERA_H
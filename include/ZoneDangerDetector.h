@@ -0,0 +1,84 @@
+/**
+ * @file      ZoneDangerDetector.h
+ * @brief     Per-zone nearest obstacle detection on the depth image
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#ifndef ZONE_DANGER_DETECTOR_H
+#define ZONE_DANGER_DETECTOR_H
+
+#include <stdint.h>
+#include "as_camera_sdk_def.h"
+
+enum ZoneIndex {
+    ZONE_LEFT = 0,
+    ZONE_CENTER,
+    ZONE_RIGHT,
+    ZONE_COUNT
+};
+
+struct ZoneResult {
+    /* nearest valid depth in mm, 0 when the zone has no valid pixel */
+    uint16_t min_depth;
+    /* min_depth is below the zone threshold */
+    bool warn;
+    /* ttc is at or below the TTC warn threshold, set by TtcEstimator */
+    bool ttc_warn;
+    /* closing velocity in m/s (negative when approaching) and time to
+     * collision in s, ttc < 0 when it cannot be estimated; set by TtcEstimator */
+    float velocity;
+    float ttc;
+};
+
+struct ZoneDangerResult {
+    /* capture timestamp and id of the depth frame, from AS_Frame_s */
+    uint64_t timestamp;
+    uint32_t frame_id;
+    ZoneResult zones[ZONE_COUNT];
+};
+
+/*
+ * Splits the depth image into left/center/right columns (30/40/30, same as
+ * analyze_danger_zones in python_live_client.py) and finds the nearest valid
+ * depth of each zone. Valid depth is 100 < d < 60000, the min reduction uses
+ * SSE2/AVX2 on x86 (picked at runtime) and NEON on arm.
+ */
+class ZoneDangerDetector
+{
+public:
+    static const uint16_t DEFAULT_CENTER_THRESHOLD = 1500;
+    static const uint16_t DEFAULT_SIDE_THRESHOLD = 1000;
+
+    ZoneDangerDetector(uint16_t center_threshold = DEFAULT_CENTER_THRESHOLD,
+                       uint16_t side_threshold = DEFAULT_SIDE_THRESHOLD);
+
+    /**
+     * @brief     analyse the depth plane of a frame
+     * @param[in]depth : 16 bit depth image in mm
+     * @param[out]result : per-zone result
+     * @return    false when the frame carries no usable depth plane
+     */
+    bool process(const AS_Frame_s &depth, ZoneDangerResult &result);
+
+    /**
+     * @brief     the same decision on nearest depths found elsewhere, e.g. in an occupancy grid
+     * @param[in]timestamp : of the depth frame
+     * @param[in]frame_id : of the depth frame
+     * @param[in]nearest : per-zone nearest obstacle in mm, 0 for none
+     * @param[out]result : per-zone result
+     */
+    void classify(uint64_t timestamp, uint32_t frame_id, const uint16_t nearest[ZONE_COUNT], ZoneDangerResult &result);
+
+    /* nearest valid depth of n pixels, 0 when none is valid */
+    static uint16_t minValidDepth(const uint16_t *depth, size_t n);
+
+private:
+    uint16_t m_threshold[ZONE_COUNT];
+};
+
+#endif // ZONE_DANGER_DETECTOR_H
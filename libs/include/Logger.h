@@ -1,8 +1,12 @@
 #pragma once
 
+#include <atomic>
 #include <iostream>
+#include <sstream>
+#include <cstdio>
 #include <cstring>
 #include <string>
+#include <stdint.h>
 
 #ifdef _WIN32
 #undef ERROR
@@ -15,8 +19,14 @@ typedef enum {
     NOTICE = 3,
 } LogLevel;
 
-static LogLevel s_logLevel = NOTICE;
+/* exported by the SDK, which logs at its own level */
 std::string getSysTime();
+void setLogLevel(LogLevel verbose);
+
+/* LOG() levels above this are compiled out, e.g. -DLOG_MIN_LEVEL=WARN */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL NOTICE
+#endif
 
 #ifdef _WIN32
 #define FILEV(x) (strrchr((x), '\\') ? strrchr((x), '\\') + 1 : (x))
@@ -24,8 +34,177 @@ std::string getSysTime();
 #define FILEV(x) (strrchr((x), '/') ? strrchr((x), '/') + 1 : (x))
 #endif
 
-#define LOG(log_level)               \
-    if (log_level <= s_logLevel) \
-    std::cout << getSysTime() << "[" << #log_level << "] " << "[" << FILEV(__FILE__) << "] [" << __LINE__ << "] [" << __FUNCTION__ << "] "
+/*
+ * Backend of LOG(). The arguments of a line are stored raw (text bytes,
+ * integers, doubles and pointers, each behind a type tag) in a per-thread
+ * staging buffer and copied into that thread's lock-free ring along with the
+ * raw time, file, line and function; a background thread formats them, adds
+ * the time stamp and prefix, merges the rings in time order and writes them
+ * to stdout every 10 ms, at once after an ERROR. Only types that need an
+ * ostream are formatted on the logging thread. Apart from that wakeup the logging thread
+ * takes no lock and makes no syscall. A full ring drops the line and the
+ * drop is reported later. Lines logged once the backend is stopped at exit
+ * are written synchronously.
+ */
+class AsyncLogger
+{
+public:
+    /* one level for the whole program */
+    static void setLevel(LogLevel level)
+    {
+        s_level.store(level, std::memory_order_relaxed);
+    }
+    static LogLevel level()
+    {
+        return static_cast<LogLevel>(s_level.load(std::memory_order_relaxed));
+    }
+    static bool enabled(LogLevel level)
+    {
+        return level <= s_level.load(std::memory_order_relaxed);
+    }
+    /* error, warn, info or notice, false for anything else */
+    static bool parseLevel(const std::string &name, LogLevel &level);
 
-void setLogLevel(LogLevel verbose);
+    /* writes everything logged so far, waits for the background thread */
+    static void flush();
+
+    /* LogLine internals */
+    enum ArgType {
+        ARG_TEXT = 0,           /* uint32_t length, then the bytes */
+        ARG_INT,                /* int64_t */
+        ARG_UINT,               /* uint64_t */
+        ARG_DOUBLE,
+        ARG_POINTER,            /* uint64_t */
+    };
+    static char *beginLine(size_t &capacity);
+    static void commitLine(LogLevel level, const char *file, int line, const char *function, const char *text,
+                           size_t length);
+
+private:
+    static std::atomic<int> s_level;
+};
+
+/* one LOG() statement, committed when the temporary is destroyed */
+class LogLine
+{
+public:
+    LogLine(LogLevel level, const char *file, int line, const char *function)
+        : m_level(level), m_file(file), m_line(line), m_function(function), m_length(0)
+    {
+        m_text = AsyncLogger::beginLine(m_capacity);
+    }
+    ~LogLine()
+    {
+        AsyncLogger::commitLine(m_level, m_file, m_line, m_function, m_text, m_length);
+    }
+
+    LogLine &operator << (const char *value)
+    {
+        return append(value ? value : "(null)", value ? strlen(value) : 6);
+    }
+    LogLine &operator << (const std::string &value)
+    {
+        return append(value.data(), value.size());
+    }
+    LogLine &operator << (char value)
+    {
+        return append(&value, 1);
+    }
+    LogLine &operator << (unsigned char value)
+    {
+        return append(reinterpret_cast<const char *>(&value), 1);
+    }
+    LogLine &operator << (bool value)
+    {
+        return append(value ? "1" : "0", 1);
+    }
+    LogLine &operator << (int value)
+    {
+        return raw(AsyncLogger::ARG_INT, static_cast<int64_t>(value));
+    }
+    LogLine &operator << (unsigned int value)
+    {
+        return raw(AsyncLogger::ARG_UINT, static_cast<uint64_t>(value));
+    }
+    LogLine &operator << (long value)
+    {
+        return raw(AsyncLogger::ARG_INT, static_cast<int64_t>(value));
+    }
+    LogLine &operator << (unsigned long value)
+    {
+        return raw(AsyncLogger::ARG_UINT, static_cast<uint64_t>(value));
+    }
+    LogLine &operator << (long long value)
+    {
+        return raw(AsyncLogger::ARG_INT, static_cast<int64_t>(value));
+    }
+    LogLine &operator << (unsigned long long value)
+    {
+        return raw(AsyncLogger::ARG_UINT, static_cast<uint64_t>(value));
+    }
+    LogLine &operator << (double value)
+    {
+        return raw(AsyncLogger::ARG_DOUBLE, value);
+    }
+    LogLine &operator << (const void *value)
+    {
+        return raw(AsyncLogger::ARG_POINTER, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+    }
+    /* std::endl */
+    LogLine &operator << (std::ostream & (*)(std::ostream &))
+    {
+        return append("\n", 1);
+    }
+    /* anything else an ostream can print */
+    template <typename T>
+    LogLine &operator << (const T &value)
+    {
+        std::ostringstream stream;
+        stream << value;
+        return *this << stream.str();
+    }
+
+private:
+    LogLine(const LogLine &) = delete;
+    LogLine &operator = (const LogLine &) = delete;
+
+    LogLine &append(const char *data, size_t size)
+    {
+        /* anything beyond the staging buffer is cut off */
+        const size_t header = 1 + sizeof(uint32_t);
+        if (m_capacity - m_length <= header) {
+            return *this;
+        }
+        uint32_t n = static_cast<uint32_t>((size < m_capacity - m_length - header) ? size : m_capacity - m_length - header);
+        m_text[m_length] = AsyncLogger::ARG_TEXT;
+        memcpy(m_text + m_length + 1, &n, sizeof(n));
+        memcpy(m_text + m_length + header, data, n);
+        m_length += header + n;
+        return *this;
+    }
+    /* formatted by the background thread */
+    template <typename T>
+    LogLine &raw(AsyncLogger::ArgType type, T value)
+    {
+        if (m_capacity - m_length < 1 + sizeof(T)) {
+            return *this;
+        }
+        m_text[m_length] = static_cast<char>(type);
+        memcpy(m_text + m_length + 1, &value, sizeof(T));
+        m_length += 1 + sizeof(T);
+        return *this;
+    }
+
+    LogLevel m_level;
+    const char *m_file;
+    int m_line;
+    const char *m_function;
+    char *m_text;
+    size_t m_capacity;
+    size_t m_length;
+};
+
+#define LOG(log_level)                                                                     \
+    if (((log_level) > LOG_MIN_LEVEL) || !AsyncLogger::enabled(log_level)) {               \
+    } else                                                                                 \
+        LogLine(log_level, __FILE__, __LINE__, __FUNCTION__)
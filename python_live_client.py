@@ -11,7 +11,7 @@ import cv2
 import time
 import threading
 import os
-from typing import Optional, Tuple, List
+from typing import Dict, Optional, Tuple, List
 from collections import deque
 
 # TTS and Audio imports
@@ -218,12 +218,13 @@ class TTSAudioManager:
 ttc_calculator = TTCCalculator()
 audio_manager = TTSAudioManager() if TTS_AVAILABLE else None
 
-def analyze_danger_zones(depth_img: np.ndarray) -> Tuple[Tuple[str, float, Optional[float]], Tuple[str, float, Optional[float]], Tuple[str, float, Optional[float]]]:
+def analyze_danger_zones(depth_img: np.ndarray, obstacle_mask: Optional[np.ndarray] = None) -> Tuple[Tuple[str, float, Optional[float]], Tuple[str, float, Optional[float]], Tuple[str, float, Optional[float]]]:
     """
     Analyze depth image for 3-zone danger detection with Time-to-Collision calculation
     
     Args:
         depth_img: 16-bit depth image
+        obstacle_mask: pixels standing above the floor (ASCAMERA_GROUND=1), the floor is ignored when given
         
     Returns:
         Tuple of ((left_status, left_min_dist, left_ttc), (center_status, center_min_dist, center_ttc), (right_status, right_min_dist, right_ttc))
@@ -233,6 +234,8 @@ def analyze_danger_zones(depth_img: np.ndarray) -> Tuple[Tuple[str, float, Optio
         return ("safe", 0.0, None), ("safe", 0.0, None), ("safe", 0.0, None)
     
     height, width = depth_img.shape
+    if obstacle_mask is not None and obstacle_mask.shape == depth_img.shape:
+        depth_img = np.where(obstacle_mask > 0, depth_img, 0)
     
     # Define zones (30% left, 40% center, 30% right)
     left_end = int(width * 0.3)
@@ -277,6 +280,16 @@ def analyze_danger_zones(depth_img: np.ndarray) -> Tuple[Tuple[str, float, Optio
     
     return left_final, center_final, right_final
 
+# frame_id of a StreamCalibration message, a point cloud, a registered frame and a ground mask (include/PythonStreamServer.h)
+CALIBRATION_FRAME_ID = 0xFFFFFFFF
+POINTCLOUD_FRAME_ID = 0xFFFFFFFE
+REGISTERED_FRAME_ID = 0xFFFFFFFD
+GROUND_FRAME_ID = 0xFFFFFFFC
+# AS_CAM_Parameter_s, in order
+CALIBRATION_FIELDS = ('fxir', 'fyir', 'cxir', 'cyir', 'fxrgb', 'fyrgb', 'cxrgb', 'cyrgb',
+                      'R00', 'R01', 'R02', 'R10', 'R11', 'R12', 'R20', 'R21', 'R22', 'T1', 'T2', 'T3',
+                      'K1ir', 'K2ir', 'K3ir', 'P1ir', 'P2ir', 'K1rgb', 'K2rgb', 'K3rgb', 'P1rgb', 'P2rgb')
+
 class CameraStreamClient:
     def __init__(self, host='localhost', port=8888):
         self.host = host
@@ -289,6 +302,14 @@ class CameraStreamClient:
         self.latest_depth = None
         self.latest_rgb = None
         self.latest_ir = None
+        self.latest_points = None
+        self.latest_registered_depth = None
+        self.latest_registered_rgb = None
+        self.latest_ground_mask = None
+        # With ASCAMERA_GROUND=1 a frame waits here until its mask follows
+        self.ground_enabled = False
+        self.pending_frame = None
+        self.calibrations = {}
         self.frame_count = 0
         self.start_time = time.time()
         
@@ -359,6 +380,57 @@ class CameraStreamClient:
                 ir_height = header[9]
                 ir_size = header[10]
                 
+                # Camera parameters, sent before the first frame and after a refresh
+                if frame_id == CALIBRATION_FRAME_ID:
+                    payload = self._receive_exact(depth_size)
+                    if not payload:
+                        break
+                    self._update_calibration(payload)
+                    continue
+                
+                # x, y and z planes in mm of the frame just received
+                if frame_id == POINTCLOUD_FRAME_ID:
+                    payload = self._receive_exact(depth_size)
+                    if not payload:
+                        break
+                    points = np.frombuffer(payload, dtype=np.float32).reshape((3, depth_height, depth_width))
+                    with self.lock:
+                        self.latest_points = points
+                    continue
+                
+                # depth seen from the RGB camera and colour of every depth pixel
+                if frame_id == REGISTERED_FRAME_ID:
+                    depth_data = self._receive_exact(depth_size) if depth_size > 0 else b''
+                    rgb_data = self._receive_exact(rgb_size) if rgb_size > 0 else b''
+                    if (depth_size > 0 and not depth_data) or (rgb_size > 0 and not rgb_data):
+                        break
+                    with self.lock:
+                        if depth_size > 0:
+                            self.latest_registered_depth = np.frombuffer(depth_data, dtype=np.uint16).reshape(
+                                (depth_height, depth_width))
+                        if rgb_size > 0:
+                            self.latest_registered_rgb = np.frombuffer(rgb_data, dtype=np.uint8).reshape(
+                                (rgb_height, rgb_width, 3))
+                    continue
+                
+                # 255 where the frame just received stands above the floor
+                if frame_id == GROUND_FRAME_ID:
+                    payload = self._receive_exact(depth_size)
+                    if not payload:
+                        break
+                    mask = np.frombuffer(payload, dtype=np.uint8).reshape((depth_height, depth_width))
+                    self.ground_enabled = True
+                    if self.pending_frame is not None and self.pending_frame[0] == timestamp:
+                        self._publish_frame(*self.pending_frame[1:], mask)
+                        self.pending_frame = None
+                    continue
+                
+                # The server had no floor plane for the held frame: no mask is coming
+                if self.pending_frame is not None:
+                    self._publish_frame(*self.pending_frame[1:], None)
+                    self.pending_frame = None
+                
+                
                 # Receive depth data
                 depth_img = None
                 if depth_size > 0:
@@ -400,14 +472,12 @@ class CameraStreamClient:
                         ir_array = np.frombuffer(ir_data, dtype=np.uint8)
                         ir_img = ir_array.reshape((ir_height, ir_width))
                 
-                # Update latest frames with thread safety
-                with self.lock:
-                    self.latest_depth = depth_img
-                    self.latest_rgb = rgb_img
-                    self.latest_ir = ir_img
-                    self.frame_count += 1
-                
-                print(f"\rReceived frame {frame_id:04d} | FPS: {self._get_fps():.1f}", end="", flush=True)
+                # Hold a depth frame back until its ground mask arrived, so it is never
+                # analysed with the floor in it while the mask is still on its way
+                if self.ground_enabled and depth_img is not None:
+                    self.pending_frame = (timestamp, frame_id, depth_img, rgb_img, ir_img)
+                else:
+                    self._publish_frame(frame_id, depth_img, rgb_img, ir_img, None)
                 
             except Exception as e:
                 print(f"\nError in receive loop: {e}")
@@ -415,6 +485,54 @@ class CameraStreamClient:
         
         print("\nReceive loop ended")
     
+    def _publish_frame(self, frame_id: int, depth_img: Optional[np.ndarray],
+                       rgb_img: Optional[np.ndarray], ir_img: Optional[np.ndarray],
+                       ground_mask: Optional[np.ndarray]):
+        """Make a frame and the ground mask computed from it the latest ones"""
+        with self.lock:
+            self.latest_depth = depth_img
+            self.latest_rgb = rgb_img
+            self.latest_ir = ir_img
+            self.latest_ground_mask = ground_mask
+            self.frame_count += 1
+        
+        print(f"\rReceived frame {frame_id:04d} | FPS: {self._get_fps():.1f}", end="", flush=True)
+    
+    def _update_calibration(self, payload: bytes):
+        """Keep the latest StreamCalibration of each camera"""
+        serial, version, width, height, _ = struct.unpack_from('<32s4I', payload)
+        values = struct.unpack_from(f'<{len(CALIBRATION_FIELDS)}f', payload, 48)
+        serial = serial.split(b'\0', 1)[0].decode(errors='replace')
+        with self.lock:
+            self.calibrations[serial] = dict(zip(CALIBRATION_FIELDS, values), version=version, width=width, height=height)
+        print(f"\nCalibration v{version} of {serial} ({width}x{height})")
+    
+    def get_latest_points(self) -> Optional[np.ndarray]:
+        """Latest point cloud as (3, height, width) x, y, z in mm, with ASCAMERA_STREAM_POINTCLOUD=1"""
+        with self.lock:
+            return self.latest_points
+    
+    def get_latest_registered(self) -> Tuple[Optional[np.ndarray], Optional[np.ndarray]]:
+        """Latest depth at RGB resolution and BGR at depth resolution, with ASCAMERA_REGISTER set"""
+        with self.lock:
+            return self.latest_registered_depth, self.latest_registered_rgb
+    
+    def get_latest_ground_mask(self, depth_img: np.ndarray) -> Optional[np.ndarray]:
+        """Mask of pixels above the floor computed from depth_img, with ASCAMERA_GROUND=1
+        
+        Frames are only handed out together with their mask, so this is None only
+        without ASCAMERA_GROUND, while the server has no floor plane, or when
+        depth_img is no longer the latest frame."""
+        with self.lock:
+            if depth_img is not self.latest_depth:
+                return None
+            return self.latest_ground_mask
+    
+    def get_calibrations(self) -> Dict[str, dict]:
+        """Latest camera parameters by serial number"""
+        with self.lock:
+            return dict(self.calibrations)
+    
     def _receive_exact(self, size: int) -> Optional[bytes]:
         """Receive exactly 'size' bytes from socket"""
         data = b''
@@ -436,6 +554,11 @@ class CameraStreamClient:
         with self.lock:
             return self.latest_depth, self.latest_rgb, self.latest_ir
     
+    def get_latest_frames_with_ground(self) -> Tuple[Optional[np.ndarray], Optional[np.ndarray], Optional[np.ndarray], Optional[np.ndarray]]:
+        """Get the latest depth, RGB and IR frames and the ground mask of that depth frame"""
+        with self.lock:
+            return self.latest_depth, self.latest_rgb, self.latest_ir, self.latest_ground_mask
+    
     def _get_fps(self) -> float:
         """Calculate current FPS"""
         elapsed = time.time() - self.start_time
@@ -491,11 +614,11 @@ def main():
         
         while True:
             # Get latest frames
-            depth_img, rgb_img, ir_img = client.get_latest_frames()
+            depth_img, rgb_img, ir_img, ground_mask = client.get_latest_frames_with_ground()
             
             # Perform 3-zone danger detection with TTC calculation
             if depth_img is not None:
-                (left_status, left_dist, left_ttc), (center_status, center_dist, center_ttc), (right_status, right_dist, right_ttc) = analyze_danger_zones(depth_img)
+                (left_status, left_dist, left_ttc), (center_status, center_dist, center_ttc), (right_status, right_dist, right_ttc) = analyze_danger_zones(depth_img, ground_mask)
                 
                 # Check for TTC warnings (4 seconds or under)
                 if audio_manager and audio_manager.audio_enabled:
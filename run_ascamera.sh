@@ -37,5 +37,9 @@ echo "lib path:"${libPath}
 
 log_file=AngstrongsdkLog.txt
 
+# sudo resets the environment, forward the ascamera runtime options by name so
+# values with spaces or glob characters reach ascamera unchanged
+ascamera_options=$(env | sed -n 's/^\(ASCAMERA_[A-Za-z0-9_]*\)=.*/\1/p' | paste -sd, -)
+
 cd $CUR_DIR/build/
-sudo env LD_LIBRARY_PATH=$LD_LIBRARY_PATH:$libPath ./ascamera 2>&1 | tee $log_file
+sudo ${ascamera_options:+"--preserve-env=$ascamera_options"} env LD_LIBRARY_PATH=$LD_LIBRARY_PATH:$libPath ./ascamera 2>&1 | tee $log_file
@@ -0,0 +1,148 @@
+/**
+ * @file      AlertPublisher.cpp
+ * @brief     Compact zone/TTC event stream over UDP or a unix datagram socket
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "AlertPublisher.h"
+#include <chrono>
+#include <cstring>
+#include <errno.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include "Logger.h"
+
+AlertPublisher::AlertPublisher()
+    : m_socket(-1)
+    , m_on_change(false)
+    , m_address_len(0)
+    , m_sent(0)
+    , m_failed(0)
+{
+    memset(&m_address, 0, sizeof(m_address));
+}
+
+AlertPublisher::~AlertPublisher()
+{
+    close();
+}
+
+bool AlertPublisher::open(const std::string &target, bool on_change)
+{
+    close();
+    m_on_change = on_change;
+
+    static const std::string udp = "udp://";
+    static const std::string unix_path = "unix://";
+    if (target.compare(0, udp.size(), udp) == 0) {
+        std::string endpoint = target.substr(udp.size());
+        size_t colon = endpoint.rfind(':');
+        if ((colon == std::string::npos) || (colon + 1 == endpoint.size())) {
+            LOG(ERROR) << "alert target " << target << " needs a port" << std::endl;
+            return false;
+        }
+        std::string host = endpoint.substr(0, colon);
+        std::string port = endpoint.substr(colon + 1);
+
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        struct addrinfo *result = nullptr;
+        if ((getaddrinfo(host.empty() ? "127.0.0.1" : host.c_str(), port.c_str(), &hints, &result) != 0) ||
+            (result == nullptr)) {
+            LOG(ERROR) << "failed to resolve alert target " << target << std::endl;
+            return false;
+        }
+        m_socket = socket(result->ai_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        memcpy(&m_address, result->ai_addr, result->ai_addrlen);
+        m_address_len = result->ai_addrlen;
+        freeaddrinfo(result);
+    } else if (target.compare(0, unix_path.size(), unix_path) == 0) {
+        std::string path = target.substr(unix_path.size());
+        struct sockaddr_un *address = reinterpret_cast<struct sockaddr_un *>(&m_address);
+        if (path.empty() || (path.size() >= sizeof(address->sun_path))) {
+            LOG(ERROR) << "invalid alert socket path " << path << std::endl;
+            return false;
+        }
+        address->sun_family = AF_UNIX;
+        strncpy(address->sun_path, path.c_str(), sizeof(address->sun_path) - 1);
+        m_address_len = sizeof(struct sockaddr_un);
+        m_socket = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    } else {
+        LOG(ERROR) << "unknown alert target " << target << ", use udp://host:port or unix:///path" << std::endl;
+        return false;
+    }
+
+    if (m_socket < 0) {
+        LOG(ERROR) << "failed to create alert socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void AlertPublisher::close()
+{
+    if (m_socket >= 0) {
+        ::close(m_socket);
+        m_socket = -1;
+    }
+}
+
+void AlertPublisher::publish(Channel &channel, const ZoneDangerResult &result)
+{
+    if (m_socket < 0) {
+        return;
+    }
+
+    uint8_t flags[ZONE_COUNT];
+    bool changed = false;
+    for (int i = 0; i < ZONE_COUNT; i++) {
+        const ZoneResult &zone = result.zones[i];
+        flags[i] = (zone.min_depth ? ALERT_ZONE_VALID : 0) | (zone.warn ? ALERT_ZONE_WARN : 0) |
+                   (zone.ttc_warn ? ALERT_ZONE_TTC_WARN : 0);
+        changed = changed || (flags[i] != channel.last_flags[i]);
+    }
+
+    uint64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (m_on_change && !changed && (channel.sequence > 0) && (now - channel.last_sent < KEEPALIVE_MS)) {
+        return;
+    }
+
+    AlertRecord record;
+    memset(&record, 0, sizeof(record));
+    record.magic = ALERT_RECORD_MAGIC;
+    record.version = ALERT_RECORD_VERSION;
+    record.size = sizeof(record);
+    record.camera_id = channel.camera_id;
+    record.frame_id = result.frame_id;
+    record.timestamp = result.timestamp;
+    record.sequence = channel.sequence;
+    strncpy(record.serial, channel.serial.c_str(), sizeof(record.serial) - 1);
+    for (int i = 0; i < ZONE_COUNT; i++) {
+        record.zones[i].min_depth = result.zones[i].min_depth;
+        record.zones[i].flags = flags[i];
+        record.zones[i].velocity = result.zones[i].velocity;
+        record.zones[i].ttc = result.zones[i].ttc;
+    }
+
+    channel.sequence++;
+    channel.last_sent = now;
+    memcpy(channel.last_flags, flags, sizeof(flags));
+
+    ssize_t ret = sendto(m_socket, &record, sizeof(record), MSG_DONTWAIT | MSG_NOSIGNAL,
+                         reinterpret_cast<struct sockaddr *>(&m_address), m_address_len);
+    if (ret == static_cast<ssize_t>(sizeof(record))) {
+        m_sent++;
+    } else {
+        // no listener yet or its queue is full, the next record supersedes this one
+        m_failed++;
+    }
+}
@@ -21,11 +21,19 @@ Camera::Camera(AS_CAM_PTR pCamera, const AS_SDK_CAM_MODEL_E &cam_type)
     m_handle = pCamera;
     m_cam_type = cam_type;
     m_check_fps = new CheckFps(pCamera);
+    m_virtual = findVirtualCamera(pCamera, m_virtual_info);
+    if (m_virtual) {
+        memset(&m_attr, 0, sizeof(m_attr));
+        m_attr.type = AS_CAMERA_ATTR_LNX_USB;
+        strncpy(m_attr.attr.usbAttrs.serial, m_virtual_info.serial.c_str(), sizeof(m_attr.attr.usbAttrs.serial) - 1);
+        strncpy(m_attr.attr.usbAttrs.port_numbers, m_virtual_info.location.c_str(),
+                sizeof(m_attr.attr.usbAttrs.port_numbers) - 1);
+        return;
+    }
     ret = AS_SDK_GetCameraAttrs(m_handle,  m_attr);
     if (ret != 0) {
         LOG(WARN) << "get camera attrs failed" << std::endl;
     }
-    memset(&m_cam_parameter, 0, sizeof(AS_CAM_Parameter_s));
 }
 
 Camera::~Camera()
@@ -34,9 +42,11 @@ Camera::~Camera()
         delete m_check_fps;
         m_check_fps = nullptr;
     }
-    if (m_is_thread) {
+    {
+        std::lock_guard<std::mutex> lock(m_thread_mutex);
         m_is_thread = false;
     }
+    m_thread_cond.notify_one();
     if (m_backgroundThread.joinable()) {
         m_backgroundThread.join();
     }
@@ -45,6 +55,17 @@ Camera::~Camera()
 int Camera::init()
 {
     int ret = 0;
+    if (m_virtual) {
+        /* nothing to query, and no parameters to poll */
+        m_serialno = m_virtual_info.serial;
+        LOG(INFO) << "#camera[" << m_handle << "] SN[" << m_serialno << "] is virtual: " << m_virtual_info.location
+                  << std::endl;
+        createFramePool();
+        if ((m_virtual_info.calibration.version != 0) && (getCalibration() == nullptr)) {
+            publishCalibration(m_virtual_info.calibration);
+        }
+        return 0;
+    }
     char sn_buff[64] = {0};
     ret = AS_SDK_GetSerialNumber(m_handle, sn_buff, sizeof(sn_buff));
     if (ret != 0) {
@@ -58,13 +79,110 @@ int Camera::init()
     if (ret == 0) {
         LOG(INFO) << "#camera[" << m_handle << "] SN[" << m_serialno << "]'s firmware version:" << fwVersion << std::endl;
     }
+    createFramePool();
+
+    if (m_backgroundThread.joinable()) {
+        /* opened again, the stream mode may have changed meanwhile */
+        refreshCalibration();
+        return ret;
+    }
     m_is_thread = true;
+    m_refresh_calibration = true;
     m_backgroundThread = std::thread(&Camera::backgroundThread, this);
     return ret;
 }
 
-double Camera::checkFps()
+void Camera::queryPlaneCapacity()
+{
+    for (int type = 0; type < AS_FRAME_TYPE_BUTT; type++) {
+        m_plane_capacity[type] = 0;
+    }
+    if (m_virtual) {
+        for (int type = 0; type < AS_FRAME_TYPE_BUTT; type++) {
+            m_plane_capacity[type] = m_virtual_info.plane_capacity[type];
+        }
+        return;
+    }
+
+    /* the raw stream param describes the depth sensor (depth and ir) */
+    AS_STREAM_Param_s param;
+    memset(&param, 0, sizeof(param));
+    size_t pixels = 0;
+    if ((AS_SDK_GetStreamParam(m_handle, &param) == 0) && (param.width > 0) && (param.height > 0)) {
+        pixels = static_cast<size_t>(param.width) * param.height;
+        LOG(INFO) << "SN [ " << m_serialno << " ]'s stream param " << param.width << "x" << param.height << std::endl;
+    }
+
+    /* each media type may run another resolution, take the largest it reports */
+    const struct {
+        AS_MEDIA_TYPE_E media;
+        int frame;
+        size_t bytes_per_pixel;
+    } planes[] = {
+        { AS_MEDIA_TYPE_DEPTH, AS_FRAME_TYPE_DEPTH, sizeof(uint16_t) },
+        { AS_MEDIA_TYPE_RGB, AS_FRAME_TYPE_RGB, 3 },
+        { AS_MEDIA_TYPE_IR, AS_FRAME_TYPE_IR, sizeof(uint16_t) },
+    };
+    for (size_t i = 0; i < sizeof(planes) / sizeof(planes[0]); i++) {
+        size_t plane_pixels = (planes[i].media == AS_MEDIA_TYPE_RGB) ? 0 : pixels;
+        std::vector<AS_STREAM_Param_s> capability;
+        if (AS_SDK_GetCapability(m_handle, planes[i].media, capability) == 0) {
+            for (size_t j = 0; j < capability.size(); j++) {
+                if ((capability[j].width > 0) && (capability[j].height > 0)) {
+                    plane_pixels = std::max(plane_pixels, static_cast<size_t>(capability[j].width) * capability[j].height);
+                }
+            }
+        }
+        if ((plane_pixels == 0) && (planes[i].media == AS_MEDIA_TYPE_RGB)) {
+            plane_pixels = pixels;
+        }
+        m_plane_capacity[planes[i].frame] = plane_pixels * planes[i].bytes_per_pixel;
+    }
+}
+
+void Camera::getPlaneCapacity(size_t capacity[AS_FRAME_TYPE_BUTT])
+{
+    for (int type = 0; type < AS_FRAME_TYPE_BUTT; type++) {
+        capacity[type] = m_plane_capacity[type];
+    }
+}
+
+void Camera::createFramePool()
+{
+    m_trace_id = LatencyTracer::registerCamera(m_serialno);
+    queryPlaneCapacity();
+    if (m_plane_capacity[AS_FRAME_TYPE_DEPTH] == 0) {
+        /* planes are sized by the first frame instead */
+        LOG(WARN) << "get stream param failed, frame pool sized on first frame" << std::endl;
+    }
+    m_frame_pool = FramePool::create(FRAME_POOL_SLOTS, m_plane_capacity);
+}
+
+FrameRef Camera::acquireFrame(const AS_SDK_Data_s *pstData, uint64_t arrival_ns)
+{
+    if (!m_frame_pool) {
+        return FrameRef();
+    }
+    FrameRef frame = m_frame_pool->acquire(pstData, m_undistorter.get());
+    if (frame && (arrival_ns != 0)) {
+        FrameTrace trace;
+        trace.camera = m_trace_id;
+        trace.arrival_ns = arrival_ns;
+        trace.enqueue_ns = LatencyTracer::now();
+        frame.setTrace(trace);
+        uint64_t ts = (pstData->depthImg.size > 0) ? pstData->depthImg.ts : pstData->rgbImg.ts;
+        LatencyTracer::recordCapture(m_trace_id, ts);
+        LatencyTracer::record(m_trace_id, LatencyTracer::STAGE_ENQUEUE, trace.enqueue_ns - arrival_ns);
+    }
+    return frame;
+}
+
+double Camera::checkFps(bool log)
 {
+    double fps = m_check_fps->checkFps();
+    if (!log || (fps <= 0)) {
+        return fps;
+    }
     std::string Info = "";
     switch (m_attr.type) {
     case AS_CAMERA_ATTR_LNX_USB:
@@ -80,7 +198,40 @@ double Camera::checkFps()
         LOG(ERROR) << "attr type error" << std::endl;
         break;
     }
-    return m_check_fps->checkFps(m_serialno, Info);
+    LOG(INFO) << "#camera[" << Info << "] SN[" << m_serialno << "]'s FrameRate:" << fps << std::endl;
+    return fps;
+}
+
+void Camera::countFrame(const AS_SDK_Data_s *pstData, uint64_t callback_ns)
+{
+    // single writer, a plain load/store is enough
+    m_frames.store(m_frames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (pstData->depthImg.size > 0) {
+        m_depth_frames.store(m_depth_frames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    m_callback_ns.store(m_callback_ns.load(std::memory_order_relaxed) + callback_ns, std::memory_order_relaxed);
+
+    /* a new stream mode comes with other intrinsics */
+    const AS_Frame_s &depth = pstData->depthImg;
+    if ((depth.size > 0) && ((depth.width != m_depth_width) || (depth.height != m_depth_height))) {
+        bool changed = (m_depth_width != 0);
+        m_depth_width = depth.width;
+        m_depth_height = depth.height;
+        if (changed) {
+            LOG(INFO) << "SN [ " << m_serialno << " ]'s depth stream is now " << depth.width << "x" << depth.height
+                      << ", refreshing the calibration" << std::endl;
+            refreshCalibration();
+        }
+    }
+}
+
+void Camera::getStats(CameraStats &stats)
+{
+    stats.frames = m_frames.load(std::memory_order_relaxed);
+    stats.depth_frames = m_depth_frames.load(std::memory_order_relaxed);
+    stats.callback_ns = m_callback_ns.load(std::memory_order_relaxed);
+    stats.fps = m_check_fps->getFps();
+    stats.pool_exhausted = m_frame_pool ? m_frame_pool->exhaustedCount() : 0;
 }
 
 int Camera::enableSaveImage(bool enable)
@@ -107,6 +258,16 @@ int Camera::getSerialNo(std::string &sn)
     return 0;
 }
 
+AS_SDK_CAM_MODEL_E Camera::getCameraType()
+{
+    return m_cam_type;
+}
+
+bool Camera::isVirtual()
+{
+    return m_virtual;
+}
+
 int Camera::getCameraAttrs(AS_CAM_ATTR_S &info)
 {
     info = m_attr;
@@ -115,49 +276,133 @@ int Camera::getCameraAttrs(AS_CAM_ATTR_S &info)
 
 int Camera::backgroundThread()
 {
-    int ret = 0;
+    // KONDYOR not support to get CamParameter
+    if ((m_cam_type == AS_SDK_CAM_MODEL_KONDYOR_NET) || (m_cam_type == AS_SDK_CAM_MODEL_KONDYOR)) {
+        return 0;
+    }
+
+    /* a control transfer competes with the stream, only fetch when asked to */
+    std::unique_lock<std::mutex> lock(m_thread_mutex);
     while (m_is_thread) {
-        // KONDYOR not support to get CamParameter, KUNLUN A don't need to get CamParameter
-        if ((m_cam_type != AS_SDK_CAM_MODEL_KONDYOR_NET) && (m_cam_type != AS_SDK_CAM_MODEL_KONDYOR)) {
-            ret = AS_SDK_GetCamParameter(m_handle, &m_cam_parameter);
-            if (ret == 0) {
-                LOG(INFO) << "SN [ " << m_serialno << " ]'s parameter:" << std::endl;
-                LOG(INFO) << "irfx: " << m_cam_parameter.fxir << std::endl;
-                LOG(INFO) << "irfy: " << m_cam_parameter.fyir << std::endl;
-                LOG(INFO) << "ircx: " << m_cam_parameter.cxir << std::endl;
-                LOG(INFO) << "ircy: " << m_cam_parameter.cyir << std::endl;
-                LOG(INFO) << "rgbfx: " << m_cam_parameter.fxrgb << std::endl;
-                LOG(INFO) << "rgbfy: " << m_cam_parameter.fyrgb << std::endl;
-                LOG(INFO) << "rgbcx: " << m_cam_parameter.cxrgb << std::endl;
-                LOG(INFO) << "rgbcy: " << m_cam_parameter.cyrgb << std::endl << std::endl;
-
-                LOG(INFO) << "R00: " << m_cam_parameter.R00 << std::endl;
-                LOG(INFO) << "R01: " << m_cam_parameter.R01 << std::endl;
-                LOG(INFO) << "R02: " << m_cam_parameter.R02 << std::endl;
-                LOG(INFO) << "R10: " << m_cam_parameter.R10 << std::endl;
-                LOG(INFO) << "R11: " << m_cam_parameter.R11 << std::endl;
-                LOG(INFO) << "R12: " << m_cam_parameter.R12 << std::endl;
-                LOG(INFO) << "R20: " << m_cam_parameter.R20 << std::endl;
-                LOG(INFO) << "R21: " << m_cam_parameter.R21 << std::endl;
-                LOG(INFO) << "R22: " << m_cam_parameter.R22 << std::endl;
-                LOG(INFO) << "T1: " << m_cam_parameter.T1 << std::endl;
-                LOG(INFO) << "T2: " << m_cam_parameter.T2 << std::endl;
-                LOG(INFO) << "T3: " << m_cam_parameter.T3 << std::endl << std::endl;
-
-                m_is_thread = false;
-                break;
-            }
-        } else {
-            m_is_thread = false;
-            break;
+        if (!m_refresh_calibration) {
+            m_thread_cond.wait(lock);
+            continue;
+        }
+        m_refresh_calibration = false;
+        lock.unlock();
+        CameraCalibration calibration;
+        bool ok = fetchCalibration(calibration);
+        if (ok) {
+            publishCalibration(calibration);
+        }
+        lock.lock();
+        if (!ok) {
+            /* the camera may not answer yet right after open, retry once a second */
+            m_refresh_calibration = true;
+            m_thread_cond.wait_for(lock, std::chrono::seconds(1));
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
     }
     return 0;
 }
 
-void Camera::saveImage(const AS_SDK_Data_s *pstData)
+bool Camera::fetchCalibration(CameraCalibration &calibration)
+{
+    memset(&calibration, 0, sizeof(calibration));
+    if (AS_SDK_GetCamParameter(m_handle, &calibration.parameter) != 0) {
+        return false;
+    }
+    AS_STREAM_Param_s param;
+    memset(&param, 0, sizeof(param));
+    if (AS_SDK_GetStreamParam(m_handle, &param) == 0) {
+        calibration.width = param.width;
+        calibration.height = param.height;
+    }
+    return true;
+}
+
+void Camera::publishCalibration(const CameraCalibration &calibration)
+{
+    std::unique_ptr<CameraCalibration> snapshot(new CameraCalibration(calibration));
+    snapshot->version = m_calibrations.empty() ? 1 : m_calibrations.back()->version + 1;
+    logCalibration(*snapshot);
+    if (m_undistorter) {
+        /* the undistorter keeps the lens model, consumers get that of the rectified frames */
+        std::unique_ptr<CameraCalibration> lens(new CameraCalibration(*snapshot));
+        m_undistorter->setCalibration(lens.get());
+        m_calibrations.push_back(std::move(lens));
+        FrameUndistorter::removeDistortion(*snapshot);
+    }
+    /* older snapshots may still be read, they are freed with the camera */
+    m_calibration.store(snapshot.get(), std::memory_order_release);
+    m_calibrations.push_back(std::move(snapshot));
+    if (m_calibration_callback) {
+        m_calibration_callback(m_serialno, *m_calibrations.back());
+    }
+}
+
+void Camera::logCalibration(const CameraCalibration &calibration)
+{
+    const AS_CAM_Parameter_s &p = calibration.parameter;
+    LOG(INFO) << "SN [ " << m_serialno << " ]'s parameter v" << calibration.version << " (" << calibration.width << "x"
+              << calibration.height << ") ir fx " << p.fxir << " fy " << p.fyir << " cx " << p.cxir << " cy " << p.cyir
+              << " k " << p.K1ir << " " << p.K2ir << " " << p.K3ir << " p " << p.P1ir << " " << p.P2ir << std::endl;
+    LOG(INFO) << "SN [ " << m_serialno << " ]'s parameter v" << calibration.version << " rgb fx " << p.fxrgb << " fy "
+              << p.fyrgb << " cx " << p.cxrgb << " cy " << p.cyrgb << " k " << p.K1rgb << " " << p.K2rgb << " "
+              << p.K3rgb << " p " << p.P1rgb << " " << p.P2rgb << std::endl;
+    LOG(INFO) << "SN [ " << m_serialno << " ]'s parameter v" << calibration.version << " R [" << p.R00 << " " << p.R01
+              << " " << p.R02 << "; " << p.R10 << " " << p.R11 << " " << p.R12 << "; " << p.R20 << " " << p.R21 << " "
+              << p.R22 << "] T [" << p.T1 << " " << p.T2 << " " << p.T3 << "]" << std::endl;
+}
+
+const CameraCalibration *Camera::getCalibration() const
 {
+    return m_calibration.load(std::memory_order_acquire);
+}
+
+void Camera::refreshCalibration()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_thread_mutex);
+        if (!m_is_thread) {
+            /* virtual cameras keep what they were registered with */
+            return;
+        }
+        m_refresh_calibration = true;
+    }
+    m_thread_cond.notify_one();
+}
+
+void Camera::setCalibrationCallback(const CalibrationCallback &callback)
+{
+    m_calibration_callback = callback;
+}
+
+void Camera::enableUndistortion(bool enable)
+{
+    if (enable) {
+        m_undistorter.reset(new FrameUndistorter());
+    } else {
+        m_undistorter.reset();
+    }
+}
+
+void Camera::setImageWriter(const std::shared_ptr<ImageWriter> &writer)
+{
+    m_writer = writer;
+}
+
+void Camera::queueImage(const std::string &name, const FrameRef &frame, const void *data, size_t size)
+{
+    if (!m_writer) {
+        LOG(ERROR) << "no image writer, " << name << " not saved" << std::endl;
+        return;
+    }
+    m_writer->writeRaw(name, frame, data, size);
+}
+
+void Camera::saveImage(const FrameRef &frame)
+{
+    TraceScope trace("saveImage");
     if (!m_save_img) {
         m_cnt = 0;
         return;
@@ -172,138 +417,77 @@ void Camera::saveImage(const AS_SDK_Data_s *pstData)
         m_save_img = false;
     }
 
+    /* only queued here, the image writer thread does the file I/O */
+    const AS_SDK_Data_s *pstData = frame.data();
     if (pstData->depthImg.size > 0) {
         std::string depthimgName(std::string(m_serialno + "_depth_") + std::to_string(
                                      pstData->depthImg.width) + "x" + std::to_string(pstData->depthImg.height)
                                  + "_" + std::to_string(m_depthindex++) + ".yuv");
-        if (saveYUVImg(depthimgName.c_str(), pstData->depthImg.data, pstData->depthImg.size) != 0) {
-            LOG(ERROR) << "save depth image failed!" << std::endl;
-        } else {
-            LOG(INFO) << "save depth image success!" << std::endl;
-#ifdef __linux__
-            LOG(INFO) << "location: " << getcwd(nullptr, 0) << "/" << depthimgName << std::endl;
-#endif
-        }
+        queueImage(depthimgName, frame, pstData->depthImg.data, pstData->depthImg.size);
     }
 
     if (pstData->rgbImg.size > 0) {
         std::string rgbName(std::string(m_serialno + "_rgb_") + std::to_string(pstData->rgbImg.width) + "x" +
                             std::to_string(pstData->rgbImg.height) + "_" + std::to_string(m_rgbindex++) + ".yuv");
-        if (saveYUVImg(rgbName.c_str(), pstData->rgbImg.data, pstData->rgbImg.size) != 0) {
-            LOG(ERROR) << "save rgb image failed!" << std::endl;
-        } else {
-            LOG(INFO) << "save rgb image success!" << std::endl;
-#ifdef __linux__
-            LOG(INFO) << "location: " << getcwd(nullptr, 0) << "/" << rgbName << std::endl;
-#endif
-        }
+        queueImage(rgbName, frame, pstData->rgbImg.data, pstData->rgbImg.size);
     }
 
     if (pstData->yuyvImg.size > 0) {
         std::string yuyvName(std::string(m_serialno + "_yuyv_") + std::to_string(pstData->yuyvImg.width) + "x" +
                              std::to_string(pstData->yuyvImg.height) + "_" + std::to_string(m_yuyvindex++) + ".yuv");
-        if (saveYUVImg(yuyvName.c_str(), pstData->yuyvImg.data, pstData->yuyvImg.size) != 0) {
-            LOG(ERROR) << "save yuyv image failed!" << std::endl;
-        } else {
-            LOG(INFO) << "save yuyv image success!" << std::endl;
-#ifdef __linux__
-            LOG(INFO) << "location: " << getcwd(nullptr, 0) << "/" << yuyvName << std::endl;
-#endif
-        }
+        queueImage(yuyvName, frame, pstData->yuyvImg.data, pstData->yuyvImg.size);
     }
 
-    if (pstData->pointCloud.size > 0) {
+    if ((pstData->pointCloud.size > 0) && m_writer) {
         std::string pointCloudName(std::string(m_serialno + "_PointCloud_"  + std::to_string(
                 pstData->pointCloud.width) + "x" + std::to_string(pstData->pointCloud.height)
                                                + "_"  + std::to_string(m_pointCloudIndex++) + ".pcd"));
-        if (savePointCloudWithPcdFormat(pointCloudName.c_str(), static_cast<float *>(pstData->pointCloud.data),
-                                        pstData->pointCloud.size / sizeof(float)) != 0) {
-            LOG(ERROR) << "save point cloud failed!" << std::endl;
-        } else {
-            LOG(INFO) << "save point cloud success!" << std::endl;
-#ifdef __linux__
-            LOG(INFO) << "location: " << getcwd(nullptr, 0) << "/" << pointCloudName << std::endl;
-#endif
-        }
+        m_writer->writePointCloud(pointCloudName, frame, static_cast<const float *>(pstData->pointCloud.data),
+                                  pstData->pointCloud.size / sizeof(float));
     }
 
     if (pstData->irImg.size > 0) {
         std::string irimgName(std::string(m_serialno + "_ir_" + std::to_string(pstData->irImg.width) + "x" +
                                           std::to_string(pstData->irImg.height) + "_" + std::to_string(m_irindex++) + ".yuv"));
-        if (saveYUVImg(irimgName.c_str(), pstData->irImg.data, pstData->irImg.size) != 0) {
-            LOG(ERROR) << "save ir image failed!" << std::endl;
-        } else {
-            LOG(INFO) << "save ir image success!" << std::endl;
-#ifdef __linux__
-            LOG(INFO) << "location: " << getcwd(nullptr, 0) << "/" << irimgName << std::endl;
-#endif
-        }
+        queueImage(irimgName, frame, pstData->irImg.data, pstData->irImg.size);
     }
 
     if (pstData->peakImg.size > 0) {
         std::string peakimgName(std::string(m_serialno + "_peak_") + std::to_string(
                                     pstData->peakImg.width) + "x" + std::to_string(pstData->peakImg.height)
                                 + "_" + std::to_string(m_peakindex++) + ".yuv");
-        if (saveYUVImg(peakimgName.c_str(), pstData->peakImg.data, pstData->peakImg.size) != 0) {
-            LOG(ERROR) << "save peak image failed!" << std::endl;
-        } else {
-            LOG(INFO) << "save peak image success!" << std::endl;
-#ifdef __linux__
-            LOG(INFO) << "location: " << getcwd(nullptr, 0) << "/" << peakimgName << std::endl;
-#endif
-        }
+        queueImage(peakimgName, frame, pstData->peakImg.data, pstData->peakImg.size);
     }
 
     if (pstData->mjpegImg.size > 0) {
         std::string mjpegimgName(std::string(m_serialno + "_mjpeg_") + std::to_string(
                                      pstData->mjpegImg.width) + "x" + std::to_string(pstData->mjpegImg.height)
                                  + "_" + std::to_string(m_mjpegindex++) + ".jpg");
-        if (saveYUVImg(mjpegimgName.c_str(), pstData->mjpegImg.data, pstData->mjpegImg.size) != 0) {
-            LOG(ERROR) << "save mjpeg image failed!" << std::endl;
-        } else {
-            LOG(INFO) << "save mjpeg image success!" << std::endl;
-#ifdef __linux__
-            LOG(INFO) << "location: " << getcwd(nullptr, 0) << "/" << mjpegimgName << std::endl;
-#endif
-        }
+        queueImage(mjpegimgName, frame, pstData->mjpegImg.data, pstData->mjpegImg.size);
     }
 
     return;
 }
-
 void Camera::saveMergeImage(const AS_SDK_MERGE_s *pstData)
 {
     if (!m_save_merge_img) {
         return;
     }
     m_save_merge_img = false;
+    /* merge frames are not pooled, the writer copies them into its own buffers */
     if (pstData->depthImg.size > 0) {
         std::string depthimgName(std::string(m_serialno + "_depth_merge_") + std::to_string(
                                      pstData->depthImg.width) + "x" + std::to_string(pstData->depthImg.height)
                                  + "_" + std::to_string(m_depthindex++) + ".yuv");
-        if (saveYUVImg(depthimgName.c_str(), pstData->depthImg.data, pstData->depthImg.size) != 0) {
-            LOG(ERROR) << "save depth image failed!" << std::endl;
-        } else {
-            LOG(INFO) << "save depth image success!" << std::endl;
-#ifdef __linux__
-            LOG(INFO) << "location: " << getcwd(nullptr, 0) << "/" << depthimgName << std::endl;
-#endif
-        }
+        queueImage(depthimgName, FrameRef(), pstData->depthImg.data, pstData->depthImg.size);
     }
 
-    if (pstData->pointCloud.size > 0) {
+    if ((pstData->pointCloud.size > 0) && m_writer) {
         std::string pointCloudName(std::string(m_serialno + "_PointCloud_merge_"  + std::to_string(
                 pstData->pointCloud.width) + "x" + std::to_string(pstData->pointCloud.height)
                                                + "_"  + std::to_string(m_pointCloudIndex++) + ".pcd"));
-        if (savePointCloudWithPcdFormat(pointCloudName.c_str(), static_cast<float *>(pstData->pointCloud.data),
-                                        pstData->pointCloud.size / sizeof(float)) != 0) {
-            LOG(ERROR) << "save point cloud failed!" << std::endl;
-        } else {
-            LOG(INFO) << "save point cloud success!" << std::endl;
-#ifdef __linux__
-            LOG(INFO) << "location: " << getcwd(nullptr, 0) << "/" << pointCloudName << std::endl;
-#endif
-        }
+        m_writer->writePointCloud(pointCloudName, FrameRef(), static_cast<const float *>(pstData->pointCloud.data),
+                                  pstData->pointCloud.size / sizeof(float));
     }
 
     return;
@@ -311,6 +495,7 @@ void Camera::saveMergeImage(const AS_SDK_MERGE_s *pstData)
 
 void Camera::displayImage(const std::string &serialno, const std::string &info, const AS_SDK_Data_s *pstData)
 {
+    TraceScope trace("displayImage");
 #ifdef CFG_OPENCV_ON
     if (m_display) {
         if (pstData->irImg.size > 0) {
@@ -0,0 +1,121 @@
+/**
+ * @file      CameraPipeline.cpp
+ * @brief     Per-camera worker threads fed from the SDK frame callback
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "CameraPipeline.h"
+#include <pthread.h>
+#include "Logger.h"
+#include "EventTracer.h"
+
+CameraPipeline::CameraPipeline(const std::string &name, bool threaded)
+    : m_name(name)
+    , m_threaded(threaded)
+    , m_running(false)
+{
+}
+
+CameraPipeline::~CameraPipeline()
+{
+    stop();
+}
+
+void CameraPipeline::addSink(const std::string &name, size_t depth, const Sink &sink)
+{
+    if (m_running) {
+        LOG(ERROR) << "sink " << name << " added to a running pipeline" << std::endl;
+        return;
+    }
+    std::unique_ptr<Worker> worker(new Worker());
+    worker->name = name;
+    worker->sink = sink;
+    worker->queue.reset(new FrameQueue(depth));
+    worker->trace_name = EventTracer::intern(name);
+    worker->processed = 0;
+    m_workers.push_back(std::move(worker));
+}
+
+void CameraPipeline::start()
+{
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    for (size_t i = 0; (i < m_workers.size()) && m_threaded; i++) {
+        m_workers[i]->thread = std::thread(&CameraPipeline::workerThread, this, m_workers[i].get());
+    }
+}
+
+void CameraPipeline::stop()
+{
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        m_workers[i]->queue->close();
+    }
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        if (m_workers[i]->thread.joinable()) {
+            m_workers[i]->thread.join();
+        }
+    }
+    logStats();
+}
+
+void CameraPipeline::push(const FrameRef &frame)
+{
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        Worker &worker = *m_workers[i];
+        if (m_threaded) {
+            worker.queue->push(frame);
+        } else if (m_running) {
+            worker.sink(frame);
+            worker.processed++;
+        }
+    }
+}
+
+void CameraPipeline::logStats()
+{
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        const Worker &worker = *m_workers[i];
+        LOG(INFO) << "pipeline [ " << m_name << " ] sink " << worker.name << ": processed " << worker.processed
+                  << ", dropped " << worker.queue->droppedCount() << std::endl;
+    }
+}
+
+void CameraPipeline::getSinkStats(std::vector<SinkStats> &stats)
+{
+    stats.resize(m_workers.size());
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        const Worker &worker = *m_workers[i];
+        stats[i].name = worker.name;
+        stats[i].processed = worker.processed;
+        stats[i].dropped = worker.queue->droppedCount();
+        stats[i].queued = worker.queue->size();
+        stats[i].depth = worker.queue->capacity();
+    }
+}
+
+void CameraPipeline::workerThread(Worker *worker)
+{
+    // thread names are limited to 15 characters
+    pthread_setname_np(pthread_self(), worker->name.substr(0, 15).c_str());
+
+    FrameRef frame;
+    while (worker->queue->pop(frame, -1)) {
+        EventTracer::begin(worker->trace_name);
+        worker->sink(frame);
+        // release the slot before sleeping, the pool is shared by every sink
+        frame.reset();
+        EventTracer::end(worker->trace_name);
+        worker->processed++;
+    }
+}
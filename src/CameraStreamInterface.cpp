@@ -0,0 +1,760 @@
+#include "CameraStreamInterface.h"
+#include <iostream>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <climits>
+#include <time.h>
+
+/* keep slots and planes cache line aligned */
+static const size_t SHM_ALIGN = 64;
+
+static size_t alignUp(size_t value)
+{
+    return (value + SHM_ALIGN - 1) & ~(SHM_ALIGN - 1);
+}
+
+/* shared (not private) futex ops, the word lives in memory mapped by several processes */
+static long futexWait(std::atomic<uint32_t>* word, uint32_t expected, const struct timespec* timeout)
+{
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+static void futexWake(std::atomic<uint32_t>* word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+CameraStreamInterface::CameraStreamInterface()
+    : shared_memory_(nullptr)
+    , layout_(nullptr)
+    , shared_memory_size_(0)
+    , shared_memory_fd_(-1)
+    , shared_memory_dev_(0)
+    , shared_memory_ino_(0)
+    , owner_(false)
+    , generation_(0)
+    , active_(false)
+    , has_current_(false)
+{
+    memset(&view_, 0, sizeof(view_));
+    memset(&current_, 0, sizeof(current_));
+    memset(&replaced_check_, 0, sizeof(replaced_check_));
+}
+
+CameraStreamInterface::~CameraStreamInterface()
+{
+    shutdown();
+}
+
+bool CameraStreamInterface::mapRegion(size_t size, bool writable)
+{
+    if (shared_memory_ != nullptr) {
+        munmap(shared_memory_, shared_memory_size_);
+        shared_memory_ = nullptr;
+        layout_ = nullptr;
+    }
+
+    int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* memory = mmap(nullptr, size, prot, MAP_SHARED, shared_memory_fd_, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory /" << shared_memory_name_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    shared_memory_ = memory;
+    shared_memory_size_ = size;
+    layout_ = static_cast<SharedMemoryLayout*>(memory);
+    return true;
+}
+
+void CameraStreamInterface::buildLayout(const uint32_t plane_capacity[PLANE_COUNT])
+{
+    size_t offset = alignUp(sizeof(SlotHeader));
+    view_.slot_count = SLOT_COUNT;
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        view_.plane_offset[i] = offset;
+        view_.plane_capacity[i] = alignUp(plane_capacity[i]);
+        offset += view_.plane_capacity[i];
+    }
+    view_.slot_stride = offset;
+}
+
+bool CameraStreamInterface::initialize(const std::string& shared_memory_name, const uint32_t* plane_capacity)
+{
+    if (active_) {
+        return true;
+    }
+
+    uint32_t capacity[PLANE_COUNT] = { 0, 0, 0 };
+    if (plane_capacity != nullptr) {
+        memcpy(capacity, plane_capacity, sizeof(capacity));
+    }
+    buildLayout(capacity);
+    size_t size = alignUp(sizeof(SharedMemoryLayout)) + static_cast<size_t>(view_.slot_stride) * view_.slot_count;
+
+    shared_memory_name_ = shared_memory_name;
+    std::string path = "/" + shared_memory_name;
+    // Never reuse a region from a previous run: readers may still map it, and
+    // truncating it under them would fault them. Its readers re-attach.
+    shm_unlink(path.c_str());
+    shared_memory_fd_ = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (shared_memory_fd_ < 0) {
+        std::cerr << "Failed to create shared memory " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    // readers usually run as a normal user while ascamera runs under sudo
+    fchmod(shared_memory_fd_, 0644);
+    if (ftruncate(shared_memory_fd_, size) < 0) {
+        std::cerr << "Failed to size shared memory " << path << ": " << strerror(errno) << std::endl;
+        close(shared_memory_fd_);
+        shared_memory_fd_ = -1;
+        shm_unlink(path.c_str());
+        return false;
+    }
+    if (!mapRegion(size, true)) {
+        close(shared_memory_fd_);
+        shared_memory_fd_ = -1;
+        shm_unlink(path.c_str());
+        return false;
+    }
+
+    layout_->slot_count = view_.slot_count;
+    layout_->region_size = size;
+    layout_->slot_stride = view_.slot_stride;
+    memcpy(layout_->plane_offset, view_.plane_offset, sizeof(view_.plane_offset));
+    memcpy(layout_->plane_capacity, view_.plane_capacity, sizeof(view_.plane_capacity));
+    layout_->generation.store(0, std::memory_order_relaxed);
+    layout_->frame_count.store(0, std::memory_order_relaxed);
+    layout_->version = VERSION;
+    // readers check the magic last, publish it after everything else
+    std::atomic_thread_fence(std::memory_order_release);
+    layout_->magic = MAGIC;
+
+    generation_ = 0;
+    owner_ = true;
+    active_ = true;
+    return true;
+}
+
+bool CameraStreamInterface::growRegion(const uint32_t plane_size[PLANE_COUNT])
+{
+    uint32_t capacity[PLANE_COUNT];
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        capacity[i] = std::max(view_.plane_capacity[i], plane_size[i]);
+    }
+    LayoutView old_view = view_;
+    buildLayout(capacity);
+    size_t size = alignUp(sizeof(SharedMemoryLayout)) + static_cast<size_t>(view_.slot_stride) * view_.slot_count;
+    if (size > shared_memory_size_) {
+        // Only ever grow: readers keep the old mapping until they remap, and a
+        // shrunk file would fault them on the pages past the new end.
+        if (ftruncate(shared_memory_fd_, size) < 0) {
+            std::cerr << "Failed to grow shared memory /" << shared_memory_name_ << ": " << strerror(errno) << std::endl;
+            view_ = old_view;
+            return false;
+        }
+    }
+    if (!mapRegion(std::max(size, shared_memory_size_), true)) {
+        active_ = false;
+        return false;
+    }
+
+    layout_->region_size = shared_memory_size_;
+    layout_->slot_stride = view_.slot_stride;
+    memcpy(layout_->plane_offset, view_.plane_offset, sizeof(view_.plane_offset));
+    memcpy(layout_->plane_capacity, view_.plane_capacity, sizeof(view_.plane_capacity));
+    for (uint32_t i = 0; i < view_.slot_count; i++) {
+        memset(static_cast<void*>(slotAt(i)), 0, sizeof(SlotHeader));
+    }
+
+    std::cout << "Shared memory /" << shared_memory_name_ << " resized to " << shared_memory_size_ << " bytes" << std::endl;
+    return true;
+}
+
+bool CameraStreamInterface::readLayout(uint32_t generation)
+{
+    LayoutView view;
+    view.slot_count = layout_->slot_count;
+    view.slot_stride = layout_->slot_stride;
+    memcpy(view.plane_offset, layout_->plane_offset, sizeof(view.plane_offset));
+    memcpy(view.plane_capacity, layout_->plane_capacity, sizeof(view.plane_capacity));
+    uint64_t region_size = layout_->region_size;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (layout_->generation.load(std::memory_order_relaxed) != generation) {
+        // resized again while we were reading
+        return false;
+    }
+
+    if ((view.slot_count == 0) || (region_size > shared_memory_size_) ||
+        (alignUp(sizeof(SharedMemoryLayout)) + static_cast<size_t>(view.slot_stride) * view.slot_count > shared_memory_size_)) {
+        return false;
+    }
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        if (static_cast<size_t>(view.plane_offset[i]) + view.plane_capacity[i] > view.slot_stride) {
+            return false;
+        }
+    }
+    view_ = view;
+    generation_ = generation;
+    return true;
+}
+
+bool CameraStreamInterface::remap()
+{
+    uint32_t generation = layout_->generation.load(std::memory_order_acquire);
+    if (generation & 1) {
+        // writer is resizing, try again on the next call
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(shared_memory_fd_, &st) < 0) {
+        return false;
+    }
+    if (static_cast<size_t>(st.st_size) != shared_memory_size_) {
+        if (!mapRegion(st.st_size, false)) {
+            active_ = false;
+            return false;
+        }
+    }
+    has_current_ = false;
+    return readLayout(generation);
+}
+
+bool CameraStreamInterface::attach(const std::string& shared_memory_name)
+{
+    if (active_) {
+        return true;
+    }
+
+    shared_memory_name_ = shared_memory_name;
+    std::string path = "/" + shared_memory_name;
+    shared_memory_fd_ = shm_open(path.c_str(), O_RDONLY, 0);
+    if (shared_memory_fd_ < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if ((fstat(shared_memory_fd_, &st) < 0) || (static_cast<size_t>(st.st_size) < sizeof(SharedMemoryLayout)) ||
+        !mapRegion(st.st_size, false)) {
+        close(shared_memory_fd_);
+        shared_memory_fd_ = -1;
+        return false;
+    }
+
+    bool valid = (layout_->magic == MAGIC) && (layout_->version == VERSION);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // a resize may be under way, the first getLatestFrame() remaps then
+    generation_ = ~0u;
+    if (!valid) {
+        std::cerr << "Shared memory " << path << " has an unknown layout" << std::endl;
+        munmap(shared_memory_, shared_memory_size_);
+        shared_memory_ = nullptr;
+        layout_ = nullptr;
+        close(shared_memory_fd_);
+        shared_memory_fd_ = -1;
+        return false;
+    }
+
+    shared_memory_dev_ = st.st_dev;
+    shared_memory_ino_ = st.st_ino;
+    clock_gettime(CLOCK_MONOTONIC, &replaced_check_);
+    owner_ = false;
+    has_current_ = false;
+    active_ = true;
+    remap();
+    return true;
+}
+
+bool CameraStreamInterface::reattachIfReplaced()
+{
+    if (owner_ || !active_) {
+        return false;
+    }
+    // a cleared magic means the writer shut down, check for its successor right away
+    bool closed = layout_->magic != MAGIC;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (!closed && (now.tv_sec - replaced_check_.tv_sec < 1)) {
+        return false;
+    }
+
+    std::string path = "/" + shared_memory_name_;
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        replaced_check_ = now;
+        return false;
+    }
+    struct stat st;
+    bool replaced = (fstat(fd, &st) == 0) && ((st.st_dev != shared_memory_dev_) || (st.st_ino != shared_memory_ino_));
+    bool ready = false;
+    if (replaced && (static_cast<size_t>(st.st_size) >= sizeof(SharedMemoryLayout))) {
+        // switch only once the new writer has published its layout
+        void* memory = mmap(nullptr, sizeof(SharedMemoryLayout), PROT_READ, MAP_SHARED, fd, 0);
+        if (memory != MAP_FAILED) {
+            const SharedMemoryLayout* layout = static_cast<const SharedMemoryLayout*>(memory);
+            ready = (layout->magic == MAGIC) && (layout->version == VERSION);
+            munmap(memory, sizeof(SharedMemoryLayout));
+        }
+    }
+    close(fd);
+    if (!replaced) {
+        replaced_check_ = now;
+        return false;
+    }
+    if (!ready) {
+        return false;
+    }
+
+    std::string name = shared_memory_name_;
+    shutdown();
+    std::cout << "Shared memory " << path << " was recreated, attaching again" << std::endl;
+    attach(name);
+    return true;
+}
+
+CameraStreamInterface::SlotHeader* CameraStreamInterface::slotAt(uint32_t index) const
+{
+    uint8_t* base = static_cast<uint8_t*>(shared_memory_) + alignUp(sizeof(SharedMemoryLayout));
+    return reinterpret_cast<SlotHeader*>(base + static_cast<size_t>(view_.slot_stride) * index);
+}
+
+uint8_t* CameraStreamInterface::planeAt(uint32_t index, int plane) const
+{
+    return reinterpret_cast<uint8_t*>(slotAt(index)) + view_.plane_offset[plane];
+}
+
+void CameraStreamInterface::updateFrame(const void* depth_data, uint32_t depth_size,
+                                        const void* rgb_data, uint32_t rgb_size,
+                                        const void* ir_data, uint32_t ir_size,
+                                        const uint32_t width[PLANE_COUNT], const uint32_t height[PLANE_COUNT],
+                                        uint64_t timestamp)
+{
+    if (!active_ || !owner_) {
+        return;
+    }
+
+    const void* planes[PLANE_COUNT] = { depth_data, rgb_data, ir_data };
+    uint32_t sizes[PLANE_COUNT] = { depth_size, rgb_size, ir_size };
+    bool resize = false;
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        if (planes[i] == nullptr) {
+            sizes[i] = 0;
+        }
+        if (sizes[i] > view_.plane_capacity[i]) {
+            resize = true;
+        }
+    }
+
+    // The generation stays odd until the first frame of the new layout is in
+    // place, so readers never see the cleared slots.
+    uint32_t generation = layout_->generation.load(std::memory_order_relaxed);
+    if (resize) {
+        layout_->generation.store(generation + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        if (!growRegion(sizes)) {
+            if (active_) {
+                layout_->generation.store(generation, std::memory_order_release);
+            }
+            return;
+        }
+    }
+
+    uint32_t frame = layout_->frame_count.load(std::memory_order_relaxed);
+    uint32_t index = frame % view_.slot_count;
+    SlotHeader* slot = slotAt(index);
+
+    // Seqlock write: odd while the slot is inconsistent, readers retry or skip
+    uint32_t sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->timestamp = timestamp;
+    slot->frame_id = frame + 1;
+    for (int i = 0; i < PLANE_COUNT; i++) {
+        if (sizes[i] > 0) {
+            memcpy(planeAt(index, i), planes[i], sizes[i]);
+        }
+        slot->plane_size[i] = sizes[i];
+        slot->plane_width[i] = width[i];
+        slot->plane_height[i] = height[i];
+        // compressed planes (MJPEG) are not a whole number of bytes per pixel
+        uint64_t pixels = static_cast<uint64_t>(width[i]) * height[i];
+        slot->plane_bytes_per_pixel[i] = ((pixels > 0) && (sizes[i] % pixels == 0)) ? sizes[i] / pixels : 0;
+    }
+
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+    layout_->frame_count.store(frame + 1, std::memory_order_release);
+    if (resize) {
+        generation_ = generation + 2;
+        layout_->generation.store(generation_, std::memory_order_release);
+    }
+    // Readers map the region read only and cannot register as waiters, so
+    // wake unconditionally; with nobody waiting this is a cheap syscall per frame.
+    futexWake(&layout_->frame_count);
+}
+
+bool CameraStreamInterface::waitForFrame(uint32_t frame_id, int timeout_ms)
+{
+    if (!active_) {
+        return false;
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    if (timeout_ms > 0) {
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += static_cast<long>(timeout_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    while (active_) {
+        if (reattachIfReplaced()) {
+            // a new writer numbers its frames from 1 again
+            frame_id = 0;
+            if (!active_) {
+                return false;
+            }
+        }
+        uint32_t count = layout_->frame_count.load(std::memory_order_acquire);
+        // frame ids wrap, compare as a distance
+        if (static_cast<int32_t>(count - frame_id) > 0) {
+            return true;
+        }
+        if (timeout_ms == 0) {
+            return false;
+        }
+
+        // sleep at most a second, a writer that went away never wakes us
+        struct timespec slice = { 1, 0 };
+        if (timeout_ms > 0) {
+            struct timespec remaining;
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+            remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (remaining.tv_nsec < 0) {
+                remaining.tv_sec--;
+                remaining.tv_nsec += 1000000000;
+            }
+            if (remaining.tv_sec < 0) {
+                return false;
+            }
+            if (remaining.tv_sec < 1) {
+                slice = remaining;
+            }
+        }
+        // ETIMEDOUT, EAGAIN (a frame landed before we slept) and EINTR all just re-check
+        futexWait(&layout_->frame_count, count, &slice);
+    }
+    return false;
+}
+
+bool CameraStreamInterface::getLatestFrame(StreamFrameData& frame_data)
+{
+    reattachIfReplaced();
+    if (!active_) {
+        return false;
+    }
+
+    // The writer may lap us between reading frame_count and the slot, retry
+    for (int attempt = 0; attempt < 8; attempt++) {
+        if (!owner_ && (layout_->generation.load(std::memory_order_acquire) != generation_)) {
+            if (!remap()) {
+                return false;
+            }
+        }
+
+        uint32_t count = layout_->frame_count.load(std::memory_order_acquire);
+        if (count == 0) {
+            return false;
+        }
+        uint32_t index = (count - 1) % view_.slot_count;
+        SlotHeader* slot = slotAt(index);
+
+        uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) {
+            continue;
+        }
+
+        StreamFrameData data;
+        memset(&data, 0, sizeof(data));
+        data.timestamp = slot->timestamp;
+        data.frame_id = slot->frame_id;
+        for (int i = 0; i < PLANE_COUNT; i++) {
+            data.plane_width[i] = slot->plane_width[i];
+            data.plane_height[i] = slot->plane_height[i];
+            data.plane_bytes_per_pixel[i] = slot->plane_bytes_per_pixel[i];
+        }
+        data.width = data.plane_width[PLANE_DEPTH];
+        data.height = data.plane_height[PLANE_DEPTH];
+        data.depth_size = slot->plane_size[PLANE_DEPTH];
+        data.rgb_size = slot->plane_size[PLANE_RGB];
+        data.ir_size = slot->plane_size[PLANE_IR];
+        data.slot = index;
+        data.sequence = sequence;
+
+        if (!isFrameValid(data) || (data.depth_size > view_.plane_capacity[PLANE_DEPTH]) ||
+            (data.rgb_size > view_.plane_capacity[PLANE_RGB]) || (data.ir_size > view_.plane_capacity[PLANE_IR])) {
+            continue;
+        }
+
+        data.depth_data = planeAt(index, PLANE_DEPTH);
+        data.rgb_data = planeAt(index, PLANE_RGB);
+        data.ir_data = planeAt(index, PLANE_IR);
+        data.has_depth = data.depth_size > 0;
+        data.has_rgb = data.rgb_size > 0;
+        data.has_ir = data.ir_size > 0;
+
+        frame_data = data;
+        current_ = data;
+        has_current_ = true;
+        return true;
+    }
+    return false;
+}
+
+bool CameraStreamInterface::isFrameValid(const StreamFrameData& frame_data) const
+{
+    if (!active_ || (frame_data.slot >= view_.slot_count)) {
+        return false;
+    }
+    // order every read of the slot before re-reading its sequence
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (slotAt(frame_data.slot)->sequence.load(std::memory_order_relaxed) == frame_data.sequence) &&
+           (layout_->generation.load(std::memory_order_relaxed) == generation_);
+}
+
+int CameraStreamInterface::copyPlane(int plane, void* buffer, uint32_t buffer_size)
+{
+    if (!active_ || !has_current_ || (plane < 0) || (plane >= PLANE_COUNT) || (buffer == nullptr)) {
+        return -1;
+    }
+
+    const uint32_t sizes[PLANE_COUNT] = { current_.depth_size, current_.rgb_size, current_.ir_size };
+    uint32_t size = sizes[plane];
+    if (size > buffer_size) {
+        return -1;
+    }
+    memcpy(buffer, planeAt(current_.slot, plane), size);
+    if (!isFrameValid(current_)) {
+        has_current_ = false;
+        return -1;
+    }
+    return static_cast<int>(size);
+}
+
+bool CameraStreamInterface::getPlaneInfo(int plane, uint32_t& width, uint32_t& height, uint32_t& bytes_per_pixel) const
+{
+    if (!active_ || !has_current_ || (plane < 0) || (plane >= PLANE_COUNT)) {
+        return false;
+    }
+    width = current_.plane_width[plane];
+    height = current_.plane_height[plane];
+    bytes_per_pixel = current_.plane_bytes_per_pixel[plane];
+    return true;
+}
+
+uint32_t CameraStreamInterface::getFrameCount() const
+{
+    if (!active_) {
+        return 0;
+    }
+    return layout_->frame_count.load(std::memory_order_acquire);
+}
+
+uint32_t CameraStreamInterface::getPlaneCapacity(int plane) const
+{
+    if (!active_ || (plane < 0) || (plane >= PLANE_COUNT)) {
+        return 0;
+    }
+    return view_.plane_capacity[plane];
+}
+
+void CameraStreamInterface::shutdown()
+{
+    if (!active_ && (shared_memory_fd_ < 0)) {
+        return;
+    }
+    active_ = false;
+
+    if (owner_ && (layout_ != nullptr)) {
+        // tell readers this region is done, and wake the ones waiting for a frame
+        layout_->magic = 0;
+        std::atomic_thread_fence(std::memory_order_release);
+        futexWake(&layout_->frame_count);
+    }
+    if (shared_memory_ != nullptr) {
+        munmap(shared_memory_, shared_memory_size_);
+    }
+    shared_memory_ = nullptr;
+    layout_ = nullptr;
+    close(shared_memory_fd_);
+    shared_memory_fd_ = -1;
+
+    if (owner_) {
+        std::string path = "/" + shared_memory_name_;
+        shm_unlink(path.c_str());
+    }
+    owner_ = false;
+    has_current_ = false;
+}
+
+extern "C" {
+
+void* camera_stream_create()
+{
+    return new CameraStreamInterface();
+}
+
+void camera_stream_destroy(void* interface)
+{
+    delete static_cast<CameraStreamInterface*>(interface);
+}
+
+int camera_stream_initialize(void* interface, const char* shared_memory_name)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    if (stream == nullptr) {
+        return -1;
+    }
+    bool ok = shared_memory_name ? stream->initialize(shared_memory_name) : stream->initialize();
+    return ok ? 0 : -1;
+}
+
+int camera_stream_attach(void* interface, const char* shared_memory_name)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    if (stream == nullptr) {
+        return -1;
+    }
+    bool ok = shared_memory_name ? stream->attach(shared_memory_name) : stream->attach();
+    return ok ? 0 : -1;
+}
+
+int camera_stream_update_frame(void* interface,
+                               const void* depth_data, uint32_t depth_size,
+                               const void* rgb_data, uint32_t rgb_size,
+                               const void* ir_data, uint32_t ir_size,
+                               uint32_t width, uint32_t height)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    if ((stream == nullptr) || !stream->isActive()) {
+        return -1;
+    }
+    auto now = std::chrono::system_clock::now();
+    uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+    const uint32_t widths[CameraStreamInterface::PLANE_COUNT] = { width, 0, 0 };
+    const uint32_t heights[CameraStreamInterface::PLANE_COUNT] = { height, 0, 0 };
+    stream->updateFrame(depth_data, depth_size, rgb_data, rgb_size, ir_data, ir_size, widths, heights, timestamp);
+    return 0;
+}
+
+int camera_stream_get_frame_info(void* interface,
+                                 uint64_t* timestamp,
+                                 uint32_t* frame_id,
+                                 uint32_t* width,
+                                 uint32_t* height,
+                                 uint32_t* depth_size,
+                                 uint32_t* rgb_size,
+                                 uint32_t* ir_size)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    StreamFrameData frame;
+    if ((stream == nullptr) || !stream->getLatestFrame(frame)) {
+        return -1;
+    }
+    if (timestamp) *timestamp = frame.timestamp;
+    if (frame_id) *frame_id = frame.frame_id;
+    if (width) *width = frame.width;
+    if (height) *height = frame.height;
+    if (depth_size) *depth_size = frame.depth_size;
+    if (rgb_size) *rgb_size = frame.rgb_size;
+    if (ir_size) *ir_size = frame.ir_size;
+    return 0;
+}
+
+int camera_stream_get_plane_info(void* interface, int plane,
+                                 uint32_t* width, uint32_t* height, uint32_t* bytes_per_pixel)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    uint32_t w, h, bpp;
+    if ((stream == nullptr) || !stream->getPlaneInfo(plane, w, h, bpp)) {
+        return -1;
+    }
+    if (width) *width = w;
+    if (height) *height = h;
+    if (bytes_per_pixel) *bytes_per_pixel = bpp;
+    return 0;
+}
+
+int camera_stream_get_depth_data(void* interface, void* buffer, uint32_t buffer_size)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    return stream ? stream->copyPlane(CameraStreamInterface::PLANE_DEPTH, buffer, buffer_size) : -1;
+}
+
+int camera_stream_get_rgb_data(void* interface, void* buffer, uint32_t buffer_size)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    return stream ? stream->copyPlane(CameraStreamInterface::PLANE_RGB, buffer, buffer_size) : -1;
+}
+
+int camera_stream_get_ir_data(void* interface, void* buffer, uint32_t buffer_size)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    return stream ? stream->copyPlane(CameraStreamInterface::PLANE_IR, buffer, buffer_size) : -1;
+}
+
+int camera_stream_wait_frame(void* interface, uint32_t frame_id, int timeout_ms)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    if ((stream == nullptr) || !stream->isActive()) {
+        return -1;
+    }
+    return stream->waitForFrame(frame_id, timeout_ms) ? 0 : 1;
+}
+
+int camera_stream_is_active(void* interface)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    return (stream && stream->isActive()) ? 1 : 0;
+}
+
+uint32_t camera_stream_get_frame_count(void* interface)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    return stream ? stream->getFrameCount() : 0;
+}
+
+uint32_t camera_stream_get_plane_capacity(void* interface, int plane)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    return stream ? stream->getPlaneCapacity(plane) : 0;
+}
+
+uint32_t camera_stream_get_generation(void* interface)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    return stream ? stream->getGeneration() : 0;
+}
+
+void camera_stream_shutdown(void* interface)
+{
+    CameraStreamInterface* stream = static_cast<CameraStreamInterface*>(interface);
+    if (stream) {
+        stream->shutdown();
+    }
+}
+
+}
@@ -20,11 +20,13 @@
 #include <iostream>
 #include <string>
 #include <memory>
+#include <algorithm>
 
 #include "Logger.h"
 #include "as_camera_sdk_api.h"
 #include "as_camera_sdk_def.h"
 #include "common.h"
+#include "Options.h"
 #include "Demo.h"
 
 #ifdef CFG_X11_ON
@@ -36,18 +38,102 @@ Demo::Demo()
 #ifdef CFG_X11_ON
     XInitThreads();
 #endif
+
+    LogLevel level = NOTICE;
+    std::string log_level = optionString("LOG_LEVEL", "notice");
+    if (AsyncLogger::parseLevel(log_level, level)) {
+        AsyncLogger::setLevel(level);
+    } else {
+        LOG(WARN) << "unknown log level " << log_level << ", keeping notice" << std::endl;
+    }
     
     // Initialize Python stream server (C++11 compatible)
     m_python_server.reset(new PythonStreamServer(8888));
+    m_python_server->setZeroCopy(optionBool("STREAM_ZEROCOPY", false));
+    m_stream_pointcloud = optionBool("STREAM_POINTCLOUD", false);
+    m_undistort = optionBool("UNDISTORT", false);
+    std::string register_mode = optionString("REGISTER", "off");
+    DepthRegistration::Mode mode;
+    if (DepthRegistration::parseMode(register_mode, mode)) {
+        m_register_mode = mode;
+    } else if (register_mode != "off") {
+        LOG(WARN) << "unknown registration " << register_mode << ", registration off" << std::endl;
+    }
+    m_register_threads = static_cast<size_t>(std::max<long>(optionInt("REGISTER_THREADS", 4), 1));
     if (m_python_server->start()) {
         LOG(INFO) << "Python stream server started on port 8888" << std::endl;
     } else {
         LOG(ERROR) << "Failed to start Python stream server" << std::endl;
     }
+
+    m_image_writer = std::make_shared<ImageWriter>(optionInt("WRITER_DEPTH", 16), optionInt("WRITER_SYNC_BATCH", 8));
+    m_image_writer->start();
+
+    m_shm_enable = optionBool("SHM", false);
+    m_shm_name = optionString("SHM_NAME", "angstrong_camera_stream");
+
+    m_zone_enable = optionBool("ZONES", true);
+    m_zone_center_threshold = optionInt("ZONE_CENTER_MM", ZoneDangerDetector::DEFAULT_CENTER_THRESHOLD);
+    m_zone_side_threshold = optionInt("ZONE_SIDE_MM", ZoneDangerDetector::DEFAULT_SIDE_THRESHOLD);
+    m_ts_per_second = optionDouble("TS_PER_SEC", 1000.0);
+    m_ttc_warn = optionDouble("TTC_WARN_S", 4.0);
+    m_ground = optionBool("GROUND", false);
+    m_ground_height = static_cast<uint16_t>(optionInt("GROUND_HEIGHT_MM", 50));
+    m_ground_tolerance = static_cast<uint16_t>(optionInt("GROUND_TOLERANCE_MM", GroundPlaneEstimator::DEFAULT_TOLERANCE));
+    m_occupancy = optionBool("OCCUPANCY", false);
+    m_occupancy_config.voxel = static_cast<uint16_t>(optionInt("OCCUPANCY_VOXEL_MM", 50));
+    m_occupancy_config.range = static_cast<uint16_t>(optionInt("OCCUPANCY_RANGE_MM", 4000));
+    m_occupancy_config.min_height = m_ground_height;
+    m_occupancy_config.max_height = static_cast<uint16_t>(optionInt("OCCUPANCY_HEIGHT_MM", 1200));
+    m_occupancy_config.hold = static_cast<uint16_t>(optionInt("OCCUPANCY_HOLD_MS", 1000));
+    m_occupancy_config.stride = static_cast<uint16_t>(optionInt("OCCUPANCY_STRIDE", 2));
+    m_mount_height = optionDouble("MOUNT_HEIGHT_MM", 900.0);
+    m_mount_pitch = optionDouble("MOUNT_PITCH_DEG", 0.0);
+    LatencyTracer::setEnabled(optionBool("LATENCY", true));
+    LatencyTracer::setCaptureClock(m_ts_per_second, optionString("TS_CLOCK", "system") != "steady");
+    EventTracer::setCapacity(optionInt("TRACE_EVENTS", 32768));
+    EventTracer::setEnabled(optionBool("TRACE", false));
+    m_trace_file = optionString("TRACE_FILE", "ascamera_trace.json");
+    m_pipeline_threads = optionBool("PIPELINE", true);
+    m_queue_depth = optionInt("QUEUE_DEPTH", 2);
+
+    m_record = optionBool("RECORD", false);
+    m_record_dir = optionString("RECORD_DIR", ".");
+    m_record_chunk_bytes = static_cast<size_t>(optionInt("RECORD_CHUNK_MB", 16)) << 20;
+    m_record_chunks = optionInt("RECORD_CHUNKS", 4);
+    m_record_file_bytes = static_cast<uint64_t>(optionInt("RECORD_FILE_MB", 1024)) << 20;
+
+    std::string alert = optionString("ALERT", "");
+    if (!alert.empty()) {
+        if (m_alerts.open(alert, optionBool("ALERT_ON_CHANGE", false))) {
+            LOG(INFO) << "publishing zone alerts to " << alert << std::endl;
+        } else {
+            LOG(ERROR) << "failed to open alert channel " << alert << std::endl;
+        }
+    }
+
+    m_metrics_id = Metrics::addCollector([this](Metrics::Writer & out) {
+        collectMetrics(out);
+    });
+    std::string metrics = optionString("METRICS", "");
+    if (!metrics.empty()) {
+        if (m_metrics_server.start(metrics)) {
+            LOG(INFO) << "serving metrics on " << metrics << std::endl;
+        } else {
+            LOG(ERROR) << "failed to serve metrics on " << metrics << std::endl;
+        }
+    }
 }
 
 Demo::~Demo()
 {
+    m_metrics_server.stop();
+    Metrics::removeCollector(m_metrics_id);
+    for (auto it = m_metrics_map.begin(); it != m_metrics_map.end(); it++) {
+        Metrics::removeCollector(it->second);
+    }
+    m_metrics_map.clear();
+
     // Stop Python stream server
     if (m_python_server) {
         m_python_server->stop();
@@ -58,6 +144,50 @@ Demo::~Demo()
 int Demo::start()
 {
     int ret = 0;
+    std::string replay = optionString("REPLAY", "");
+    if (!replay.empty()) {
+        if (m_replay) {
+            return 0;
+        }
+        std::vector<std::string> paths;
+        size_t begin = 0;
+        while (begin <= replay.size()) {
+            size_t end = replay.find(',', begin);
+            if (end == std::string::npos) {
+                end = replay.size();
+            }
+            if (end > begin) {
+                paths.push_back(replay.substr(begin, end - begin));
+            }
+            begin = end + 1;
+        }
+        m_replay.reset(new SessionReplay(this, paths, m_ts_per_second));
+        m_replay->setPacing(SessionReplay::parsePacing(optionString("REPLAY_PACE", "realtime")),
+                            optionDouble("REPLAY_SPEED", 1.0));
+        m_replay->setLoop(optionBool("REPLAY_LOOP", false));
+        ret = m_replay->start();
+        if (ret != 0) {
+            LOG(ERROR) << "start replay failed" << std::endl;
+        }
+        return ret;
+    }
+
+    long synthetic = optionInt("SYNTHETIC", 0);
+    if (synthetic > 0) {
+        if (m_synthetic) {
+            return 0;
+        }
+        SyntheticCameras::Config config;
+        config.cameras = synthetic;
+        config.width = optionInt("SYNTH_WIDTH", 640);
+        config.height = optionInt("SYNTH_HEIGHT", 480);
+        config.fps = optionDouble("SYNTH_FPS", 30.0);
+        config.scene = SyntheticCameras::parseScene(optionString("SYNTH_SCENE", "approach"));
+        config.ticks_per_second = m_ts_per_second;
+        m_synthetic.reset(new SyntheticCameras(this, config));
+        return m_synthetic->start();
+    }
+
     if (server == nullptr) {
         server = new CameraSrv(this);
         ret = server->start();
@@ -78,9 +208,34 @@ void Demo::stop()
         delete server;
         server = nullptr;
     }
+    if (m_replay) {
+        m_replay->stop();
+        m_replay.reset();
+    }
+    if (m_synthetic) {
+        m_synthetic->stop();
+        m_synthetic.reset();
+    }
 
     /* free the map */
+    for (auto it = m_metrics_map.begin(); it != m_metrics_map.end(); it++) {
+        Metrics::removeCollector(it->second);
+    }
+    m_metrics_map.clear();
+    m_pipeline_map.clear();
+    /* seal and flush what is still buffered */
+    m_recorder_map.clear();
     m_camera_map.erase(m_camera_map.begin(), m_camera_map.end());
+
+    /* flush the images still queued */
+    m_image_writer->stop();
+
+    if (LatencyTracer::enabled()) {
+        logLatency();
+    }
+    if (EventTracer::enabled()) {
+        dumpTrace();
+    }
 }
 
 void Demo::display(bool enable)
@@ -116,10 +271,79 @@ bool Demo::getLogFps()
     return m_logfps;
 }
 
+void Demo::record(bool enable)
+{
+    m_record = enable;
+    for (auto it = m_recorder_map.begin(); it != m_recorder_map.end(); it++) {
+        if (!enable) {
+            it->second->stop();
+            continue;
+        }
+        auto camIt = m_camera_map.find(it->first);
+        if (camIt == m_camera_map.end()) {
+            continue;
+        }
+        std::string serialno;
+        camIt->second->getSerialNo(serialno);
+        it->second->start(m_record_dir, serialno, camIt->second->getCameraType());
+    }
+}
+
+bool Demo::getRecordStatus()
+{
+    return m_record;
+}
+
+void Demo::logLatency()
+{
+    std::string report = LatencyTracer::report();
+    if (report.empty()) {
+        LOG(INFO) << "no latency samples" << std::endl;
+        return;
+    }
+    LOG(INFO) << "frame latency since the SDK callback:" << std::endl << report;
+}
+
+void Demo::dumpTrace()
+{
+    if (!EventTracer::enabled()) {
+        LOG(WARN) << "event tracing is off, set ASCAMERA_TRACE=1" << std::endl;
+        return;
+    }
+    if (EventTracer::dump(m_trace_file)) {
+        LOG(INFO) << "trace written to " << m_trace_file << std::endl;
+    } else {
+        LOG(ERROR) << "failed to write trace " << m_trace_file << std::endl;
+    }
+}
+
+void Demo::refreshCalibration()
+{
+    for (auto it = m_camera_map.begin(); it != m_camera_map.end(); it++) {
+        it->second->refreshCalibration();
+    }
+}
+
+void Demo::step()
+{
+    if (m_replay) {
+        m_replay->step();
+    }
+}
+
 int Demo::onCameraAttached(AS_CAM_PTR pCamera, const AS_SDK_CAM_MODEL_E &cam_type)
 {
     LOG(INFO) << "camera attached" << std::endl;
-    m_camera_map.insert(std::make_pair(pCamera, std::make_shared<Camera>(pCamera, cam_type)));
+    std::shared_ptr<Camera> camera = std::make_shared<Camera>(pCamera, cam_type);
+    camera->setImageWriter(m_image_writer);
+    camera->enableUndistortion(m_undistort);
+    /* stream clients get it on connect, and again when it is refreshed */
+    camera->setCalibrationCallback([this](const std::string & serialno, const CameraCalibration & calibration) {
+        if (m_python_server) {
+            m_python_server->setCalibration(serialno, calibration);
+        }
+    });
+    m_camera_map.insert(std::make_pair(pCamera, camera));
 
     bool is_displaying = false;
     for (auto it = m_camera_map.begin(); it != m_camera_map.end(); it++) {
@@ -137,10 +361,11 @@ int Demo::onCameraAttached(AS_CAM_PTR pCamera, const AS_SDK_CAM_MODEL_E &cam_typ
 #ifdef __linux__
     /* nuwa camera whether match usb device.
        If it is a virtual machine, do not match it. */
-    if ((cam_type == AS_SDK_CAM_MODEL_NUWA_XB40) ||
-        (cam_type == AS_SDK_CAM_MODEL_NUWA_X100) ||
-        (cam_type == AS_SDK_CAM_MODEL_NUWA_HP60) ||
-        (cam_type == AS_SDK_CAM_MODEL_NUWA_HP60V)) {
+    if (!camera->isVirtual() &&
+        ((cam_type == AS_SDK_CAM_MODEL_NUWA_XB40) ||
+         (cam_type == AS_SDK_CAM_MODEL_NUWA_X100) ||
+         (cam_type == AS_SDK_CAM_MODEL_NUWA_HP60) ||
+         (cam_type == AS_SDK_CAM_MODEL_NUWA_HP60V))) {
         extern int AS_Nuwa_SetUsbDevMatch(bool is_match);
         AS_Nuwa_SetUsbDevMatch(!virtualMachine());
         // AS_Nuwa_SetUsbDevMatch(false);
@@ -153,10 +378,16 @@ int Demo::onCameraAttached(AS_CAM_PTR pCamera, const AS_SDK_CAM_MODEL_E &cam_typ
 int Demo::onCameraDetached(AS_CAM_PTR pCamera)
 {
     LOG(INFO) << "camera detached" << std::endl;
+    /* the workers still reference the camera, stop them first */
+    removeCameraMetrics(pCamera);
+    m_pipeline_map.erase(pCamera);
+    m_recorder_map.erase(pCamera);
     auto camIt = m_camera_map.find(pCamera);
     if (camIt != m_camera_map.end()) {
         m_camera_map.erase(pCamera);
     }
+    m_shm_map.erase(pCamera);
+    m_zone_map.erase(pCamera);
 
     return 0;
 }
@@ -168,6 +399,42 @@ int Demo::onCameraOpen(AS_CAM_PTR pCamera)
     auto camIt = m_camera_map.find(pCamera);
     if (camIt != m_camera_map.end()) {
         camIt->second->init();
+        if (m_shm_enable && (m_shm_map.find(pCamera) == m_shm_map.end())) {
+            // the first camera keeps the plain name so single camera readers need no config
+            std::string name = m_shm_name;
+            if (!m_shm_map.empty()) {
+                std::string serialno;
+                camIt->second->getSerialNo(serialno);
+                name += "_" + serialno;
+            }
+            /* sized for the current stream mode, grows if the mode changes later */
+            size_t capacity[AS_FRAME_TYPE_BUTT];
+            camIt->second->getPlaneCapacity(capacity);
+            uint32_t plane_capacity[CameraStreamInterface::PLANE_COUNT];
+            plane_capacity[CameraStreamInterface::PLANE_DEPTH] = capacity[AS_FRAME_TYPE_DEPTH];
+            plane_capacity[CameraStreamInterface::PLANE_RGB] = capacity[AS_FRAME_TYPE_RGB];
+            plane_capacity[CameraStreamInterface::PLANE_IR] = capacity[AS_FRAME_TYPE_IR];
+            std::shared_ptr<CameraStreamInterface> shm = std::make_shared<CameraStreamInterface>();
+            if (shm->initialize(name, plane_capacity)) {
+                LOG(INFO) << "publishing frames to shared memory /" << name << std::endl;
+                m_shm_map[pCamera] = shm;
+            } else {
+                LOG(ERROR) << "failed to create shared memory /" << name << std::endl;
+            }
+        }
+        if (m_zone_enable && (m_zone_map.find(pCamera) == m_zone_map.end())) {
+            std::shared_ptr<ZoneState> zone = std::make_shared<ZoneState>(m_zone_center_threshold, m_zone_side_threshold,
+                                                                          m_ts_per_second, m_ttc_warn);
+            zone->alert.camera_id = m_next_camera_id++;
+            camIt->second->getSerialNo(zone->alert.serial);
+            if (m_occupancy) {
+                zone->grid.reset(new OccupancyGrid(m_occupancy_config));
+            }
+            m_zone_map[pCamera] = zone;
+        }
+        if (m_pipeline_map.find(pCamera) == m_pipeline_map.end()) {
+            createPipeline(pCamera, camIt->second);
+        }
     }
     // ret = AS_SDK_SetTimeStampType(pCamera, AS_TIME_STAMP_TYPE_STEADY_CLOCK);
     // if (ret != 0) {
@@ -209,33 +476,305 @@ int Demo::onCameraStop(AS_CAM_PTR pCamera)
 
 void Demo::onCameraNewFrame(AS_CAM_PTR pCamera, const AS_SDK_Data_s *pstData)
 {
-    std::string serialno = "";
-    std::string info = "";
-
-    AS_CAM_ATTR_S attr;
+    TraceScope trace("onCameraNewFrame");
+    uint64_t entry = LatencyTracer::now();
+    uint64_t arrival = LatencyTracer::enabled() ? entry : 0;
     auto camIt = m_camera_map.find(pCamera);
     if (camIt != m_camera_map.end()) {
-        if (m_logfps) {
-            camIt->second->checkFps();
+        camIt->second->checkFps(m_logfps);
+        auto pipeIt = m_pipeline_map.find(pCamera);
+        if (pipeIt != m_pipeline_map.end()) {
+            /* the only copy of the frame, the sinks share the pooled slot on their own threads */
+            FrameRef frame = camIt->second->acquireFrame(pstData, arrival);
+            if (frame) {
+                pipeIt->second->push(frame);
+            }
         }
-        camIt->second->getSerialNo(serialno);
-        camIt->second->getCameraAttrs(attr);
-        camIt->second->saveImage(pstData);
+        camIt->second->countFrame(pstData, LatencyTracer::now() - entry);
+    }
+}
 
-        if (attr.type == AS_CAMERA_ATTR_LNX_USB) {
-            info.append(std::to_string(attr.attr.usbAttrs.bnum) + ":" + attr.attr.usbAttrs.port_numbers);
-        } else if (attr.type == AS_CAMERA_ATTR_NET) {
-            info.append("_" + std::string(attr.attr.netAttrs.ip_addr));
-        }
-        camIt->second->displayImage(serialno, info, pstData);
-        
-        // Push frame to Python stream server
+void Demo::createPipeline(AS_CAM_PTR pCamera, const std::shared_ptr<Camera> &camera)
+{
+    std::string serialno;
+    camera->getSerialNo(serialno);
+    std::shared_ptr<CameraPipeline> pipeline = std::make_shared<CameraPipeline>(serialno, m_pipeline_threads);
+
+    /* the floor is refitted on its own thread, the zones and the stream apply the latest plane */
+    std::shared_ptr<GroundPlaneEstimator> ground;
+    if (m_ground) {
+        ground = std::make_shared<GroundPlaneEstimator>(m_ground_tolerance);
+        pipeline->addSink("ground", m_queue_depth, [ground, camera, serialno](const FrameRef & frame) {
+            const CameraCalibration *calibration = camera->getCalibration();
+            if (calibration == nullptr) {
+                return;
+            }
+            TraceScope trace("fitGround");
+            bool was_valid = ground->plane().valid;
+            if (!ground->update(frame.data()->depthImg, *calibration)) {
+                return;
+            }
+            GroundPlane plane = ground->plane();
+            if (plane.valid && !was_valid) {
+                LOG(INFO) << "SN [ " << serialno << " ] ground plane n (" << plane.normal[0] << " " << plane.normal[1]
+                          << " " << plane.normal[2] << ") " << plane.offset << "mm below, "
+                          << plane.inlier_ratio * 100 << "% inliers" << std::endl;
+            } else if (!plane.valid && was_valid) {
+                LOG(INFO) << "SN [ " << serialno << " ] ground plane lost" << std::endl;
+            }
+        });
+    }
+
+    /* obstacle decision, it must never wait behind the slower sinks */
+    auto zoneIt = m_zone_map.find(pCamera);
+    if (zoneIt != m_zone_map.end()) {
+        std::shared_ptr<ZoneState> zone = zoneIt->second;
+        pipeline->addSink("zones", m_queue_depth, [this, zone, serialno, camera, ground](const FrameRef & frame) {
+            TraceScope trace("processZones");
+            AS_Frame_s depth = frame.data()->depthImg;
+            const CameraCalibration *calibration = camera->getCalibration();
+            ZoneDangerResult result;
+            if (zone->grid) {
+                GroundPlane mount = ground ? ground->plane() : GroundPlane();
+                if (!mount.valid) {
+                    mount = OccupancyGrid::mountPlane(m_mount_height, m_mount_pitch);
+                }
+                double seconds = depth.ts / m_ts_per_second;
+                if (depth.ts == 0) {
+                    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+                }
+                uint16_t nearest[ZONE_COUNT];
+                if ((calibration == nullptr) || !zone->grid->update(depth, *calibration, mount, seconds, nearest)) {
+                    return;
+                }
+                zone->detector.classify(depth.ts, depth.frameId, nearest, result);
+            } else {
+                if (ground && (calibration != nullptr) &&
+                    zone->ground.removeGround(depth, *calibration, ground->plane(), m_ground_height, zone->above_ground)) {
+                    depth.data = zone->above_ground.data();
+                }
+                if (!zone->detector.process(depth, result)) {
+                    return;
+                }
+            }
+            processZones(*zone, serialno, result);
+            LatencyTracer::recordFrame(frame.get(), LatencyTracer::STAGE_PROCESSED);
+        });
+    }
+
+    std::shared_ptr<CameraStreamInterface> shm;
+    auto shmIt = m_shm_map.find(pCamera);
+    if (shmIt != m_shm_map.end()) {
+        shm = shmIt->second;
+    }
+    std::shared_ptr<PointCloudProjector> projector;
+    if (m_stream_pointcloud) {
+        projector = std::make_shared<PointCloudProjector>();
+    }
+    std::shared_ptr<DepthRegistration> registration;
+    if (m_register_mode != 0) {
+        registration = std::make_shared<DepthRegistration>(static_cast<DepthRegistration::Mode>(m_register_mode),
+                                                           m_register_threads);
+    }
+    std::shared_ptr<GroundMask> ground_mask;
+    if (ground) {
+        ground_mask = std::make_shared<GroundMask>();
+    }
+    pipeline->addSink("publish", m_queue_depth, [this, shm, camera, projector, registration, ground,
+                      ground_mask](const FrameRef & frame) {
         if (m_python_server && m_python_server->isRunning()) {
-            m_python_server->pushFrame(pstData);
+            std::shared_ptr<const PointCloud> cloud;
+            std::shared_ptr<const RegisteredFrame> registered;
+            std::shared_ptr<const GroundMaskFrame> mask;
+            const CameraCalibration *calibration = camera->getCalibration();
+            if ((calibration != nullptr) && (m_python_server->getConnectedClients() > 0)) {
+                if (projector) {
+                    TraceScope trace("projectPointCloud");
+                    cloud = projector->project(frame.data()->depthImg, *calibration);
+                }
+                if (registration) {
+                    TraceScope trace("registerDepth");
+                    registered = registration->process(*frame.data(), *calibration);
+                }
+                if (ground) {
+                    TraceScope trace("maskGround");
+                    mask = ground_mask->build(frame.data()->depthImg, *calibration, ground->plane(), m_ground_height);
+                }
+            }
+            m_python_server->pushFrame(frame, cloud, registered, mask);
         }
+        if (shm) {
+            const AS_SDK_Data_s *data = frame.data();
+            const uint32_t width[CameraStreamInterface::PLANE_COUNT] = {
+                data->depthImg.width, data->rgbImg.width, data->irImg.width
+            };
+            const uint32_t height[CameraStreamInterface::PLANE_COUNT] = {
+                data->depthImg.height, data->rgbImg.height, data->irImg.height
+            };
+            shm->updateFrame(data->depthImg.data, data->depthImg.size,
+                             data->rgbImg.data, data->rgbImg.size,
+                             data->irImg.data, data->irImg.size,
+                             width, height,
+                             (data->depthImg.size > 0) ? data->depthImg.ts : data->rgbImg.ts);
+        }
+    });
+
+    /* the recorder buffers whole chunks itself, its queue only absorbs a slow copy */
+    std::shared_ptr<Recorder> recorder = std::make_shared<Recorder>(m_record_chunk_bytes, m_record_chunks,
+                                                                    m_record_file_bytes);
+    if (m_record) {
+        recorder->start(m_record_dir, serialno, camera->getCameraType());
+    }
+    m_recorder_map[pCamera] = recorder;
+    pipeline->addSink("record", std::max<size_t>(m_queue_depth, 4), [recorder, camera](const FrameRef & frame) {
+        if (recorder->isRecording()) {
+            TraceScope trace("recordFrame");
+            recorder->record(frame.data(), frame.get()->sequence(), camera->getCalibration());
+        }
+    });
+
+    pipeline->addSink("save", m_queue_depth, [camera](const FrameRef & frame) {
+        camera->saveImage(frame);
+    });
+
+    std::string info = "";
+    AS_CAM_ATTR_S attr;
+    camera->getCameraAttrs(attr);
+    if (attr.type == AS_CAMERA_ATTR_LNX_USB) {
+        info.append(std::to_string(attr.attr.usbAttrs.bnum) + ":" + attr.attr.usbAttrs.port_numbers);
+    } else if (attr.type == AS_CAMERA_ATTR_NET) {
+        info.append("_" + std::string(attr.attr.netAttrs.ip_addr));
+    }
+    pipeline->addSink("display", m_queue_depth, [camera, serialno, info](const FrameRef & frame) {
+        camera->displayImage(serialno, info, frame.data());
+    });
+
+    pipeline->start();
+    m_pipeline_map[pCamera] = pipeline;
+
+    removeCameraMetrics(pCamera);
+    m_metrics_map[pCamera] = Metrics::addCollector([serialno, camera, pipeline, recorder](Metrics::Writer & out) {
+        collectCameraMetrics(out, serialno, *camera, *pipeline, *recorder);
+    });
+}
+
+void Demo::removeCameraMetrics(AS_CAM_PTR pCamera)
+{
+    auto it = m_metrics_map.find(pCamera);
+    if (it != m_metrics_map.end()) {
+        /* also waits for a scrape still reading the camera */
+        Metrics::removeCollector(it->second);
+        m_metrics_map.erase(it);
     }
 }
 
+void Demo::collectMetrics(Metrics::Writer &out)
+{
+    if (m_python_server) {
+        out.add("ascamera_stream_clients", Metrics::GAUGE, "Connected stream clients", "",
+                m_python_server->getConnectedClients());
+        out.add("ascamera_stream_bytes_sent_total", Metrics::COUNTER, "Bytes sent to every stream client", "",
+                m_python_server->bytesSentCount());
+        std::vector<StreamClientStats> clients;
+        m_python_server->getClientStats(clients);
+        for (size_t i = 0; i < clients.size(); i++) {
+            std::string labels = Metrics::label("client", clients[i].address);
+            out.add("ascamera_stream_client_bytes_sent_total", Metrics::COUNTER, "Bytes sent to a stream client",
+                    labels, clients[i].bytes_sent);
+            out.add("ascamera_stream_client_frames_sent_total", Metrics::COUNTER, "Frames sent to a stream client",
+                    labels, clients[i].delivered);
+            out.add("ascamera_stream_client_frames_dropped_total", Metrics::COUNTER,
+                    "Frames a stream client fell too far behind to get", labels, clients[i].dropped);
+        }
+    }
+
+    out.add("ascamera_image_writer_backlog", Metrics::GAUGE, "Images queued for the image writer", "",
+            m_image_writer->backlog());
+    out.add("ascamera_image_writer_written_total", Metrics::COUNTER, "Images written", "",
+            m_image_writer->completedCount());
+    out.add("ascamera_image_writer_failed_total", Metrics::COUNTER, "Images that failed to write", "",
+            m_image_writer->failedCount());
+    out.add("ascamera_image_writer_dropped_total", Metrics::COUNTER, "Images dropped on a full writer queue", "",
+            m_image_writer->droppedCount());
+
+    out.add("ascamera_alerts_sent_total", Metrics::COUNTER, "Zone alert records sent", "", m_alerts.sentCount());
+    out.add("ascamera_alerts_failed_total", Metrics::COUNTER, "Zone alert records that failed to send", "",
+            m_alerts.failedCount());
+}
+
+void Demo::collectCameraMetrics(Metrics::Writer &out, const std::string &serialno, Camera &camera,
+                                CameraPipeline &pipeline, Recorder &recorder)
+{
+    std::string labels = Metrics::label("serial", serialno);
+    CameraStats stats;
+    camera.getStats(stats);
+    out.add("ascamera_frames_received_total", Metrics::COUNTER, "Frame callbacks from the SDK", labels, stats.frames);
+    out.add("ascamera_depth_frames_received_total", Metrics::COUNTER, "Frame callbacks with a depth plane", labels,
+            stats.depth_frames);
+    out.add("ascamera_frame_rate", Metrics::GAUGE, "Frame callbacks per second over the last two seconds", labels,
+            stats.fps);
+    out.add("ascamera_callback_seconds_total", Metrics::COUNTER, "Time spent in the SDK frame callback", labels,
+            stats.callback_ns / 1e9);
+    out.add("ascamera_pool_exhausted_total", Metrics::COUNTER, "Frames lost because every pooled slot was in use",
+            labels, stats.pool_exhausted);
+
+    std::vector<CameraPipeline::SinkStats> sinks;
+    pipeline.getSinkStats(sinks);
+    for (size_t i = 0; i < sinks.size(); i++) {
+        std::string sink = labels + "," + Metrics::label("sink", sinks[i].name);
+        out.add("ascamera_sink_processed_total", Metrics::COUNTER, "Frames a sink processed", sink,
+                sinks[i].processed);
+        out.add("ascamera_sink_dropped_total", Metrics::COUNTER, "Frames dropped because a sink fell behind", sink,
+                sinks[i].dropped);
+        out.add("ascamera_sink_queue_depth", Metrics::GAUGE, "Frames waiting in a sink queue", sink,
+                sinks[i].queued);
+        out.add("ascamera_sink_queue_capacity", Metrics::GAUGE, "Frames a sink queue holds", sink,
+                sinks[i].depth);
+    }
+
+    out.add("ascamera_recorder_frames_total", Metrics::COUNTER, "Frames recorded", labels, recorder.framesCount());
+    out.add("ascamera_recorder_dropped_total", Metrics::COUNTER, "Frames dropped while every chunk waited for the disk",
+            labels, recorder.droppedCount());
+    out.add("ascamera_recorder_bytes_written_total", Metrics::COUNTER, "Bytes of recorded chunks written", labels,
+            recorder.bytesCount());
+    out.add("ascamera_recorder_backlog_chunks", Metrics::GAUGE, "Sealed chunks waiting for the disk", labels,
+            recorder.backlog());
+}
+
+void Demo::processZones(ZoneState &zone, const std::string &serialno, ZoneDangerResult &result)
+{
+    if (result.timestamp == 0) {
+        /* no capture time from the SDK, fall back to arrival time */
+        std::chrono::duration<double> now = std::chrono::steady_clock::now().time_since_epoch();
+        result.timestamp = static_cast<uint64_t>(now.count() * m_ts_per_second);
+    }
+    zone.ttc.update(result);
+    m_alerts.publish(zone.alert, result);
+
+    bool changed = false;
+    for (int i = 0; i < ZONE_COUNT; i++) {
+        changed = changed || (result.zones[i].warn != zone.last.zones[i].warn) ||
+                  (result.zones[i].ttc_warn != zone.last.zones[i].ttc_warn);
+    }
+    if (changed) {
+        static const char *names[ZONE_COUNT] = { "left", "center", "right" };
+        std::string zones;
+        for (int i = 0; i < ZONE_COUNT; i++) {
+            const ZoneResult &z = result.zones[i];
+            char buff[64] = {0};
+            if (z.ttc >= 0) {
+                snprintf(buff, sizeof(buff), " %s %s(%umm, ttc %.1fs%s)", names[i], z.warn ? "warn" : "safe",
+                         z.min_depth, z.ttc, z.ttc_warn ? " !" : "");
+            } else {
+                snprintf(buff, sizeof(buff), " %s %s(%umm)", names[i], z.warn ? "warn" : "safe", z.min_depth);
+            }
+            zones += buff;
+        }
+        LOG(INFO) << "SN [ " << serialno << " ] zones" << zones << std::endl;
+    }
+    zone.last = result;
+}
+
 void Demo::onCameraNewMergeFrame(AS_CAM_PTR pCamera, const AS_SDK_MERGE_s *pstData)
 {
     std::string serialno = "";
@@ -244,9 +783,7 @@ void Demo::onCameraNewMergeFrame(AS_CAM_PTR pCamera, const AS_SDK_MERGE_s *pstDa
     AS_CAM_ATTR_S attr;
     auto camIt = m_camera_map.find(pCamera);
     if (camIt != m_camera_map.end()) {
-        if (m_logfps) {
-            camIt->second->checkFps();
-        }
+        camIt->second->checkFps(m_logfps);
         camIt->second->getSerialNo(serialno);
         camIt->second->getCameraAttrs(attr);
         camIt->second->saveMergeImage(pstData);
@@ -264,6 +801,9 @@ void Demo::onCameraNewMergeFrame(AS_CAM_PTR pCamera, const AS_SDK_MERGE_s *pstDa
 void Demo::logCfgParameter()
 {
     for (auto it = m_camera_map.begin(); it != m_camera_map.end(); it++) {
+        if (it->second->isVirtual()) {
+            continue;
+        }
         AS_SDK_LogCameraCfg(it->first);
     }
 }
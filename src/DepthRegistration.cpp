@@ -0,0 +1,351 @@
+/**
+ * @file      DepthRegistration.cpp
+ * @brief     Aligns depth and RGB of one camera through the IR to RGB extrinsics
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "DepthRegistration.h"
+#include <algorithm>
+#include <cmath>
+
+/* pooled frames, a consumer that holds more just misses frames */
+#define MAX_POOLED_FRAMES       16
+/* largest splat side, RGB images far finer than the depth are not filled in */
+#define MAX_FOOTPRINT           8
+/* a depth pixel still sees its RGB pixel when at most this far behind the nearest surface there */
+#define OCCLUSION_TOLERANCE_MM  10
+#define OCCLUSION_TOLERANCE_SHIFT 5     /* plus 1/32 of the distance */
+
+bool DepthRegistration::parseMode(const std::string &name, Mode &mode)
+{
+    if (name == "depth") {
+        mode = DEPTH_TO_RGB;
+    } else if (name == "rgb") {
+        mode = RGB_TO_DEPTH;
+    } else if (name == "both") {
+        mode = BOTH;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+DepthRegistration::DepthRegistration(Mode mode, size_t threads)
+    : m_mode(mode), m_bands(std::max<size_t>(threads, 1)), m_version(0), m_depth_width(0), m_depth_height(0),
+      m_rgb_width(0), m_rgb_height(0), m_fx(0), m_fy(0), m_cx(0), m_cy(0), m_k1(0), m_k2(0), m_k3(0), m_p1(0),
+      m_p2(0), m_distorted(false), m_footprint_x(1), m_footprint_y(1), m_pool(MAX_POOLED_FRAMES), m_job(nullptr),
+      m_generation(0), m_pending(0), m_stopping(false)
+{
+    m_t[0] = m_t[1] = m_t[2] = 0;
+    m_splats.resize(m_bands, std::vector<std::vector<Splat>>(m_bands));
+    for (size_t band = 1; band < m_bands; band++) {
+        m_workers.push_back(std::thread(&DepthRegistration::workerThread, this, band));
+    }
+}
+
+DepthRegistration::~DepthRegistration()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_start_cond.notify_all();
+    for (size_t i = 0; i < m_workers.size(); i++) {
+        m_workers[i].join();
+    }
+}
+
+void DepthRegistration::workerThread(size_t band)
+{
+    uint64_t generation = 0;
+    while (true) {
+        const std::function<void(size_t band)> *job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start_cond.wait(lock, [&] { return m_stopping || (m_generation != generation); });
+            if (m_stopping) {
+                return;
+            }
+            generation = m_generation;
+            job = m_job;
+        }
+        (*job)(band);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_pending == 0) {
+                m_done_cond.notify_one();
+            }
+        }
+    }
+}
+
+void DepthRegistration::runBands(const std::function<void(size_t band)> &job)
+{
+    if (m_bands == 1) {
+        job(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_pending = m_bands - 1;
+        m_generation++;
+    }
+    m_start_cond.notify_all();
+    job(0);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_cond.wait(lock, [&] { return m_pending == 0; });
+}
+
+bool DepthRegistration::prepare(const CameraCalibration &calibration, uint32_t depth_width, uint32_t depth_height,
+                                uint32_t rgb_width, uint32_t rgb_height)
+{
+    if ((calibration.version == m_version) && (depth_width == m_depth_width) && (depth_height == m_depth_height)
+        && (rgb_width == m_rgb_width) && (rgb_height == m_rgb_height)) {
+        return true;
+    }
+    const AS_CAM_Parameter_s &p = calibration.parameter;
+    if ((p.fxrgb <= 0) || (p.fyrgb <= 0) || !m_projector.prepare(calibration, depth_width, depth_height)) {
+        return false;
+    }
+
+    const std::vector<float> &ray_x = m_projector.raysX();
+    const std::vector<float> &ray_y = m_projector.raysY();
+    const size_t pixels = ray_x.size();
+    m_rotated_x.resize(pixels);
+    m_rotated_y.resize(pixels);
+    m_rotated_z.resize(pixels);
+    for (size_t i = 0; i < pixels; i++) {
+        const float x = ray_x[i];
+        const float y = ray_y[i];
+        m_rotated_x[i] = p.R00 * x + p.R01 * y + p.R02;
+        m_rotated_y[i] = p.R10 * x + p.R11 * y + p.R12;
+        m_rotated_z[i] = p.R20 * x + p.R21 * y + p.R22;
+    }
+    m_t[0] = p.T1;
+    m_t[1] = p.T2;
+    m_t[2] = p.T3;
+
+    // the RGB intrinsics are those of the RGB stream as delivered
+    m_fx = p.fxrgb;
+    m_fy = p.fyrgb;
+    m_cx = p.cxrgb;
+    m_cy = p.cyrgb;
+    m_k1 = p.K1rgb;
+    m_k2 = p.K2rgb;
+    m_k3 = p.K3rgb;
+    m_p1 = p.P1rgb;
+    m_p2 = p.P2rgb;
+    m_distorted = (m_k1 != 0) || (m_k2 != 0) || (m_k3 != 0) || (m_p1 != 0) || (m_p2 != 0);
+
+    /* one depth pixel covers fx_rgb / fx_ir RGB pixels at any distance */
+    double sx = (calibration.width > 0) ? static_cast<double>(depth_width) / calibration.width : 1.0;
+    double sy = (calibration.height > 0) ? static_cast<double>(depth_height) / calibration.height : 1.0;
+    double ratio_x = m_fx / (p.fxir * sx);
+    double ratio_y = m_fy / (p.fyir * sy);
+    m_footprint_x = static_cast<uint16_t>(std::min(std::max(std::ceil(ratio_x - 0.01), 1.0), double(MAX_FOOTPRINT)));
+    m_footprint_y = static_cast<uint16_t>(std::min(std::max(std::ceil(ratio_y - 0.01), 1.0), double(MAX_FOOTPRINT)));
+
+    m_target.resize(pixels);
+    m_target_z.resize(pixels);
+    m_version = calibration.version;
+    m_depth_width = depth_width;
+    m_depth_height = depth_height;
+    m_rgb_width = rgb_width;
+    m_rgb_height = rgb_height;
+    return true;
+}
+
+void DepthRegistration::splatBand(size_t band, const uint16_t *depth)
+{
+    std::vector<std::vector<Splat>> &bins = m_splats[band];
+    for (size_t i = 0; i < bins.size(); i++) {
+        bins[i].clear();
+    }
+    const int rgb_width = static_cast<int>(m_rgb_width);
+    const int rgb_height = static_cast<int>(m_rgb_height);
+    const uint32_t row_begin = static_cast<uint32_t>(band * m_depth_height / m_bands);
+    const uint32_t row_end = static_cast<uint32_t>((band + 1) * m_depth_height / m_bands);
+    const float offset_x = (m_footprint_x - 1) * 0.5f;
+    const float offset_y = (m_footprint_y - 1) * 0.5f;
+    const float *rotated_x = m_rotated_x.data();
+    const float *rotated_y = m_rotated_y.data();
+    const float *rotated_z = m_rotated_z.data();
+    int32_t *target = m_target.data();
+    uint16_t *target_z = m_target_z.data();
+    const float fx = m_fx, fy = m_fy, cx = m_cx, cy = m_cy;
+    const float tx = m_t[0], ty = m_t[1], tz = m_t[2];
+
+    for (size_t i = static_cast<size_t>(row_begin) * m_depth_width; i < static_cast<size_t>(row_end) * m_depth_width;
+         i++) {
+        target[i] = -1;
+        if (depth[i] == 0) {
+            continue;
+        }
+        const float d = depth[i];
+        const float z = d * rotated_z[i] + tz;
+        if (z < 1.0f) {
+            continue;
+        }
+        const float inverse = 1.0f / z;
+        float x = (d * rotated_x[i] + tx) * inverse;
+        float y = (d * rotated_y[i] + ty) * inverse;
+        if (m_distorted) {
+            const float r2 = x * x + y * y;
+            const float radial = 1 + r2 * (m_k1 + r2 * (m_k2 + r2 * m_k3));
+            const float xd = x * radial + 2 * m_p1 * x * y + m_p2 * (r2 + 2 * x * x);
+            const float yd = y * radial + m_p1 * (r2 + 2 * y * y) + 2 * m_p2 * x * y;
+            x = xd;
+            y = yd;
+        }
+        const float u = fx * x + cx;
+        const float v = fy * y + cy;
+        if (!(u > -m_footprint_x) || !(v > -m_footprint_y) || !(u < rgb_width + m_footprint_x)
+            || !(v < rgb_height + m_footprint_y)) {
+            continue;
+        }
+        const uint16_t zi = static_cast<uint16_t>(std::min(z + 0.5f, 65535.0f));
+
+        // u and v are above -MAX_FOOTPRINT, shifting them positive makes truncation a floor
+        const int cu = static_cast<int>(u + 0.5f + MAX_FOOTPRINT) - MAX_FOOTPRINT;
+        const int cv = static_cast<int>(v + 0.5f + MAX_FOOTPRINT) - MAX_FOOTPRINT;
+        if ((cu >= 0) && (cu < rgb_width) && (cv >= 0) && (cv < rgb_height)) {
+            target[i] = cv * rgb_width + cu;
+            target_z[i] = zi;
+        }
+
+        int u0 = static_cast<int>(u - offset_x + 0.5f + MAX_FOOTPRINT) - MAX_FOOTPRINT;
+        int u1 = std::min(u0 + m_footprint_x, rgb_width);
+        u0 = std::max(u0, 0);
+        const int v0 = static_cast<int>(v - offset_y + 0.5f + MAX_FOOTPRINT) - MAX_FOOTPRINT;
+        for (int row = std::max(v0, 0); (row < v0 + m_footprint_y) && (row < rgb_height); row++) {
+            if (u0 >= u1) {
+                break;
+            }
+            Splat splat;
+            splat.index = static_cast<uint32_t>(row * rgb_width + u0);
+            splat.z = zi;
+            splat.count = static_cast<uint16_t>(u1 - u0);
+            bins[static_cast<size_t>(row) * m_bands / m_rgb_height].push_back(splat);
+        }
+    }
+}
+
+void DepthRegistration::mergeBand(size_t band, RegisteredFrame &frame)
+{
+    std::vector<uint16_t> &zbuffer = (m_mode & DEPTH_TO_RGB) ? frame.depth : m_zbuffer;
+    // rows whose band index row * bands / height is this band
+    const size_t row_begin = (band * m_rgb_height + m_bands - 1) / m_bands;
+    const size_t row_end = ((band + 1) * m_rgb_height + m_bands - 1) / m_bands;
+    std::fill(zbuffer.begin() + row_begin * m_rgb_width, zbuffer.begin() + row_end * m_rgb_width, 0);
+
+    uint16_t *z = zbuffer.data();
+    for (size_t source = 0; source < m_bands; source++) {
+        const std::vector<Splat> &bin = m_splats[source][band];
+        for (size_t i = 0; i < bin.size(); i++) {
+            const Splat &splat = bin[i];
+            uint16_t *pixel = z + splat.index;
+            for (uint16_t k = 0; k < splat.count; k++) {
+                if ((pixel[k] == 0) || (splat.z < pixel[k])) {
+                    pixel[k] = splat.z;
+                }
+            }
+        }
+    }
+}
+
+void DepthRegistration::sampleBand(size_t band, const uint8_t *bgr, RegisteredFrame &frame)
+{
+    const std::vector<uint16_t> &zbuffer = (m_mode & DEPTH_TO_RGB) ? frame.depth : m_zbuffer;
+    const size_t begin = (band * m_depth_height / m_bands) * m_depth_width;
+    const size_t end = ((band + 1) * m_depth_height / m_bands) * m_depth_width;
+    uint8_t *out = frame.rgb.data();
+    for (size_t i = begin; i < end; i++) {
+        const int32_t target = m_target[i];
+        uint8_t *pixel = out + i * 3;
+        if (target >= 0) {
+            // something nearer took the RGB pixel, this surface is hidden from the RGB camera
+            const uint32_t nearest = zbuffer[target];
+            if (m_target_z[i] <= nearest + OCCLUSION_TOLERANCE_MM + (nearest >> OCCLUSION_TOLERANCE_SHIFT)) {
+                const uint8_t *source = bgr + static_cast<size_t>(target) * 3;
+                pixel[0] = source[0];
+                pixel[1] = source[1];
+                pixel[2] = source[2];
+                continue;
+            }
+        }
+        pixel[0] = pixel[1] = pixel[2] = 0;
+    }
+}
+
+bool DepthRegistration::process(const AS_SDK_Data_s &data, const CameraCalibration &calibration,
+                                RegisteredFrame &frame)
+{
+    const AS_Frame_s &depth = data.depthImg;
+    const AS_Frame_s &rgb = data.rgbImg;
+    const size_t depth_pixels = static_cast<size_t>(depth.width) * depth.height;
+    const size_t rgb_pixels = static_cast<size_t>(rgb.width) * rgb.height;
+    if ((depth.data == nullptr) || (depth_pixels == 0)
+        || (static_cast<size_t>(depth.size) < depth_pixels * sizeof(uint16_t)) || (rgb_pixels == 0)) {
+        return false;
+    }
+    if ((m_mode & RGB_TO_DEPTH) && ((rgb.data == nullptr) || (static_cast<size_t>(rgb.size) < rgb_pixels * 3))) {
+        return false;
+    }
+    if (!prepare(calibration, depth.width, depth.height, rgb.width, rgb.height)) {
+        return false;
+    }
+
+    frame.timestamp = depth.ts;
+    frame.frame_id = depth.frameId;
+    if (m_mode & DEPTH_TO_RGB) {
+        frame.depth_width = rgb.width;
+        frame.depth_height = rgb.height;
+        frame.depth.resize(rgb_pixels);
+    } else {
+        frame.depth_width = frame.depth_height = 0;
+        frame.depth.clear();
+        m_zbuffer.resize(rgb_pixels);
+    }
+    if (m_mode & RGB_TO_DEPTH) {
+        frame.rgb_width = depth.width;
+        frame.rgb_height = depth.height;
+        frame.rgb.resize(depth_pixels * 3);
+    } else {
+        frame.rgb_width = frame.rgb_height = 0;
+        frame.rgb.clear();
+    }
+
+    const uint16_t *depth_data = static_cast<const uint16_t *>(depth.data);
+    runBands([&](size_t band) {
+        splatBand(band, depth_data);
+    });
+    runBands([&](size_t band) {
+        mergeBand(band, frame);
+    });
+    if (m_mode & RGB_TO_DEPTH) {
+        const uint8_t *bgr = static_cast<const uint8_t *>(rgb.data);
+        runBands([&](size_t band) {
+            sampleBand(band, bgr, frame);
+        });
+    }
+    return true;
+}
+
+std::shared_ptr<const RegisteredFrame> DepthRegistration::process(const AS_SDK_Data_s &data,
+                                                                  const CameraCalibration &calibration)
+{
+    std::shared_ptr<RegisteredFrame> frame = m_pool.acquire();
+    if (!frame) {
+        return nullptr;
+    }
+    if (!process(data, calibration, *frame)) {
+        return nullptr;
+    }
+    return frame;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file      EventTracer.cpp
+ * @brief     Begin/end events of every thread, dumped as Chrome trace JSON
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "EventTracer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/* rings of exited threads are only reused beyond this, so their events survive thread churn */
+#define MAX_RINGS   64
+
+namespace
+{
+
+struct Event {
+    std::atomic<uint64_t> ts;           /* steady clock ns */
+    std::atomic<const char *> name;
+    std::atomic<char> phase;            /* 'B' or 'E' */
+};
+
+/* written by one thread only, copied by dump() */
+struct ThreadRing {
+    std::unique_ptr<Event[]> events;
+    size_t mask;
+    std::atomic<uint64_t> head;         /* events ever written */
+    pid_t tid;
+    std::string thread_name;
+};
+
+struct CopiedEvent {
+    uint64_t ts;
+    const char *name;
+    char phase;
+};
+
+/* the lock is never held while events are written */
+struct Registry {
+    std::mutex mutex;
+    /* every ring ever handed out, and those of exited threads, oldest first */
+    std::vector<ThreadRing *> rings;
+    std::deque<ThreadRing *> free_rings;
+    std::set<std::string> names;
+    size_t capacity = 32768;
+};
+
+std::atomic<bool> s_enabled(false);
+
+/* never freed: threads still exit and return their rings while globals are destroyed */
+Registry &registry()
+{
+    static Registry *s_registry = new Registry();
+    return *s_registry;
+}
+
+/* hands the ring back when the thread exits, its events stay until the ring is reused */
+struct ThreadSlot {
+    ThreadRing *ring = nullptr;
+    ~ThreadSlot()
+    {
+        if (ring != nullptr) {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.free_rings.push_back(ring);
+        }
+    }
+};
+thread_local ThreadSlot t_slot;
+
+ThreadRing *threadRing()
+{
+    if (t_slot.ring != nullptr) {
+        return t_slot.ring;
+    }
+
+    char name[16] = {0};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    ThreadRing *ring = nullptr;
+    if ((r.rings.size() >= MAX_RINGS) && !r.free_rings.empty()) {
+        ring = r.free_rings.front();
+        r.free_rings.pop_front();
+    } else {
+        ring = new ThreadRing();
+        size_t size = 1;
+        while (size < r.capacity) {
+            size <<= 1;
+        }
+        ring->events.reset(new Event[size]);
+        ring->mask = size - 1;
+        r.rings.push_back(ring);
+    }
+    // dump() holds the lock as well, it never sees a half reset ring
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tid = static_cast<pid_t>(syscall(SYS_gettid));
+    ring->thread_name = name;
+    t_slot.ring = ring;
+    return ring;
+}
+
+uint64_t steadyNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void append(const char *name, char phase)
+{
+    ThreadRing *ring = threadRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    Event &event = ring->events[head & ring->mask];
+    event.ts.store(steadyNs(), std::memory_order_relaxed);
+    event.name.store(name, std::memory_order_relaxed);
+    event.phase.store(phase, std::memory_order_relaxed);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void writeString(FILE *fp, const char *value)
+{
+    fputc('"', fp);
+    for (const char *c = value; *c != '\0'; c++) {
+        if ((*c == '"') || (*c == '\\')) {
+            fputc('\\', fp);
+            fputc(*c, fp);
+        } else if (static_cast<unsigned char>(*c) < 0x20) {
+            fprintf(fp, "\\u%04x", *c);
+        } else {
+            fputc(*c, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+}
+
+void EventTracer::setEnabled(bool enable)
+{
+    s_enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool EventTracer::enabled()
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+void EventTracer::setCapacity(size_t events)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (r.rings.empty() && (events > 0)) {
+        r.capacity = events;
+    }
+}
+
+void EventTracer::begin(const char *name)
+{
+    if (enabled()) {
+        append(name, 'B');
+    }
+}
+
+void EventTracer::end(const char *name)
+{
+    if (enabled()) {
+        append(name, 'E');
+    }
+}
+
+const char *EventTracer::intern(const std::string &name)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    return r.names.insert(name).first->c_str();
+}
+
+bool EventTracer::dump(const std::string &path)
+{
+    FILE *fp = fopen(path.c_str(), "w");
+    if (fp == nullptr) {
+        return false;
+    }
+
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    const int pid = getpid();
+    std::vector<CopiedEvent> copy;
+    bool first = true;
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (size_t n = 0; n < r.rings.size(); n++) {
+        ThreadRing &ring = *r.rings[n];
+        const uint64_t size = ring.mask + 1;
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        uint64_t begin = (head > size) ? head - size : 0;
+        copy.resize(head - begin);
+        for (uint64_t i = begin; i < head; i++) {
+            const Event &event = ring.events[i & ring.mask];
+            copy[i - begin].ts = event.ts.load(std::memory_order_relaxed);
+            copy[i - begin].name = event.name.load(std::memory_order_relaxed);
+            copy[i - begin].phase = event.phase.load(std::memory_order_relaxed);
+        }
+        // the owner kept writing, drop what it overwrote and the slot it may be writing now
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t now = ring.head.load(std::memory_order_relaxed);
+        uint64_t valid = (now + 1 > size) ? now + 1 - size : 0;
+        size_t skip = (valid > begin) ? std::min<uint64_t>(valid - begin, copy.size()) : 0;
+
+        fprintf(fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+                first ? "" : ",", pid, ring.tid);
+        writeString(fp, ring.thread_name.c_str());
+        fprintf(fp, "}}");
+        first = false;
+        for (size_t i = skip; i < copy.size(); i++) {
+            fprintf(fp, ",\n{\"name\":");
+            writeString(fp, copy[i].name);
+            fprintf(fp, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}", copy[i].phase, copy[i].ts / 1000.0, pid,
+                    ring.tid);
+        }
+    }
+    fprintf(fp, "\n]}\n");
+    bool ok = (ferror(fp) == 0);
+    return (fclose(fp) == 0) && ok;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file      FramePool.cpp
+ * @brief     Fixed capacity pool of refcounted frame buffers
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "FramePool.h"
+#include <cstring>
+#include "Logger.h"
+
+FrameBuffer::FrameBuffer() : m_refs(0), m_sequence(0)
+{
+    memset(&m_trace, 0, sizeof(m_trace));
+    for (int i = 0; i < AS_FRAME_TYPE_BUTT; i++) {
+        memset(&framePlane(m_data, i), 0, sizeof(AS_Frame_s));
+        m_planes[i].capacity = 0;
+    }
+}
+
+FrameRef::FrameRef(const FrameRef &other) : m_buffer(other.m_buffer)
+{
+    if (m_buffer != nullptr) {
+        m_buffer->m_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameRef::FrameRef(FrameRef &&other) : m_buffer(other.m_buffer)
+{
+    other.m_buffer = nullptr;
+}
+
+FrameRef::~FrameRef()
+{
+    reset();
+}
+
+FrameRef &FrameRef::operator = (const FrameRef &other)
+{
+    if (other.m_buffer != nullptr) {
+        other.m_buffer->m_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    reset();
+    m_buffer = other.m_buffer;
+    return *this;
+}
+
+FrameRef &FrameRef::operator = (FrameRef &&other)
+{
+    if (this != &other) {
+        reset();
+        m_buffer = other.m_buffer;
+        other.m_buffer = nullptr;
+    }
+    return *this;
+}
+
+void FrameRef::reset()
+{
+    if (m_buffer == nullptr) {
+        return;
+    }
+    if (m_buffer->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        FramePool::recycle(m_buffer);
+    }
+    m_buffer = nullptr;
+}
+
+std::shared_ptr<FramePool> FramePool::create(size_t slots, const size_t capacity[AS_FRAME_TYPE_BUTT])
+{
+    std::shared_ptr<FramePool> pool(new FramePool());
+    pool->m_slots.reserve(slots);
+    pool->m_free.reserve(slots);
+    for (size_t i = 0; i < slots; i++) {
+        std::unique_ptr<FrameBuffer> slot(new FrameBuffer());
+        for (int type = 0; type < AS_FRAME_TYPE_BUTT; type++) {
+            if (capacity[type] > 0) {
+                slot->m_planes[type].buffer.reset(new uint8_t[capacity[type]]);
+                slot->m_planes[type].capacity = capacity[type];
+            }
+        }
+        pool->m_free.push_back(slot.get());
+        pool->m_slots.push_back(std::move(slot));
+    }
+    return pool;
+}
+
+FrameRef FramePool::acquire(const AS_SDK_Data_s *pstData, PlaneFilter *filter)
+{
+    FrameBuffer *slot = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_free_mutex);
+        if (!m_free.empty()) {
+            slot = m_free.back();
+            m_free.pop_back();
+            slot->m_sequence = m_sequence++;
+        }
+    }
+    if (slot == nullptr) {
+        m_exhausted++;
+        return FrameRef();
+    }
+
+    slot->m_owner = shared_from_this();
+    slot->m_refs.store(1, std::memory_order_relaxed);
+    slot->m_trace.camera = UINT32_MAX;
+    slot->m_trace.arrival_ns = 0;
+    slot->m_trace.enqueue_ns = 0;
+
+    // The only copy of the SDK data, consumers share the slot from here on.
+    // pointCloud2 is only filled by lidar models and is not carried.
+    for (int type = 0; type < AS_FRAME_TYPE_BUTT; type++) {
+        const AS_Frame_s &src = framePlane(*pstData, type);
+        AS_Frame_s &dst = framePlane(slot->m_data, type);
+        FrameBuffer::Plane &plane = slot->m_planes[type];
+
+        dst = src;
+        if ((src.size == 0) || (src.data == nullptr)) {
+            dst.size = 0;
+            dst.data = nullptr;
+            continue;
+        }
+        if (src.size > plane.capacity) {
+            // stream mode grew past the size reserved at attach, grow once
+            LOG(WARN) << "frame plane " << type << " grows from " << plane.capacity << " to " << src.size << std::endl;
+            plane.buffer.reset(new uint8_t[src.size]);
+            plane.capacity = src.size;
+        }
+        if ((filter == nullptr) || !filter->filter(type, src, plane.buffer.get())) {
+            memcpy(plane.buffer.get(), src.data, src.size);
+        }
+        dst.data = plane.buffer.get();
+        dst.bufferSize = plane.capacity;
+    }
+
+    return FrameRef(slot);
+}
+
+void FramePool::recycle(FrameBuffer *buffer)
+{
+    // Drop the owner reference last, it may be what keeps the pool alive
+    std::shared_ptr<FramePool> owner;
+    owner.swap(buffer->m_owner);
+    std::lock_guard<std::mutex> lock(owner->m_free_mutex);
+    owner->m_free.push_back(buffer);
+}
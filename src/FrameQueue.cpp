@@ -0,0 +1,172 @@
+/**
+ * @file      FrameQueue.cpp
+ * @brief     Bounded lock-free single producer/single consumer frame queue
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "FrameQueue.h"
+#include <climits>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+FrameQueue::FrameQueue(size_t capacity)
+    : m_mask(0)
+    , m_tail(0)
+    , m_head(0)
+    , m_last_sequence(0)
+    , m_has_last(false)
+    , m_consumed(0)
+    , m_signal(0)
+    , m_waiting(false)
+    , m_closed(false)
+    , m_dropped(0)
+{
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    m_mask = size - 1;
+    m_slots.reset(new std::atomic<FrameBuffer *>[size]);
+    for (size_t i = 0; i < size; i++) {
+        m_slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+FrameQueue::~FrameQueue()
+{
+    for (size_t i = 0; i <= m_mask; i++) {
+        FrameBuffer *buffer = m_slots[i].exchange(nullptr, std::memory_order_acquire);
+        if (buffer != nullptr) {
+            FrameRef drop(buffer);
+        }
+    }
+}
+
+bool FrameQueue::push(const FrameRef &frame)
+{
+    if (!frame) {
+        return true;
+    }
+
+    // the queue keeps its own reference until the consumer adopts it
+    FrameRef ref(frame);
+    FrameBuffer *buffer = ref.m_buffer;
+    ref.m_buffer = nullptr;
+
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    FrameBuffer *old = m_slots[tail & m_mask].exchange(buffer, std::memory_order_acq_rel);
+    m_tail.store(tail + 1, std::memory_order_release);
+    wake();
+
+    if (old != nullptr) {
+        // still unread a lap later: the consumer is behind, latest wins
+        FrameRef drop(old);
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void FrameQueue::wake()
+{
+    m_signal.fetch_add(1, std::memory_order_seq_cst);
+    if (m_waiting.load(std::memory_order_seq_cst)) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&m_signal), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+    }
+}
+
+bool FrameQueue::tryPop(FrameRef &frame)
+{
+    uint64_t tail = m_tail.load(std::memory_order_acquire);
+    while (m_head != tail) {
+        if (tail - m_head > capacity()) {
+            // lapped, the producer already dropped everything before this
+            m_head = tail - capacity();
+        }
+        FrameBuffer *buffer = m_slots[m_head & m_mask].exchange(nullptr, std::memory_order_acq_rel);
+        m_head++;
+        m_consumed.store(m_head, std::memory_order_relaxed);
+        if (buffer == nullptr) {
+            continue;
+        }
+        FrameRef ref(buffer);
+        // a slot may hold a newer frame than its position when the producer
+        // lapped us mid-read, never hand out a frame older than the last one
+        if (m_has_last && (buffer->sequence() <= m_last_sequence)) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        m_last_sequence = buffer->sequence();
+        m_has_last = true;
+        frame = std::move(ref);
+        return true;
+    }
+    return false;
+}
+
+bool FrameQueue::pop(FrameRef &frame, int timeout_ms)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    if (timeout_ms > 0) {
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += static_cast<long>(timeout_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    for (;;) {
+        if (tryPop(frame)) {
+            return true;
+        }
+        if (m_closed.load(std::memory_order_acquire) || (timeout_ms == 0)) {
+            return false;
+        }
+
+        // read the futex word before the re-check, a push in between changes it
+        uint32_t signal = m_signal.load(std::memory_order_seq_cst);
+        m_waiting.store(true, std::memory_order_seq_cst);
+        if (tryPop(frame)) {
+            m_waiting.store(false, std::memory_order_relaxed);
+            return true;
+        }
+
+        struct timespec remaining;
+        struct timespec *timeout = nullptr;
+        if (timeout_ms > 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+            remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (remaining.tv_nsec < 0) {
+                remaining.tv_sec--;
+                remaining.tv_nsec += 1000000000;
+            }
+            if (remaining.tv_sec < 0) {
+                m_waiting.store(false, std::memory_order_relaxed);
+                return tryPop(frame);
+            }
+            timeout = &remaining;
+        }
+        if (!m_closed.load(std::memory_order_acquire)) {
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&m_signal), FUTEX_WAIT_PRIVATE, signal, timeout, nullptr, 0);
+        }
+        m_waiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+void FrameQueue::close()
+{
+    m_closed.store(true, std::memory_order_release);
+    m_waiting.store(true, std::memory_order_seq_cst);
+    wake();
+}
@@ -0,0 +1,322 @@
+/**
+ * @file      GroundPlane.cpp
+ * @brief     Floor plane fitted to the depth by RANSAC, and the pixels above it
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "GroundPlane.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/* depth pixels sampled per frame */
+#define GRID_POINTS             4800
+/* fewer valid samples and the frame is skipped */
+#define MIN_POINTS              64
+/* random triples per refit */
+#define RANSAC_ITERATIONS       100
+/* a floor holds at least this share of the samples */
+#define MIN_INLIER_RATIO        0.15f
+/* refit once the share on the current plane falls below this part of the share at the last fit */
+#define REFIT_RATIO             0.8f
+/* largest angle in degrees between the floor normal and the camera's up axis */
+#define MAX_TILT_DEG            60.0
+/* frames the floor may stay hidden, e.g. behind a near obstacle, before the plane is dropped */
+#define LOST_FRAMES             30
+/* a refit this close to the previous plane moves it by this share only */
+#define SMOOTHING               0.3f
+#define SMOOTH_MAX_ANGLE_DEG    10.0
+#define SMOOTH_MAX_OFFSET_MM    150.0f
+/* pooled masks, a consumer that holds more just misses masks */
+#define MAX_POOLED_MASKS        16
+
+static const float DEG_TO_RAD = 3.14159265f / 180.0f;
+
+GroundPlaneEstimator::GroundPlaneEstimator(uint16_t tolerance)
+    : m_tolerance(tolerance), m_seed(0x9e3779b9u), m_fit_ratio(0), m_floor_ratio(0), m_unsupported(0)
+{
+    memset(&m_plane, 0, sizeof(m_plane));
+    m_latest = m_plane;
+}
+
+uint32_t GroundPlaneEstimator::random()
+{
+    // xorshift32, plenty for picking samples
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return m_seed;
+}
+
+size_t GroundPlaneEstimator::countInliers(const float normal[3], float offset) const
+{
+    const float nx = normal[0];
+    const float ny = normal[1];
+    const float nz = normal[2];
+    const float tolerance = m_tolerance;
+    size_t count = 0;
+    for (size_t i = 0; i < m_points.size(); i++) {
+        const Point &p = m_points[i];
+        count += (std::fabs(nx * p.x + ny * p.y + nz * p.z + offset) <= tolerance) ? 1 : 0;
+    }
+    return count;
+}
+
+bool GroundPlaneEstimator::fit(GroundPlane &plane, float &ratio)
+{
+    const size_t n = m_points.size();
+    const float min_up = static_cast<float>(std::cos(MAX_TILT_DEG * DEG_TO_RAD));
+    size_t best = 0;
+    float best_normal[3] = { 0, 0, 0 };
+    float best_offset = 0;
+    for (int iteration = 0; iteration < RANSAC_ITERATIONS; iteration++) {
+        const Point &a = m_points[random() % n];
+        const Point &b = m_points[random() % n];
+        const Point &c = m_points[random() % n];
+        const float ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+        const float vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+        float normal[3] = { uy * vz - uz * vy, uz * vx - ux * vz, ux * vy - uy * vx };
+        const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length < 1e-3f) {
+            continue;
+        }
+        normal[0] /= length;
+        normal[1] /= length;
+        normal[2] /= length;
+        float offset = -(normal[0] * a.x + normal[1] * a.y + normal[2] * a.z);
+        if (offset < 0) {
+            // the camera is on the positive side of its floor
+            normal[0] = -normal[0];
+            normal[1] = -normal[1];
+            normal[2] = -normal[2];
+            offset = -offset;
+        }
+        // y points down in the camera frame, a floor's normal points up
+        if (-normal[1] < min_up) {
+            continue;
+        }
+        size_t count = countInliers(normal, offset);
+        if (count > best) {
+            best = count;
+            memcpy(best_normal, normal, sizeof(best_normal));
+            best_offset = offset;
+        }
+    }
+    if (best < MIN_INLIER_RATIO * n) {
+        return false;
+    }
+
+    /* least squares over the inliers, y = a x + b z + c since the floor is far from vertical */
+    double sxx = 0, sxz = 0, szz = 0, sx = 0, sz = 0, sxy = 0, szy = 0, sy = 0, count = 0;
+    for (size_t i = 0; i < n; i++) {
+        const Point &p = m_points[i];
+        if (std::fabs(best_normal[0] * p.x + best_normal[1] * p.y + best_normal[2] * p.z + best_offset) > m_tolerance) {
+            continue;
+        }
+        sxx += p.x * p.x;
+        sxz += p.x * p.z;
+        szz += p.z * p.z;
+        sx += p.x;
+        sz += p.z;
+        sxy += p.x * p.y;
+        szy += p.z * p.y;
+        sy += p.y;
+        count += 1;
+    }
+    const double det = sxx * (szz * count - sz * sz) - sxz * (sxz * count - sz * sx) + sx * (sxz * sz - szz * sx);
+    if (std::fabs(det) > 1e-9) {
+        const double a = (sxy * (szz * count - sz * sz) - sxz * (szy * count - sz * sy) + sx * (szy * sz - szz * sy)) / det;
+        const double b = (sxx * (szy * count - sy * sz) - sxy * (sxz * count - sz * sx) + sx * (sxz * sy - szy * sx)) / det;
+        const double c = (sxx * (szz * sy - sz * szy) - sxz * (sxz * sy - sx * szy) + sxy * (sxz * sz - szz * sx)) / det;
+        // a x - y + b z + c = 0, c > 0 with the camera above the floor
+        const double length = std::sqrt(a * a + 1 + b * b);
+        const double sign = (c < 0) ? -1.0 : 1.0;
+        float normal[3] = { static_cast<float>(sign * a / length), static_cast<float>(-sign / length),
+                            static_cast<float>(sign * b / length) };
+        float offset = static_cast<float>(sign * c / length);
+        size_t refined = countInliers(normal, offset);
+        if (refined >= best) {
+            best = refined;
+            memcpy(best_normal, normal, sizeof(best_normal));
+            best_offset = offset;
+        }
+    }
+
+    memcpy(plane.normal, best_normal, sizeof(plane.normal));
+    plane.offset = best_offset;
+    ratio = static_cast<float>(best) / n;
+    return true;
+}
+
+bool GroundPlaneEstimator::update(const AS_Frame_s &depth, const CameraCalibration &calibration)
+{
+    const size_t pixels = static_cast<size_t>(depth.width) * depth.height;
+    if ((depth.data == nullptr) || (pixels == 0) || (static_cast<size_t>(depth.size) < pixels * sizeof(uint16_t))) {
+        return false;
+    }
+    if (!m_projector.prepare(calibration, depth.width, depth.height)) {
+        return false;
+    }
+
+    const uint16_t *data = static_cast<const uint16_t *>(depth.data);
+    const float *ray_x = m_projector.raysX().data();
+    const float *ray_y = m_projector.raysY().data();
+    const uint32_t step = std::max<uint32_t>(1, static_cast<uint32_t>(std::sqrt(static_cast<double>(pixels) /
+                                                                                  GRID_POINTS) + 0.5));
+    m_points.clear();
+    for (uint32_t v = step / 2; v < depth.height; v += step) {
+        for (uint32_t u = step / 2; u < depth.width; u += step) {
+            const size_t i = static_cast<size_t>(v) * depth.width + u;
+            if (data[i] == 0) {
+                continue;
+            }
+            const float z = data[i];
+            Point p = { z * ray_x[i], z * ray_y[i], z };
+            m_points.push_back(p);
+        }
+    }
+    if (m_points.size() < MIN_POINTS) {
+        return false;
+    }
+
+    bool refit = true;
+    if (m_plane.valid) {
+        const float ratio = static_cast<float>(countInliers(m_plane.normal, m_plane.offset)) / m_points.size();
+        m_plane.inlier_ratio = ratio;
+        refit = (ratio < MIN_INLIER_RATIO) || (ratio < m_fit_ratio * REFIT_RATIO);
+    }
+    if (refit) {
+        GroundPlane fitted = m_plane;
+        float ratio = 0;
+        m_plane.fits++;
+        bool found = fit(fitted, ratio);
+        const float cosine = m_plane.normal[0] * fitted.normal[0] + m_plane.normal[1] * fitted.normal[1] +
+                             m_plane.normal[2] * fitted.normal[2];
+        const bool close = m_plane.valid && (cosine > std::cos(SMOOTH_MAX_ANGLE_DEG * DEG_TO_RAD)) &&
+                           (std::fabs(m_plane.offset - fitted.offset) < SMOOTH_MAX_OFFSET_MM);
+        if (found && m_plane.valid && !close && (ratio < m_floor_ratio * REFIT_RATIO)) {
+            /* another plane with less support than the floor had, most likely whatever hides the floor */
+            found = false;
+        }
+        if (!found) {
+            if (++m_unsupported >= LOST_FRAMES) {
+                m_plane.valid = false;
+            }
+        } else {
+            m_unsupported = 0;
+            if (close) {
+                // the same floor seen again, damp the noise of single fits
+                float normal[3];
+                float length = 0;
+                for (int k = 0; k < 3; k++) {
+                    normal[k] = m_plane.normal[k] + SMOOTHING * (fitted.normal[k] - m_plane.normal[k]);
+                    length += normal[k] * normal[k];
+                }
+                length = std::sqrt(length);
+                for (int k = 0; k < 3; k++) {
+                    m_plane.normal[k] = normal[k] / length;
+                }
+                m_plane.offset += SMOOTHING * (fitted.offset - m_plane.offset);
+            } else {
+                memcpy(m_plane.normal, fitted.normal, sizeof(m_plane.normal));
+                m_plane.offset = fitted.offset;
+                m_floor_ratio = ratio;
+            }
+            m_plane.valid = true;
+            m_plane.inlier_ratio = ratio;
+            m_fit_ratio = ratio;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_plane_mutex);
+    m_latest = m_plane;
+    return refit;
+}
+
+GroundPlane GroundPlaneEstimator::plane()
+{
+    std::lock_guard<std::mutex> lock(m_plane_mutex);
+    return m_latest;
+}
+
+GroundMask::GroundMask()
+    : m_pool(MAX_POOLED_MASKS)
+{
+}
+
+bool GroundMask::build(const AS_Frame_s &depth, const CameraCalibration &calibration, const GroundPlane &plane,
+                       float height, GroundMaskFrame &mask)
+{
+    const size_t pixels = static_cast<size_t>(depth.width) * depth.height;
+    if (!plane.valid || (depth.data == nullptr) || (pixels == 0) ||
+        (static_cast<size_t>(depth.size) < pixels * sizeof(uint16_t))) {
+        return false;
+    }
+    if (!m_projector.prepare(calibration, depth.width, depth.height)) {
+        return false;
+    }
+    mask.timestamp = depth.ts;
+    mask.frame_id = depth.frameId;
+    mask.width = depth.width;
+    mask.height = depth.height;
+    mask.mask.resize(pixels);
+
+    const uint16_t *data = static_cast<const uint16_t *>(depth.data);
+    const float *ray_x = m_projector.raysX().data();
+    const float *ray_y = m_projector.raysY().data();
+    const float nx = plane.normal[0], ny = plane.normal[1], nz = plane.normal[2];
+    // height above the floor minus the threshold, > 0 for obstacles
+    const float bias = plane.offset - height;
+    uint8_t *out = mask.mask.data();
+    for (size_t i = 0; i < pixels; i++) {
+        const float d = data[i];
+        const float above = d * (nx * ray_x[i] + ny * ray_y[i] + nz) + bias;
+        out[i] = ((data[i] != 0) && (above > 0)) ? 255 : 0;
+    }
+    return true;
+}
+
+std::shared_ptr<const GroundMaskFrame> GroundMask::build(const AS_Frame_s &depth, const CameraCalibration &calibration,
+                                                         const GroundPlane &plane, float height)
+{
+    std::shared_ptr<GroundMaskFrame> mask = m_pool.acquire();
+    if (!mask) {
+        return nullptr;
+    }
+    if (!build(depth, calibration, plane, height, *mask)) {
+        return nullptr;
+    }
+    return mask;
+}
+
+bool GroundMask::removeGround(const AS_Frame_s &depth, const CameraCalibration &calibration, const GroundPlane &plane,
+                              float height, std::vector<uint16_t> &out)
+{
+    const size_t pixels = static_cast<size_t>(depth.width) * depth.height;
+    if (!plane.valid || (depth.data == nullptr) || (pixels == 0) ||
+        (static_cast<size_t>(depth.size) < pixels * sizeof(uint16_t))) {
+        return false;
+    }
+    if (!m_projector.prepare(calibration, depth.width, depth.height)) {
+        return false;
+    }
+    out.resize(pixels);
+
+    const uint16_t *data = static_cast<const uint16_t *>(depth.data);
+    const float *ray_x = m_projector.raysX().data();
+    const float *ray_y = m_projector.raysY().data();
+    const float nx = plane.normal[0], ny = plane.normal[1], nz = plane.normal[2];
+    const float bias = plane.offset - height;
+    uint16_t *result = out.data();
+    for (size_t i = 0; i < pixels; i++) {
+        const float d = data[i];
+        const float above = d * (nx * ray_x[i] + ny * ray_y[i] + nz) + bias;
+        result[i] = (above > 0) ? data[i] : 0;
+    }
+    return true;
+}
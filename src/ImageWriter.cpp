@@ -0,0 +1,224 @@
+/**
+ * @file      ImageWriter.cpp
+ * @brief     Background image writer with a bounded queue and batched fsync
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "ImageWriter.h"
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "Logger.h"
+#include "EventTracer.h"
+#include "common.h"
+
+ImageWriter::ImageWriter(size_t depth, size_t sync_batch)
+    : m_jobs(depth > 0 ? depth : 1)
+    , m_head(0)
+    , m_count(0)
+    , m_sync_batch(sync_batch > 0 ? sync_batch : 1)
+    , m_running(false)
+    , m_completed(0)
+    , m_failed(0)
+    , m_dropped(0)
+{
+    /* resolved once, only used to log where files went */
+    char cwd[PATH_MAX] = {0};
+    if (getcwd(cwd, sizeof(cwd)) != nullptr) {
+        m_cwd = cwd;
+    }
+}
+
+ImageWriter::~ImageWriter()
+{
+    stop();
+}
+
+void ImageWriter::start()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    m_thread = std::thread(&ImageWriter::writerThread, this);
+}
+
+void ImageWriter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    logStats();
+}
+
+bool ImageWriter::writeRaw(const std::string &path, const FrameRef &frame, const void *data, size_t size)
+{
+    return enqueue(JOB_RAW, path, frame, data, size);
+}
+
+bool ImageWriter::writePointCloud(const std::string &path, const FrameRef &frame, const float *points, size_t length)
+{
+    return enqueue(JOB_POINT_CLOUD, path, frame, points, length * sizeof(float));
+}
+
+bool ImageWriter::enqueue(JobType type, const std::string &path, const FrameRef &frame, const void *data, size_t size)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_running || (m_count == m_jobs.size())) {
+        lock.unlock();
+        m_dropped++;
+        LOG(WARN) << "image writer busy, dropped " << path << std::endl;
+        return false;
+    }
+
+    Job &job = m_jobs[(m_head + m_count) % m_jobs.size()];
+    job.type = type;
+    job.path = path;
+    job.frame = frame;
+    if (frame) {
+        job.data = data;
+    } else {
+        // not pooled (merge frames), the caller's buffer is gone after return
+        job.buffer.assign(static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + size);
+        job.data = job.buffer.data();
+    }
+    job.size = size;
+    m_count++;
+    lock.unlock();
+    m_cond.notify_one();
+    return true;
+}
+
+void ImageWriter::writerThread()
+{
+    pthread_setname_np(pthread_self(), "image_writer");
+
+    Job current;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if ((m_count == 0) && !m_pending.empty()) {
+                // idle: make the batch durable before waiting
+                lock.unlock();
+                syncPending();
+                lock.lock();
+            }
+            m_cond.wait(lock, [this]() {
+                return (m_count > 0) || !m_running;
+            });
+            if (m_count == 0) {
+                break;
+            }
+            // take the job out, its (already grown) buffer goes back into the ring
+            Job &job = m_jobs[m_head];
+            bool owned = !job.frame;
+            current.type = job.type;
+            current.path.swap(job.path);
+            current.frame = std::move(job.frame);
+            current.size = job.size;
+            current.buffer.swap(job.buffer);
+            current.data = owned ? current.buffer.data() : job.data;
+            m_head = (m_head + 1) % m_jobs.size();
+            m_count--;
+        }
+
+        if (!process(current)) {
+            m_failed++;
+        }
+        current.frame.reset();
+        if (m_pending.size() >= m_sync_batch) {
+            syncPending();
+        }
+    }
+    syncPending();
+}
+
+bool ImageWriter::process(Job &job)
+{
+    TraceScope trace("writeImage");
+    int fd = -1;
+    if (job.type == JOB_POINT_CLOUD) {
+        // the SDK writes the PCD itself, reopen the result to sync it with the batch
+        if (savePointCloudWithPcdFormat(job.path.c_str(), static_cast<float *>(const_cast<void *>(job.data)),
+                                        job.size / sizeof(float)) != 0) {
+            LOG(ERROR) << "save " << job.path << " failed!" << std::endl;
+            return false;
+        }
+        fd = open(job.path.c_str(), O_RDONLY | O_CLOEXEC);
+    } else {
+        fd = open(job.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            LOG(ERROR) << "save " << job.path << " failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        const uint8_t *data = static_cast<const uint8_t *>(job.data);
+        size_t written = 0;
+        while (written < job.size) {
+            ssize_t ret = write(fd, data + written, job.size - written);
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                LOG(ERROR) << "save " << job.path << " failed: " << strerror(errno) << std::endl;
+                close(fd);
+                return false;
+            }
+            written += ret;
+        }
+    }
+    if (fd < 0) {
+        LOG(ERROR) << "save " << job.path << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    PendingSync pending;
+    pending.fd = fd;
+    pending.path = job.path;
+    m_pending.push_back(pending);
+    return true;
+}
+
+void ImageWriter::syncPending()
+{
+    TraceScope trace("syncImages");
+    for (size_t i = 0; i < m_pending.size(); i++) {
+        if (fdatasync(m_pending[i].fd) == 0) {
+            m_completed++;
+            LOG(INFO) << "save image success! location: " << m_cwd << "/" << m_pending[i].path << std::endl;
+        } else {
+            m_failed++;
+            LOG(ERROR) << "sync " << m_pending[i].path << " failed: " << strerror(errno) << std::endl;
+        }
+        close(m_pending[i].fd);
+    }
+    m_pending.clear();
+}
+
+size_t ImageWriter::backlog()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_count;
+}
+
+void ImageWriter::logStats()
+{
+    LOG(INFO) << "image writer: completed " << m_completed << ", failed " << m_failed
+              << ", dropped " << m_dropped << std::endl;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file      LatencyTracer.cpp
+ * @brief     Per-stage frame latency histograms, from capture to client delivery
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "LatencyTracer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#define SUB_BUCKET_BITS 4
+#define SUB_BUCKETS     (1 << SUB_BUCKET_BITS)
+#define BUCKET_COUNT    (64 * SUB_BUCKETS)
+
+/* samples further from the callback than this are from another clock */
+#define MAX_CAPTURE_NS  (60ULL * 1000000000ULL)
+
+namespace
+{
+
+/* written by one thread only, read by report() */
+struct ThreadHistograms {
+    std::atomic<uint32_t> counts[LatencyTracer::MAX_CAMERAS][LatencyTracer::STAGE_COUNT][BUCKET_COUNT];
+};
+
+std::atomic<bool> s_enabled(false);
+std::mutex s_mutex;
+/* every block ever handed out, and those of exited threads waiting for reuse; never
+   freed, threads still exit and hand their blocks back while globals are destroyed */
+std::vector<ThreadHistograms *> &s_blocks = *new std::vector<ThreadHistograms *>();
+std::vector<ThreadHistograms *> &s_free_blocks = *new std::vector<ThreadHistograms *>();
+std::string s_cameras[LatencyTracer::MAX_CAMERAS];
+uint32_t s_camera_count = 0;
+double s_ticks_per_second = 1000.0;
+bool s_system_clock = true;
+
+/* returns the thread's block to the pool when the thread exits, the counts stay in the report */
+struct ThreadSlot {
+    ThreadHistograms *histograms = nullptr;
+    ~ThreadSlot()
+    {
+        if (histograms != nullptr) {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            s_free_blocks.push_back(histograms);
+        }
+    }
+};
+thread_local ThreadSlot t_slot;
+
+ThreadHistograms *threadHistograms()
+{
+    if (t_slot.histograms == nullptr) {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (!s_free_blocks.empty()) {
+            t_slot.histograms = s_free_blocks.back();
+            s_free_blocks.pop_back();
+        } else {
+            t_slot.histograms = new ThreadHistograms();
+            s_blocks.push_back(t_slot.histograms);
+        }
+    }
+    return t_slot.histograms;
+}
+
+/* exact below 16, then 16 linear sub-buckets per power of two */
+uint32_t bucketIndex(uint64_t value)
+{
+    if (value < SUB_BUCKETS) {
+        return static_cast<uint32_t>(value);
+    }
+    uint32_t exponent = 63 - __builtin_clzll(value);
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKETS +
+           static_cast<uint32_t>((value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+}
+
+/* middle of a bucket */
+double bucketValue(uint32_t index)
+{
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    uint32_t exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    uint64_t width = 1ULL << (exponent - SUB_BUCKET_BITS);
+    uint64_t low = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) * width;
+    return low + width / 2.0;
+}
+
+}
+
+void LatencyTracer::setEnabled(bool enable)
+{
+    s_enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool LatencyTracer::enabled()
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+void LatencyTracer::setCaptureClock(double ticks_per_second, bool system_clock)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_ticks_per_second = (ticks_per_second > 0) ? ticks_per_second : 1000.0;
+    s_system_clock = system_clock;
+}
+
+uint64_t LatencyTracer::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t LatencyTracer::registerCamera(const std::string &serial)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (uint32_t i = 0; i < s_camera_count; i++) {
+        if (s_cameras[i] == serial) {
+            return i;
+        }
+    }
+    if (s_camera_count == MAX_CAMERAS) {
+        return NO_CAMERA;
+    }
+    s_cameras[s_camera_count] = serial;
+    return s_camera_count++;
+}
+
+void LatencyTracer::record(uint32_t camera, Stage stage, uint64_t latency_ns)
+{
+    if (!enabled() || (camera >= MAX_CAMERAS)) {
+        return;
+    }
+    std::atomic<uint32_t> &count = threadHistograms()->counts[camera][stage][bucketIndex(latency_ns)];
+    // only this thread writes the block, a plain load/store is enough
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void LatencyTracer::recordCapture(uint32_t camera, uint64_t ts)
+{
+    if (!enabled() || (camera >= MAX_CAMERAS) || (ts == 0)) {
+        return;
+    }
+    // set once at startup, read without the lock
+    std::chrono::duration<double> now;
+    if (s_system_clock) {
+        now = std::chrono::system_clock::now().time_since_epoch();
+    } else {
+        now = std::chrono::steady_clock::now().time_since_epoch();
+    }
+    double latency = (now.count() - ts / s_ticks_per_second) * 1e9;
+    if ((latency < 0) || (latency > MAX_CAPTURE_NS)) {
+        return;
+    }
+    record(camera, STAGE_CAPTURE, static_cast<uint64_t>(latency));
+}
+
+void LatencyTracer::recordFrame(const FrameBuffer *frame, Stage stage)
+{
+    if (!enabled() || (frame == nullptr)) {
+        return;
+    }
+    const FrameTrace &trace = frame->trace();
+    if (trace.arrival_ns == 0) {
+        return;
+    }
+    record(trace.camera, stage, now() - trace.arrival_ns);
+}
+
+std::string LatencyTracer::report()
+{
+    static const char *names[STAGE_COUNT] = { "capture", "enqueue", "processed", "first_byte", "last_byte" };
+    static const double quantiles[3] = { 0.5, 0.99, 0.999 };
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    std::vector<uint64_t> sum(BUCKET_COUNT);
+    std::string out;
+    for (uint32_t camera = 0; camera < s_camera_count; camera++) {
+        for (int stage = 0; stage < STAGE_COUNT; stage++) {
+            uint64_t total = 0;
+            for (uint32_t b = 0; b < BUCKET_COUNT; b++) {
+                sum[b] = 0;
+                for (size_t t = 0; t < s_blocks.size(); t++) {
+                    sum[b] += s_blocks[t]->counts[camera][stage][b].load(std::memory_order_relaxed);
+                }
+                total += sum[b];
+            }
+            if (total == 0) {
+                continue;
+            }
+
+            double values[3] = { 0, 0, 0 };
+            double max = 0;
+            uint64_t seen = 0;
+            int next = 0;
+            for (uint32_t b = 0; b < BUCKET_COUNT; b++) {
+                if (sum[b] == 0) {
+                    continue;
+                }
+                seen += sum[b];
+                while ((next < 3) && (seen >= quantiles[next] * total)) {
+                    values[next++] = bucketValue(b);
+                }
+                max = bucketValue(b);
+            }
+
+            char line[192];
+            snprintf(line, sizeof(line), "latency [ %s ] %-10s n %8llu  p50 %9.1f us  p99 %9.1f us  p999 %9.1f us  max %9.1f us\n",
+                     s_cameras[camera].c_str(), names[stage], static_cast<unsigned long long>(total),
+                     values[0] / 1000, values[1] / 1000, values[2] / 1000, max / 1000);
+            out += line;
+        }
+    }
+    return out;
+}
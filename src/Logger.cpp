@@ -0,0 +1,444 @@
+/**
+ * @file      Logger.cpp
+ * @brief     Asynchronous LOG() backend, per-thread rings flushed by a background thread
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+
+/* longest line, longer ones are cut off */
+#define LINE_BYTES      4096
+/* LOG() statements evaluated inside another one's arguments */
+#define MAX_NESTING     4
+/* per thread, a line that does not fit any more is dropped */
+#define RING_BYTES      (64 * 1024)
+#define FLUSH_PERIOD_MS 10
+
+std::atomic<int> AsyncLogger::s_level(NOTICE);
+
+namespace
+{
+
+/* level PAD fills the end of the ring when a record does not fit before the wrap */
+const int32_t PAD = -1;
+
+struct Record {
+    uint32_t size;              /* header, text and padding to 8 bytes */
+    int32_t level;
+    int32_t line;
+    uint32_t length;
+    uint64_t time_ns;           /* system clock */
+    const char *file;
+    const char *function;
+};
+
+/* single producer (the owning thread), single consumer (whoever holds the drain lock) */
+struct Ring {
+    char data[RING_BYTES] __attribute__((aligned(8)));
+    std::atomic<uint64_t> head {0};     /* bytes ever written */
+    std::atomic<uint64_t> tail {0};     /* bytes ever consumed */
+    std::atomic<uint64_t> dropped {0};
+    bool owned = false;
+};
+
+struct Entry {
+    uint64_t time_ns;
+    int level;
+    int line;
+    const char *file;
+    const char *function;
+    std::string text;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<Ring *> rings;
+    /* serialises draining and the synchronous fallback */
+    std::mutex drain_mutex;
+    std::vector<Entry> batch;
+    std::string out;
+    std::condition_variable wake;
+    bool urgent = false;
+    bool stopping = false;
+    std::thread thread;
+};
+
+/* lines logged after this are written on the logging thread */
+std::atomic<bool> s_stopped(false);
+
+void run(Registry *r);
+void stop();
+
+/* never freed: threads still log and return their rings while globals are destroyed */
+Registry &registry()
+{
+    static Registry *s_registry = []() {
+        Registry *r = new Registry();
+        r->thread = std::thread(run, r);
+        atexit(stop);
+        return r;
+    }();
+    return *s_registry;
+}
+
+/* the ring stays registered when the thread exits, it is reused once drained */
+struct ThreadSlot {
+    Ring *ring = nullptr;
+    char text[MAX_NESTING][LINE_BYTES];
+    int depth = 0;
+    ~ThreadSlot()
+    {
+        if (ring != nullptr) {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            ring->owned = false;
+            // lines logged from later destructors take a new ring
+            ring = nullptr;
+        }
+    }
+};
+thread_local ThreadSlot t_slot;
+
+Ring *threadRing()
+{
+    if (t_slot.ring != nullptr) {
+        return t_slot.ring;
+    }
+
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (size_t i = 0; i < r.rings.size(); i++) {
+        Ring *ring = r.rings[i];
+        if (!ring->owned && (ring->tail.load(std::memory_order_acquire) == ring->head.load(std::memory_order_relaxed))) {
+            ring->owned = true;
+            t_slot.ring = ring;
+            return ring;
+        }
+    }
+    Ring *ring = new Ring();
+    ring->owned = true;
+    r.rings.push_back(ring);
+    t_slot.ring = ring;
+    return ring;
+}
+
+uint64_t systemNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+const char *levelName(int level)
+{
+    switch (level) {
+    case ERROR:
+        return "ERROR";
+    case WARN:
+        return "WARN";
+    case INFO:
+        return "INFO";
+    default:
+        return "NOTICE";
+    }
+}
+
+/* turns the arguments LogLine stored into text */
+void decode(std::string &text, const char *data, size_t length)
+{
+    text.clear();
+    size_t offset = 0;
+    while (offset < length) {
+        int type = data[offset++];
+        if (type == AsyncLogger::ARG_TEXT) {
+            uint32_t n = 0;
+            if (offset + sizeof(n) > length) {
+                break;
+            }
+            memcpy(&n, data + offset, sizeof(n));
+            offset += sizeof(n);
+            n = std::min<uint32_t>(n, length - offset);
+            text.append(data + offset, n);
+            offset += n;
+            continue;
+        }
+        if (offset + 8 > length) {
+            break;
+        }
+        char buf[32];
+        int n = 0;
+        if (type == AsyncLogger::ARG_INT) {
+            int64_t value;
+            memcpy(&value, data + offset, sizeof(value));
+            n = snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(value));
+        } else if (type == AsyncLogger::ARG_UINT) {
+            uint64_t value;
+            memcpy(&value, data + offset, sizeof(value));
+            n = snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(value));
+        } else if (type == AsyncLogger::ARG_DOUBLE) {
+            double value;
+            memcpy(&value, data + offset, sizeof(value));
+            n = snprintf(buf, sizeof(buf), "%g", value);
+        } else if (type == AsyncLogger::ARG_POINTER) {
+            uint64_t value;
+            memcpy(&value, data + offset, sizeof(value));
+            n = snprintf(buf, sizeof(buf), "%p", reinterpret_cast<void *>(static_cast<uintptr_t>(value)));
+        } else {
+            break;
+        }
+        offset += 8;
+        text.append(buf, (n > 0) ? static_cast<size_t>(n) : 0);
+    }
+}
+
+/* the same prefix getSysTime() and the old synchronous LOG() wrote */
+void format(std::string &out, const Entry &entry)
+{
+    time_t seconds = static_cast<time_t>(entry.time_ns / 1000000000ULL);
+    struct tm local;
+    char prefix[64];
+    localtime_r(&seconds, &local);
+    size_t n = strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &local);
+    out.append(prefix, n);
+    out += "[";
+    out += levelName(entry.level);
+    out += "] [";
+    out += FILEV(entry.file);
+    out += "] [";
+    out += std::to_string(entry.line);
+    out += "] [";
+    out += entry.function;
+    out += "] ";
+    out += entry.text;
+    if (entry.text.empty() || (entry.text.back() != '\n')) {
+        out += '\n';
+    }
+}
+
+void writeOut(const std::string &out)
+{
+    if (!out.empty()) {
+        fwrite(out.data(), 1, out.size(), stdout);
+        fflush(stdout);
+    }
+}
+
+/* writes every committed line in time order, caller holds the drain lock */
+void drain(Registry &r)
+{
+    std::vector<Ring *> rings;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        rings = r.rings;
+    }
+
+    r.batch.clear();
+    for (size_t i = 0; i < rings.size(); i++) {
+        Ring &ring = *rings[i];
+        uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+        const uint64_t head = ring.head.load(std::memory_order_acquire);
+        while (tail != head) {
+            const Record *record = reinterpret_cast<const Record *>(ring.data + (tail % RING_BYTES));
+            if (record->level != PAD) {
+                Entry entry;
+                entry.time_ns = record->time_ns;
+                entry.level = record->level;
+                entry.line = record->line;
+                entry.file = record->file;
+                entry.function = record->function;
+                decode(entry.text, reinterpret_cast<const char *>(record + 1), record->length);
+                r.batch.push_back(std::move(entry));
+            }
+            tail += record->size;
+        }
+        ring.tail.store(tail, std::memory_order_release);
+
+        uint64_t dropped = ring.dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            Entry entry;
+            entry.time_ns = systemNs();
+            entry.level = WARN;
+            entry.line = __LINE__;
+            entry.file = __FILE__;
+            entry.function = __FUNCTION__;
+            entry.text = "log ring full, dropped " + std::to_string(dropped) + " line(s)";
+            r.batch.push_back(std::move(entry));
+        }
+    }
+    if (r.batch.empty()) {
+        return;
+    }
+
+    std::stable_sort(r.batch.begin(), r.batch.end(), [](const Entry & a, const Entry & b) {
+        return a.time_ns < b.time_ns;
+    });
+    r.out.clear();
+    for (size_t i = 0; i < r.batch.size(); i++) {
+        format(r.out, r.batch[i]);
+    }
+    writeOut(r.out);
+}
+
+void run(Registry *registry)
+{
+    pthread_setname_np(pthread_self(), "logger");
+    Registry &r = *registry;
+    std::unique_lock<std::mutex> lock(r.mutex);
+    while (!r.stopping) {
+        r.wake.wait_for(lock, std::chrono::milliseconds(FLUSH_PERIOD_MS), [&r]() {
+            return r.urgent || r.stopping;
+        });
+        r.urgent = false;
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> drain_lock(r.drain_mutex);
+            drain(r);
+        }
+        lock.lock();
+    }
+}
+
+/* at exit: writes what is left, later lines go out synchronously */
+void stop()
+{
+    Registry &r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.stopping = true;
+    }
+    r.wake.notify_one();
+    if (r.thread.joinable()) {
+        r.thread.join();
+    }
+    std::lock_guard<std::mutex> drain_lock(r.drain_mutex);
+    drain(r);
+    s_stopped.store(true, std::memory_order_release);
+}
+
+/* copies one line into the ring, false when it is full */
+bool push(Ring &ring, const Record &header, const char *text)
+{
+    const uint64_t size = (sizeof(Record) + header.length + 7) & ~static_cast<uint64_t>(7);
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    const uint64_t space = RING_BYTES - (head - ring.tail.load(std::memory_order_acquire));
+    const uint64_t contiguous = RING_BYTES - (head % RING_BYTES);
+    const uint64_t pad = (size > contiguous) ? contiguous : 0;
+    if (pad + size > space) {
+        return false;
+    }
+
+    uint64_t position = head;
+    if (pad > 0) {
+        Record *record = reinterpret_cast<Record *>(ring.data + (position % RING_BYTES));
+        record->size = static_cast<uint32_t>(pad);
+        record->level = PAD;
+        position += pad;
+    }
+    Record *record = reinterpret_cast<Record *>(ring.data + (position % RING_BYTES));
+    *record = header;
+    record->size = static_cast<uint32_t>(size);
+    memcpy(record + 1, text, header.length);
+    ring.head.store(position + size, std::memory_order_release);
+    return true;
+}
+
+}
+
+bool AsyncLogger::parseLevel(const std::string &name, LogLevel &level)
+{
+    if (name == "error") {
+        level = ERROR;
+    } else if (name == "warn") {
+        level = WARN;
+    } else if (name == "info") {
+        level = INFO;
+    } else if (name == "notice") {
+        level = NOTICE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void AsyncLogger::flush()
+{
+    if (s_stopped.load(std::memory_order_acquire)) {
+        return;
+    }
+    Registry &r = registry();
+    std::lock_guard<std::mutex> drain_lock(r.drain_mutex);
+    drain(r);
+}
+
+char *AsyncLogger::beginLine(size_t &capacity)
+{
+    ThreadSlot &slot = t_slot;
+    int depth = slot.depth++;
+    if (depth >= MAX_NESTING) {
+        /* shares the innermost buffer, the line is dropped on commit */
+        capacity = 0;
+        return slot.text[MAX_NESTING - 1];
+    }
+    capacity = LINE_BYTES;
+    return slot.text[depth];
+}
+
+void AsyncLogger::commitLine(LogLevel level, const char *file, int line, const char *function, const char *text,
+                             size_t length)
+{
+    ThreadSlot &slot = t_slot;
+    if (slot.depth-- > MAX_NESTING) {
+        return;
+    }
+
+    Record header;
+    header.size = 0;
+    header.level = level;
+    header.line = line;
+    header.length = static_cast<uint32_t>(length);
+    header.time_ns = systemNs();
+    header.file = file;
+    header.function = function;
+
+    if (s_stopped.load(std::memory_order_acquire)) {
+        Entry entry;
+        entry.time_ns = header.time_ns;
+        entry.level = level;
+        entry.line = line;
+        entry.file = file;
+        entry.function = function;
+        decode(entry.text, text, length);
+        std::string out;
+        format(out, entry);
+        Registry &r = registry();
+        std::lock_guard<std::mutex> drain_lock(r.drain_mutex);
+        writeOut(out);
+        return;
+    }
+
+    Ring *ring = threadRing();
+    if (!push(*ring, header, text)) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (level == ERROR) {
+        Registry &r = registry();
+        {
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.urgent = true;
+        }
+        r.wake.notify_one();
+    }
+}
@@ -0,0 +1,348 @@
+/**
+ * @file      Metrics.cpp
+ * @brief     Counters and gauges of every camera, served as Prometheus text
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "Metrics.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "Logger.h"
+
+/* a request line and a few headers, anything longer is not a scraper */
+#define MAX_REQUEST_BYTES   4096
+#define CLIENT_TIMEOUT_MS   1000
+
+namespace
+{
+
+struct Registry {
+    std::mutex mutex;
+    std::map<uint32_t, Metrics::Collector> collectors;
+    uint32_t next_id = 0;
+};
+
+/* collectors are added by global objects, construct the registry on first use */
+Registry &registry()
+{
+    static Registry s_registry;
+    return s_registry;
+}
+
+std::string formatValue(double value)
+{
+    char buff[32];
+    if ((value == std::floor(value)) && (std::fabs(value) < 9007199254740992.0)) {
+        snprintf(buff, sizeof(buff), "%.0f", value);
+    } else {
+        snprintf(buff, sizeof(buff), "%.9g", value);
+    }
+    return buff;
+}
+
+bool sendAll(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+}
+
+void Metrics::Writer::add(const char *name, Type type, const char *help, const std::string &labels, double value)
+{
+    auto it = m_families.find(name);
+    if (it == m_families.end()) {
+        Family family;
+        family.type = type;
+        family.help = help;
+        it = m_families.insert(std::make_pair(std::string(name), family)).first;
+        m_order.push_back(name);
+    }
+    std::string &samples = it->second.samples;
+    samples += name;
+    if (!labels.empty()) {
+        samples += "{" + labels + "}";
+    }
+    samples += " " + formatValue(value) + "\n";
+}
+
+std::string Metrics::Writer::text() const
+{
+    std::string out;
+    for (size_t i = 0; i < m_order.size(); i++) {
+        const Family &family = m_families.find(m_order[i])->second;
+        out += "# HELP " + m_order[i] + " " + family.help + "\n";
+        out += "# TYPE " + m_order[i] + ((family.type == COUNTER) ? " counter\n" : " gauge\n");
+        out += family.samples;
+    }
+    return out;
+}
+
+uint32_t Metrics::addCollector(const Collector &collector)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    uint32_t id = r.next_id++;
+    r.collectors[id] = collector;
+    return id;
+}
+
+void Metrics::removeCollector(uint32_t id)
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.collectors.erase(id);
+}
+
+std::string Metrics::render()
+{
+    Writer out;
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto it = r.collectors.begin(); it != r.collectors.end(); it++) {
+        it->second(out);
+    }
+    return out.text();
+}
+
+std::string Metrics::label(const char *key, const std::string &value)
+{
+    std::string out = std::string(key) + "=\"";
+    for (size_t i = 0; i < value.size(); i++) {
+        if ((value[i] == '\\') || (value[i] == '"')) {
+            out += '\\';
+            out += value[i];
+        } else if (value[i] == '\n') {
+            out += "\\n";
+        } else {
+            out += value[i];
+        }
+    }
+    return out + "\"";
+}
+
+MetricsServer::MetricsServer()
+    : m_socket(-1)
+    , m_event_fd(-1)
+    , m_running(false)
+{
+}
+
+MetricsServer::~MetricsServer()
+{
+    stop();
+}
+
+bool MetricsServer::start(const std::string &address)
+{
+    if (m_running) {
+        return true;
+    }
+
+    static const std::string http = "http://";
+    static const std::string unix_path = "unix://";
+    if (address.compare(0, http.size(), http) == 0) {
+        std::string endpoint = address.substr(http.size());
+        size_t slash = endpoint.find('/');
+        if (slash != std::string::npos) {
+            endpoint = endpoint.substr(0, slash);
+        }
+        size_t colon = endpoint.rfind(':');
+        if ((colon == std::string::npos) || (colon + 1 == endpoint.size())) {
+            LOG(ERROR) << "metrics address " << address << " needs a port" << std::endl;
+            return false;
+        }
+        std::string host = endpoint.substr(0, colon);
+        std::string port = endpoint.substr(colon + 1);
+        if ((host.size() > 1) && (host[0] == '[')) {
+            host = host.substr(1, host.size() - 2);
+        }
+
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        struct addrinfo *result = nullptr;
+        if ((getaddrinfo(host.empty() ? "127.0.0.1" : host.c_str(), port.c_str(), &hints, &result) != 0) ||
+            (result == nullptr)) {
+            LOG(ERROR) << "failed to resolve metrics address " << address << std::endl;
+            return false;
+        }
+        m_socket = socket(result->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int opt = 1;
+        if ((m_socket >= 0) && ((setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) != 0) ||
+                                (bind(m_socket, result->ai_addr, result->ai_addrlen) != 0))) {
+            LOG(ERROR) << "failed to bind metrics address " << address << ": " << strerror(errno) << std::endl;
+            close(m_socket);
+            m_socket = -1;
+        }
+        freeaddrinfo(result);
+    } else if (address.compare(0, unix_path.size(), unix_path) == 0) {
+        std::string path = address.substr(unix_path.size());
+        struct sockaddr_un un;
+        memset(&un, 0, sizeof(un));
+        if (path.empty() || (path.size() >= sizeof(un.sun_path))) {
+            LOG(ERROR) << "invalid metrics socket path " << path << std::endl;
+            return false;
+        }
+        un.sun_family = AF_UNIX;
+        strncpy(un.sun_path, path.c_str(), sizeof(un.sun_path) - 1);
+        // a stale socket of an earlier run would fail the bind
+        unlink(path.c_str());
+        m_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if ((m_socket >= 0) && (bind(m_socket, reinterpret_cast<struct sockaddr *>(&un), sizeof(un)) != 0)) {
+            LOG(ERROR) << "failed to bind metrics socket " << path << ": " << strerror(errno) << std::endl;
+            close(m_socket);
+            m_socket = -1;
+        }
+        m_unix_path = path;
+    } else {
+        LOG(ERROR) << "unknown metrics address " << address << ", use http://host:port or unix:///path" << std::endl;
+        return false;
+    }
+
+    if (m_socket < 0) {
+        m_unix_path.clear();
+        return false;
+    }
+    m_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((listen(m_socket, 8) != 0) || (m_event_fd < 0)) {
+        LOG(ERROR) << "failed to listen for metrics scrapes: " << strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+
+    m_running = true;
+    m_thread = std::thread(&MetricsServer::serverThread, this);
+    return true;
+}
+
+void MetricsServer::stop()
+{
+    if (m_running) {
+        m_running = false;
+        uint64_t value = 1;
+        if (write(m_event_fd, &value, sizeof(value)) < 0) {
+            LOG(WARN) << "failed to wake the metrics server" << std::endl;
+        }
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    if (m_socket >= 0) {
+        close(m_socket);
+        m_socket = -1;
+    }
+    if (m_event_fd >= 0) {
+        close(m_event_fd);
+        m_event_fd = -1;
+    }
+    if (!m_unix_path.empty()) {
+        unlink(m_unix_path.c_str());
+        m_unix_path.clear();
+    }
+}
+
+void MetricsServer::serverThread()
+{
+    pthread_setname_np(pthread_self(), "metrics");
+
+    struct pollfd fds[2];
+    fds[0].fd = m_socket;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_event_fd;
+    fds[1].events = POLLIN;
+    while (m_running) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG(ERROR) << "metrics server poll failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (!m_running || !(fds[0].revents & POLLIN)) {
+            continue;
+        }
+        int client = accept4(m_socket, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+        // a stalled client must not keep the next scrape waiting for long
+        struct timeval timeout;
+        timeout.tv_sec = CLIENT_TIMEOUT_MS / 1000;
+        timeout.tv_usec = (CLIENT_TIMEOUT_MS % 1000) * 1000;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        serve(client);
+        close(client);
+    }
+}
+
+void MetricsServer::serve(int client)
+{
+    std::string request;
+    char buff[512];
+    while ((request.find("\r\n\r\n") == std::string::npos) && (request.find("\n\n") == std::string::npos)) {
+        if (request.size() > MAX_REQUEST_BYTES) {
+            return;
+        }
+        ssize_t got = recv(client, buff, sizeof(buff), 0);
+        if ((got < 0) && (errno == EINTR)) {
+            continue;
+        }
+        if (got <= 0) {
+            return;
+        }
+        request.append(buff, got);
+    }
+
+    // "GET /metrics HTTP/1.1", the query string is ignored
+    std::string status = "200 OK";
+    std::string body;
+    size_t path_begin = request.find(' ');
+    size_t path_end = (path_begin == std::string::npos) ? path_begin : request.find_first_of(" ?\r\n", path_begin + 1);
+    std::string method = request.substr(0, path_begin);
+    std::string path = (path_end == std::string::npos) ? "" : request.substr(path_begin + 1, path_end - path_begin - 1);
+    if ((method != "GET") && (method != "HEAD")) {
+        status = "405 Method Not Allowed";
+    } else if ((path != "/metrics") && (path != "/")) {
+        status = "404 Not Found";
+    } else {
+        body = Metrics::render();
+    }
+
+    char header[256];
+    int length = snprintf(header, sizeof(header),
+                          "HTTP/1.0 %s\r\n"
+                          "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                          "Content-Length: %zu\r\n"
+                          "Connection: close\r\n\r\n", status.c_str(), body.size());
+    if (sendAll(client, header, length) && (method != "HEAD")) {
+        sendAll(client, body.data(), body.size());
+    }
+}
@@ -0,0 +1,224 @@
+/**
+ * @file      OccupancyGrid.cpp
+ * @brief     Voxel occupancy grid in robot coordinates with log-odds and time decay
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "OccupancyGrid.h"
+#include <algorithm>
+#include <cmath>
+
+/* log-odds in Q8: a hit is p = 0.7, a miss p = 0.4, saturated at p = 0.97 */
+#define LOG_ODDS_HIT            218
+#define LOG_ODDS_MISS           102
+#define LOG_ODDS_MAX            896
+/* p = 0.86, between two hits and three: a surface patch in one frame, scattered points in three in a row */
+#define LOG_ODDS_OCCUPIED       480
+/* points of one frame in a voxel that make a surface patch, which counts as three hits */
+#define SURFACE_POINTS          4
+/* voxels held at once, the rest of a frame's new voxels are dropped */
+#define MAX_ACTIVE_VOXELS       65536
+/* longest gap between frames that is decayed, a stalled stream does not wipe the grid at once */
+#define MAX_DECAY_SECONDS       10.0
+/* same validity as the zone detector */
+#define DEPTH_VALID_LOW         101
+#define DEPTH_VALID_HIGH        59999
+
+#define VOXEL_ACTIVE            0x1
+
+static uint32_t cells(uint32_t length, uint32_t voxel)
+{
+    return std::max<uint32_t>(1, (length + voxel - 1) / voxel);
+}
+
+OccupancyGrid::OccupancyGrid(const OccupancyGridConfig &config)
+    : m_config(config), m_decay_carry(0), m_last_seconds(0), m_has_last(false)
+{
+    m_config.voxel = std::max<uint16_t>(m_config.voxel, 10);
+    m_config.max_height = std::max<uint16_t>(m_config.max_height, m_config.min_height + m_config.voxel);
+    m_config.hold = std::max<uint16_t>(m_config.hold, 1);
+    m_config.stride = std::max<uint16_t>(m_config.stride, 1);
+    m_size_x = cells(2u * m_config.range, m_config.voxel);
+    m_size_y = cells(m_config.range, m_config.voxel);
+    m_size_z = cells(m_config.max_height - m_config.min_height, m_config.voxel);
+
+    const size_t total = static_cast<size_t>(m_size_x) * m_size_y * m_size_z;
+    Voxel empty = { 0, 0, 0 };
+    m_voxels.assign(total, empty);
+    m_active.reserve(std::min<size_t>(total, MAX_ACTIVE_VOXELS));
+    m_decay_rate = (LOG_ODDS_MAX - LOG_ODDS_OCCUPIED) * 1000.0f / m_config.hold;
+}
+
+GroundPlane OccupancyGrid::mountPlane(float height, float pitch)
+{
+    const float rad = pitch * 3.14159265f / 180.0f;
+    GroundPlane plane = {};
+    plane.valid = true;
+    // up is -y for a level camera, tilting it down turns up towards -z
+    plane.normal[0] = 0;
+    plane.normal[1] = -std::cos(rad);
+    plane.normal[2] = -std::sin(rad);
+    plane.offset = height;
+    plane.inlier_ratio = 1.0f;
+    return plane;
+}
+
+bool OccupancyGrid::update(const AS_Frame_s &depth, const CameraCalibration &calibration, const GroundPlane &mount,
+                           double seconds, uint16_t nearest[ZONE_COUNT])
+{
+    const uint32_t width = depth.width;
+    const uint32_t height = depth.height;
+    const size_t pixels = static_cast<size_t>(width) * height;
+    if (!mount.valid || (depth.data == nullptr) || (pixels == 0) ||
+        (static_cast<size_t>(depth.size) < pixels * sizeof(uint16_t))) {
+        return false;
+    }
+    const AS_CAM_Parameter_s &p = calibration.parameter;
+    if ((p.fxir <= 0) || (p.fyir <= 0) || !m_projector.prepare(calibration, width, height)) {
+        return false;
+    }
+
+    // robot axes in camera coordinates: up is the floor normal, forward the optical axis flattened onto the floor
+    const float *up = mount.normal;
+    float forward[3] = { -up[2] * up[0], -up[2] * up[1], 1.0f - up[2] * up[2] };
+    const float length = std::sqrt(forward[0] * forward[0] + forward[1] * forward[1] + forward[2] * forward[2]);
+    if (length < 1e-3f) {
+        /* looking straight down, nothing ahead to map */
+        return false;
+    }
+    for (int k = 0; k < 3; k++) {
+        forward[k] /= length;
+    }
+    const float right[3] = { forward[1] * up[2] - forward[2] * up[1], forward[2] * up[0] - forward[0] * up[2],
+                             forward[0] * up[1] - forward[1] * up[0] };
+
+    float decay = m_decay_carry;
+    if (m_has_last) {
+        decay += m_decay_rate * static_cast<float>(std::min(std::max(seconds - m_last_seconds, 0.0), MAX_DECAY_SECONDS));
+    }
+    const int decay_step = static_cast<int>(std::min(decay, 32767.0f));
+    m_decay_carry = decay - decay_step;
+    m_last_seconds = seconds;
+    m_has_last = true;
+
+    // insert: a hit for the first point of a frame in a voxel, two more once its points make a surface
+    const float voxel = m_config.voxel;
+    const float inv_voxel = 1.0f / voxel;
+    const float range = m_config.range;
+    const float min_height = m_config.min_height - mount.offset;
+    const float max_height = m_config.max_height - mount.offset;
+    const uint16_t *data = static_cast<const uint16_t *>(depth.data);
+    const float *ray_x = m_projector.raysX().data();
+    const float *ray_y = m_projector.raysY().data();
+    const uint32_t stride = m_config.stride;
+    for (uint32_t v = stride / 2; v < height; v += stride) {
+        const size_t row = static_cast<size_t>(v) * width;
+        for (uint32_t u = stride / 2; u < width; u += stride) {
+            const uint16_t d = data[row + u];
+            if ((d < DEPTH_VALID_LOW) || (d > DEPTH_VALID_HIGH)) {
+                continue;
+            }
+            const float cx = ray_x[row + u] * d;
+            const float cy = ray_y[row + u] * d;
+            const float cz = d;
+            const float z = up[0] * cx + up[1] * cy + up[2] * cz;
+            const float y = forward[0] * cx + forward[1] * cy + forward[2] * cz;
+            const float x = right[0] * cx + right[1] * cy + right[2] * cz;
+            if ((z < min_height) || (z >= max_height) || (y < 0) || (y >= range) || (x < -range) || (x >= range)) {
+                continue;
+            }
+            const uint32_t gx = std::min(static_cast<uint32_t>((x + range) * inv_voxel), m_size_x - 1);
+            const uint32_t gy = std::min(static_cast<uint32_t>(y * inv_voxel), m_size_y - 1);
+            const uint32_t gz = std::min(static_cast<uint32_t>((z - min_height) * inv_voxel), m_size_z - 1);
+            const uint32_t index = (gy * m_size_x + gx) * m_size_z + gz;
+            Voxel &cell = m_voxels[index];
+            if (cell.points >= SURFACE_POINTS) {
+                continue;
+            }
+            if (!(cell.flags & VOXEL_ACTIVE)) {
+                if (m_active.size() == m_active.capacity()) {
+                    continue;
+                }
+                m_active.push_back(index);
+                cell.flags = VOXEL_ACTIVE;
+            }
+            cell.points++;
+            if ((cell.points == 1) || (cell.points == SURFACE_POINTS)) {
+                const int hit = (cell.points == 1) ? LOG_ODDS_HIT : 2 * LOG_ODDS_HIT;
+                cell.log_odds = static_cast<int16_t>(std::min(cell.log_odds + hit, LOG_ODDS_MAX));
+            }
+        }
+    }
+
+    // IR intrinsics of this resolution, to look up the depth in front of a voxel
+    const float sx = (calibration.width > 0) ? static_cast<float>(width) / calibration.width : 1.0f;
+    const float sy = (calibration.height > 0) ? static_cast<float>(height) / calibration.height : 1.0f;
+    const float fx = p.fxir * sx;
+    const float fy = p.fyir * sy;
+    const float px = p.cxir * sx;
+    const float py = p.cyir * sy;
+
+    /* zone borders as bearings, through the same columns the image split uses */
+    const size_t centre_row = static_cast<size_t>(height / 2) * width;
+    const float left_edge = ray_x[centre_row + static_cast<size_t>(width * 0.3)];
+    const float right_edge = ray_x[centre_row + static_cast<size_t>(width * 0.7)];
+    uint32_t closest[ZONE_COUNT] = { UINT32_MAX, UINT32_MAX, UINT32_MAX };
+
+    // decay, free space and the zone query over the held voxels only
+    const float offset = mount.offset;
+    const float half_voxel = voxel * 0.5f;
+    size_t i = 0;
+    while (i < m_active.size()) {
+        const uint32_t index = m_active[i];
+        Voxel &cell = m_voxels[index];
+        const uint32_t gz = index % m_size_z;
+        const uint32_t gx = (index / m_size_z) % m_size_x;
+        const uint32_t gy = index / m_size_z / m_size_x;
+        const float x = (gx + 0.5f) * voxel - range;
+        const float y = (gy + 0.5f) * voxel;
+        if (cell.points > 0) {
+            cell.points = 0;
+        } else {
+            int log_odds = cell.log_odds - decay_step;
+            const float z = m_config.min_height + (gz + 0.5f) * voxel - offset;
+            const float cz = right[2] * x + forward[2] * y + up[2] * z;
+            if ((log_odds > 0) && (cz > DEPTH_VALID_LOW)) {
+                const float cx = right[0] * x + forward[0] * y + up[0] * z;
+                const float cy = right[1] * x + forward[1] * y + up[1] * z;
+                const float u = fx * cx / cz + px;
+                const float v = fy * cy / cz + py;
+                if ((u >= 0) && (u < width) && (v >= 0) && (v < height)) {
+                    const uint16_t d = data[static_cast<size_t>(v) * width + static_cast<size_t>(u)];
+                    if ((d >= DEPTH_VALID_LOW) && (d <= DEPTH_VALID_HIGH) && (d > cz + half_voxel)) {
+                        /* the ray went through the voxel to something behind it */
+                        log_odds -= LOG_ODDS_MISS;
+                    }
+                }
+            }
+            if (log_odds <= 0) {
+                cell.log_odds = 0;
+                cell.flags = 0;
+                m_active[i] = m_active.back();
+                m_active.pop_back();
+                continue;
+            }
+            cell.log_odds = static_cast<int16_t>(log_odds);
+        }
+        if (cell.log_odds >= LOG_ODDS_OCCUPIED) {
+            const int zone = (x < left_edge * y) ? ZONE_LEFT : ((x < right_edge * y) ? ZONE_CENTER : ZONE_RIGHT);
+            closest[zone] = std::min(closest[zone], std::max<uint32_t>(gy * m_config.voxel, 1));
+        }
+        i++;
+    }
+
+    for (int zone = 0; zone < ZONE_COUNT; zone++) {
+        nearest[zone] = (closest[zone] == UINT32_MAX) ? 0 : static_cast<uint16_t>(std::min<uint32_t>(closest[zone],
+                                                                                                       0xffff));
+    }
+    return true;
+}
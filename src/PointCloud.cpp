@@ -0,0 +1,199 @@
+/**
+ * @file      PointCloud.cpp
+ * @brief     Depth to point cloud projection through a per-pixel ray table
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "PointCloud.h"
+#include <cmath>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CLOUD_X86 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CLOUD_NEON 1
+#endif
+
+/* iterations inverting the lens distortion, converged to well below a pixel */
+#define UNDISTORT_ITERATIONS    20
+/* pooled clouds, a consumer that holds more just misses clouds */
+#define MAX_POOLED_CLOUDS       16
+
+static void projectScalar(const uint16_t *depth, const float *ray_x, const float *ray_y, float *x, float *y, float *z,
+                          size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        float d = depth[i];
+        x[i] = d * ray_x[i];
+        y[i] = d * ray_y[i];
+        z[i] = d;
+    }
+}
+
+#ifdef CLOUD_X86
+static void projectSse2(const uint16_t *depth, const float *ray_x, const float *ray_y, float *x, float *y, float *z,
+                        size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(depth + i));
+        __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(d, zero));
+        __m128 hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(d, zero));
+        _mm_storeu_ps(x + i, _mm_mul_ps(lo, _mm_loadu_ps(ray_x + i)));
+        _mm_storeu_ps(x + i + 4, _mm_mul_ps(hi, _mm_loadu_ps(ray_x + i + 4)));
+        _mm_storeu_ps(y + i, _mm_mul_ps(lo, _mm_loadu_ps(ray_y + i)));
+        _mm_storeu_ps(y + i + 4, _mm_mul_ps(hi, _mm_loadu_ps(ray_y + i + 4)));
+        _mm_storeu_ps(z + i, lo);
+        _mm_storeu_ps(z + i + 4, hi);
+    }
+    projectScalar(depth + i, ray_x + i, ray_y + i, x + i, y + i, z + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void projectAvx2(const uint16_t *depth, const float *ray_x, const float *ray_y, float *x, float *y, float *z,
+                        size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(depth + i));
+        __m256 f = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(d));
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(f, _mm256_loadu_ps(ray_x + i)));
+        _mm256_storeu_ps(y + i, _mm256_mul_ps(f, _mm256_loadu_ps(ray_y + i)));
+        _mm256_storeu_ps(z + i, f);
+    }
+    projectScalar(depth + i, ray_x + i, ray_y + i, x + i, y + i, z + i, n - i);
+}
+#endif
+
+#ifdef CLOUD_NEON
+static void projectNeon(const uint16_t *depth, const float *ray_x, const float *ray_y, float *x, float *y, float *z,
+                        size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t d = vld1q_u16(depth + i);
+        float32x4_t lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(d)));
+        float32x4_t hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(d)));
+        vst1q_f32(x + i, vmulq_f32(lo, vld1q_f32(ray_x + i)));
+        vst1q_f32(x + i + 4, vmulq_f32(hi, vld1q_f32(ray_x + i + 4)));
+        vst1q_f32(y + i, vmulq_f32(lo, vld1q_f32(ray_y + i)));
+        vst1q_f32(y + i + 4, vmulq_f32(hi, vld1q_f32(ray_y + i + 4)));
+        vst1q_f32(z + i, lo);
+        vst1q_f32(z + i + 4, hi);
+    }
+    projectScalar(depth + i, ray_x + i, ray_y + i, x + i, y + i, z + i, n - i);
+}
+#endif
+
+typedef void (*ProjectFunc)(const uint16_t *depth, const float *ray_x, const float *ray_y, float *x, float *y,
+                            float *z, size_t n);
+
+static ProjectFunc selectProject()
+{
+#ifdef CLOUD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return projectAvx2;
+    }
+    return projectSse2;
+#elif defined(CLOUD_NEON)
+    return projectNeon;
+#else
+    return projectScalar;
+#endif
+}
+
+static const ProjectFunc s_project = selectProject();
+
+PointCloudProjector::PointCloudProjector()
+    : m_version(0), m_width(0), m_height(0), m_pool(MAX_POOLED_CLOUDS)
+{
+}
+
+bool PointCloudProjector::prepare(const CameraCalibration &calibration, uint32_t width, uint32_t height)
+{
+    if ((calibration.version == m_version) && (width == m_width) && (height == m_height)) {
+        return true;
+    }
+    const AS_CAM_Parameter_s &p = calibration.parameter;
+    if ((p.fxir <= 0) || (p.fyir <= 0)) {
+        return false;
+    }
+
+    /* the intrinsics belong to the resolution they were fetched for */
+    double sx = (calibration.width > 0) ? static_cast<double>(width) / calibration.width : 1.0;
+    double sy = (calibration.height > 0) ? static_cast<double>(height) / calibration.height : 1.0;
+    const double fx = p.fxir * sx;
+    const double fy = p.fyir * sy;
+    const double cx = p.cxir * sx;
+    const double cy = p.cyir * sy;
+    const bool distorted = (p.K1ir != 0) || (p.K2ir != 0) || (p.K3ir != 0) || (p.P1ir != 0) || (p.P2ir != 0);
+
+    m_ray_x.resize(static_cast<size_t>(width) * height);
+    m_ray_y.resize(static_cast<size_t>(width) * height);
+    for (uint32_t v = 0; v < height; v++) {
+        for (uint32_t u = 0; u < width; u++) {
+            const double xd = (u - cx) / fx;
+            const double yd = (v - cy) / fy;
+            double x = xd;
+            double y = yd;
+            // invert the Brown-Conrady model by fixed point iteration
+            for (int k = 0; distorted && (k < UNDISTORT_ITERATIONS); k++) {
+                double r2 = x * x + y * y;
+                double radial = 1 + r2 * (p.K1ir + r2 * (p.K2ir + r2 * p.K3ir));
+                double dx = 2 * p.P1ir * x * y + p.P2ir * (r2 + 2 * x * x);
+                double dy = p.P1ir * (r2 + 2 * y * y) + 2 * p.P2ir * x * y;
+                x = (xd - dx) / radial;
+                y = (yd - dy) / radial;
+            }
+            size_t i = static_cast<size_t>(v) * width + u;
+            m_ray_x[i] = static_cast<float>(x);
+            m_ray_y[i] = static_cast<float>(y);
+        }
+    }
+    m_version = calibration.version;
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+bool PointCloudProjector::project(const AS_Frame_s &depth, const CameraCalibration &calibration, PointCloud &cloud)
+{
+    const size_t pixels = static_cast<size_t>(depth.width) * depth.height;
+    if ((depth.data == nullptr) || (pixels == 0) || (static_cast<size_t>(depth.size) < pixels * sizeof(uint16_t))) {
+        return false;
+    }
+    if (!prepare(calibration, depth.width, depth.height)) {
+        return false;
+    }
+
+    cloud.timestamp = depth.ts;
+    cloud.frame_id = depth.frameId;
+    cloud.width = depth.width;
+    cloud.height = depth.height;
+    cloud.x.resize(pixels);
+    cloud.y.resize(pixels);
+    cloud.z.resize(pixels);
+    s_project(static_cast<const uint16_t *>(depth.data), m_ray_x.data(), m_ray_y.data(), cloud.x.data(),
+              cloud.y.data(), cloud.z.data(), pixels);
+    return true;
+}
+
+std::shared_ptr<const PointCloud> PointCloudProjector::project(const AS_Frame_s &depth,
+                                                               const CameraCalibration &calibration)
+{
+    std::shared_ptr<PointCloud> cloud = m_pool.acquire();
+    if (!cloud) {
+        return nullptr;
+    }
+    if (!project(depth, calibration, *cloud)) {
+        return nullptr;
+    }
+    return cloud;
+}
@@ -10,16 +10,48 @@
  */
 
 #include "PythonStreamServer.h"
+#include "LatencyTracer.h"
+#include "EventTracer.h"
 #include <iostream>
 #include <cstring>
-#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <netinet/tcp.h>
+#include <linux/errqueue.h>
+
+// Older libc headers (e.g. Ubuntu 18.04 on the Jetson) predate zero copy send
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+static const int MAX_EPOLL_EVENTS = 16;
 
 PythonStreamServer::PythonStreamServer(int port) 
     : m_port(port)
     , m_server_socket(-1)
+    , m_epoll_fd(-1)
+    , m_event_fd(-1)
     , m_running(false)
     , m_connected_clients(0)
+    , m_drop_policy(STREAM_DROP_OLDEST)
+    , m_zero_copy(false)
+    , m_bytes_sent(0)
+    , m_calibration_generation(0)
+    , m_frame_ring(RING_CAPACITY)
+    , m_publish_seq(0)
     , m_frame_counter(0)
 {
 }
@@ -34,7 +66,7 @@ bool PythonStreamServer::start() {
     }
     
     // Create socket
-    m_server_socket = socket(AF_INET, SOCK_STREAM, 0);
+    m_server_socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (m_server_socket < 0) {
         std::cerr << "Failed to create socket" << std::endl;
         return false;
@@ -67,6 +99,31 @@ bool PythonStreamServer::start() {
         return false;
     }
     
+    // One epoll set drives accept, writes and disconnects, the eventfd
+    // wakes it up as soon as a frame is published
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    m_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((m_epoll_fd < 0) || (m_event_fd < 0)) {
+        std::cerr << "Failed to create event loop" << std::endl;
+        if (m_epoll_fd >= 0) {
+            close(m_epoll_fd);
+        }
+        if (m_event_fd >= 0) {
+            close(m_event_fd);
+        }
+        m_epoll_fd = m_event_fd = -1;
+        close(m_server_socket);
+        return false;
+    }
+    
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = m_server_socket;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_server_socket, &ev);
+    ev.data.fd = m_event_fd;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_event_fd, &ev);
+    
     m_running = true;
     m_server_thread = std::thread(&PythonStreamServer::serverThread, this);
     
@@ -81,206 +138,573 @@ void PythonStreamServer::stop() {
     
     m_running = false;
     
-    if (m_server_socket >= 0) {
-        close(m_server_socket);
-        m_server_socket = -1;
+    // Wake the I/O thread so it notices m_running
+    uint64_t one = 1;
+    if (write(m_event_fd, &one, sizeof(one)) < 0) {
+        std::cerr << "Failed to wake stream server" << std::endl;
     }
     
     if (m_server_thread.joinable()) {
         m_server_thread.join();
     }
     
+    for (auto it = m_clients.begin(); it != m_clients.end(); ++it) {
+        shutdown(it->first, SHUT_RDWR);
+        close(it->first);
+    }
+    m_clients.clear();
+    m_connected_clients = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        m_client_counters.clear();
+    }
+    
+    close(m_event_fd);
+    close(m_epoll_fd);
+    m_event_fd = m_epoll_fd = -1;
+    
+    if (m_server_socket >= 0) {
+        close(m_server_socket);
+        m_server_socket = -1;
+    }
+    
     std::cout << "Python Stream Server stopped" << std::endl;
 }
 
-void PythonStreamServer::pushFrame(const AS_SDK_Data_s *pstData) {
-    if (!m_running || !pstData) {
+void PythonStreamServer::pushFrame(const FrameRef &buffer, const std::shared_ptr<const PointCloud> &cloud,
+                                   const std::shared_ptr<const RegisteredFrame> &registered,
+                                   const std::shared_ptr<const GroundMaskFrame> &ground) {
+    TraceScope trace("pushFrame");
+    if (!m_running || !buffer) {
         return;
     }
     
-    StreamFrame frame = convertToStreamFrame(pstData);
+    StreamFrame frame;
+    const AS_SDK_Data_s *data = buffer.data();
+    frame.timestamp = (data->depthImg.size > 0) ? data->depthImg.ts : data->rgbImg.ts;
+    frame.buffer = buffer;
+    frame.cloud = cloud;
+    frame.registered = registered;
+    frame.ground = ground;
+    
+    {
+        std::lock_guard<std::mutex> lock(m_frame_mutex);
+        frame.frame_id = ++m_frame_counter;
+        
+        // Overwrite the oldest slot, clients that still need it are moved on
+        // according to their drop policy when they next read
+        m_frame_ring[m_publish_seq % RING_CAPACITY] = std::move(frame);
+        m_publish_seq++;
+    }
+    
+    uint64_t one = 1;
+    if (write(m_event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        std::cerr << "Failed to signal new frame" << std::endl;
+    }
+}
+
+void PythonStreamServer::getClientStats(std::vector<StreamClientStats> &stats) {
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    stats.resize(m_client_counters.size());
+    for (size_t i = 0; i < m_client_counters.size(); i++) {
+        const ClientCounters &counters = *m_client_counters[i];
+        stats[i].address = counters.address;
+        stats[i].delivered = counters.delivered.load(std::memory_order_relaxed);
+        stats[i].dropped = counters.dropped.load(std::memory_order_relaxed);
+        stats[i].bytes_sent = counters.bytes_sent.load(std::memory_order_relaxed);
+    }
+}
+
+void PythonStreamServer::setCalibration(const std::string &serialno, const CameraCalibration &calibration) {
+    std::shared_ptr<StreamCalibration> message = std::make_shared<StreamCalibration>();
+    memset(message.get(), 0, sizeof(StreamCalibration));
+    strncpy(message->serial, serialno.c_str(), sizeof(message->serial) - 1);
+    message->version = calibration.version;
+    message->width = calibration.width;
+    message->height = calibration.height;
+    message->parameter = calibration.parameter;
+    {
+        std::lock_guard<std::mutex> lock(m_calibration_mutex);
+        m_calibrations[serialno] = message;
+        m_calibration_generation++;
+    }
+    
+    if (m_running) {
+        uint64_t one = 1;
+        if (write(m_event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            std::cerr << "Failed to signal new calibration" << std::endl;
+        }
+    }
+}
+
+void PythonStreamServer::queueCalibrations(ClientConnection &client) {
+    std::lock_guard<std::mutex> lock(m_calibration_mutex);
+    client.calibration_generation = m_calibration_generation;
+    client.calibrations.clear();
+    for (auto it = m_calibrations.begin(); it != m_calibrations.end(); it++) {
+        client.calibrations.push_back(it->second);
+    }
+}
+
+void PythonStreamServer::subscribe(StreamSubscriber &subscriber) {
+    std::lock_guard<std::mutex> lock(m_frame_mutex);
     
+    // New clients start with the next published frame, not the history
+    subscriber.cursor = m_publish_seq;
+    subscriber.policy = m_drop_policy;
+    subscriber.delivered = 0;
+    subscriber.dropped = 0;
+}
+
+bool PythonStreamServer::nextFrame(StreamSubscriber &subscriber, StreamFrame &frame) {
     std::lock_guard<std::mutex> lock(m_frame_mutex);
     
-    // Keep queue size manageable
-    while (m_frame_queue.size() >= MAX_QUEUE_SIZE) {
-        m_frame_queue.pop();
+    if (subscriber.cursor >= m_publish_seq) {
+        return false;
     }
     
-    m_frame_queue.push(frame);
+    uint64_t oldest = (m_publish_seq > RING_CAPACITY) ? m_publish_seq - RING_CAPACITY : 0;
+    uint64_t resume = (subscriber.policy == STREAM_LATEST_ONLY) ? m_publish_seq - 1 : oldest;
+    if (subscriber.cursor < resume) {
+        subscriber.dropped += resume - subscriber.cursor;
+        subscriber.cursor = resume;
+    }
+    
+    frame = m_frame_ring[subscriber.cursor % RING_CAPACITY];
+    subscriber.cursor++;
+    subscriber.delivered++;
+    return true;
 }
 
 void PythonStreamServer::serverThread() {
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+    
     while (m_running) {
+        int count = epoll_wait(m_epoll_fd, events, MAX_EPOLL_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Stream server epoll_wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        
+        bool new_frames = false;
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            uint32_t flags = events[i].events;
+            
+            if (fd == m_server_socket) {
+                acceptClients();
+            } else if (fd == m_event_fd) {
+                uint64_t value;
+                while (read(m_event_fd, &value, sizeof(value)) > 0) {
+                }
+                new_frames = true;
+            } else {
+                auto it = m_clients.find(fd);
+                if (it == m_clients.end()) {
+                    continue;
+                }
+                // Zero copy completions are reported through the error queue
+                if ((flags & EPOLLERR) && it->second.zerocopy && readCompletions(it->second)) {
+                    flags &= ~EPOLLERR;
+                }
+                if (flags & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+                    closeClient(fd);
+                    continue;
+                }
+                if (flags & EPOLLIN) {
+                    // Clients never send anything, a readable socket means EOF
+                    char scratch[256];
+                    ssize_t got = recv(fd, scratch, sizeof(scratch), MSG_DONTWAIT);
+                    if ((got == 0) || ((got < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))) {
+                        closeClient(fd);
+                        continue;
+                    }
+                }
+                if ((flags & EPOLLOUT) && !flushClient(it->second)) {
+                    closeClient(fd);
+                }
+            }
+        }
+        
+        if (!m_running || !new_frames) {
+            continue;
+        }
+        
+        // Clients waiting for the socket to drain pick the frame up on EPOLLOUT
+        for (auto it = m_clients.begin(); it != m_clients.end(); ) {
+            int fd = it->first;
+            ClientConnection &client = it->second;
+            ++it;
+            if (!client.want_write && !flushClient(client)) {
+                closeClient(fd);
+            }
+        }
+    }
+}
+
+void PythonStreamServer::acceptClients() {
+    while (true) {
         struct sockaddr_in client_address;
         socklen_t client_len = sizeof(client_address);
         
-        int client_socket = accept(m_server_socket, (struct sockaddr*)&client_address, &client_len);
-        
+        int client_socket = accept4(m_server_socket, (struct sockaddr*)&client_address, &client_len,
+                                    SOCK_NONBLOCK | SOCK_CLOEXEC);
         if (client_socket < 0) {
-            if (m_running) {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
                 std::cerr << "Failed to accept client connection" << std::endl;
             }
+            return;
+        }
+        
+        // Frames are latency sensitive, don't let Nagle hold back the tail of one
+        int opt = 1;
+        setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = client_socket;
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, client_socket, &ev) < 0) {
+            std::cerr << "Failed to register client connection" << std::endl;
+            close(client_socket);
             continue;
         }
         
-        std::cout << "Python client connected from " << inet_ntoa(client_address.sin_addr) << std::endl;
+        ClientConnection &client = m_clients[client_socket];
+        client.socket = client_socket;
+        client.want_write = false;
+        client.zerocopy = false;
+        client.zerocopy_copied = false;
+        client.zerocopy_next = 0;
+        client.zerocopy_done = 0;
+        client.calibration_generation = 0;
+        if (m_zero_copy) {
+            client.zerocopy = (setsockopt(client_socket, SOL_SOCKET, SO_ZEROCOPY, &opt, sizeof(opt)) == 0);
+            if (!client.zerocopy) {
+                std::cerr << "SO_ZEROCOPY not supported, falling back to copying sends" << std::endl;
+            }
+        }
+        subscribe(client.subscriber);
+        client.counters = std::make_shared<ClientCounters>();
+        client.counters->address = std::string(inet_ntoa(client_address.sin_addr)) + ":" +
+                                   std::to_string(ntohs(client_address.sin_port));
+        client.counters->delivered = 0;
+        client.counters->dropped = 0;
+        client.counters->bytes_sent = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_stats_mutex);
+            m_client_counters.push_back(client.counters);
+        }
+        m_connected_clients++;
         
-        // Handle client in separate thread
-        std::thread client_thread(&PythonStreamServer::clientHandler, this, client_socket);
-        client_thread.detach();
+        std::cout << "Python client connected from " << inet_ntoa(client_address.sin_addr) << std::endl;
     }
 }
 
-void PythonStreamServer::clientHandler(int client_socket) {
-    m_connected_clients++;
+void PythonStreamServer::closeClient(int client_socket) {
+    auto it = m_clients.find(client_socket);
+    if (it == m_clients.end()) {
+        return;
+    }
     
-    try {
-        while (m_running) {
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, client_socket, nullptr);
+    shutdown(client_socket, SHUT_RDWR);
+    close(client_socket);
+    m_connected_clients--;
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        for (size_t i = 0; i < m_client_counters.size(); i++) {
+            if (m_client_counters[i] == it->second.counters) {
+                m_client_counters.erase(m_client_counters.begin() + i);
+                break;
+            }
+        }
+    }
+    std::cout << "Python client disconnected, sent " << it->second.subscriber.delivered
+              << " frames, dropped " << it->second.subscriber.dropped << std::endl;
+    m_clients.erase(it);
+}
+
+void PythonStreamServer::updateWriteInterest(ClientConnection &client, bool want_write) {
+    if (client.want_write == want_write) {
+        return;
+    }
+    
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP | (want_write ? EPOLLOUT : 0);
+    ev.data.fd = client.socket;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, client.socket, &ev);
+    client.want_write = want_write;
+}
+
+bool PythonStreamServer::flushClient(ClientConnection &client) {
+    while (m_running) {
+        if (client.pending.empty() || (client.pending.back().sent == client.pending.back().total)) {
+            if (client.pending.size() >= MAX_ZEROCOPY_INFLIGHT) {
+                // Wait for the kernel to release pages before queueing more
+                updateWriteInterest(client, false);
+                return true;
+            }
+            
+            // A frame's cloud, registration and ground mask follow it, a changed calibration goes out before the next frame
+            if (client.calibration_generation != m_calibration_generation) {
+                queueCalibrations(client);
+            }
+            std::shared_ptr<const StreamCalibration> calibration;
+            std::shared_ptr<const PointCloud> cloud;
+            std::shared_ptr<const RegisteredFrame> registered;
+            std::shared_ptr<const GroundMaskFrame> ground;
             StreamFrame frame;
-            bool has_frame = false;
+            if (client.cloud) {
+                cloud = std::move(client.cloud);
+                client.cloud.reset();
+            } else if (client.registered) {
+                registered = std::move(client.registered);
+                client.registered.reset();
+            } else if (client.ground) {
+                ground = std::move(client.ground);
+                client.ground.reset();
+            } else if (!client.calibrations.empty()) {
+                calibration = client.calibrations.front();
+                client.calibrations.pop_front();
+            } else if (!nextFrame(client.subscriber, frame)) {
+                updateWriteInterest(client, false);
+                return true;
+            }
+            client.counters->delivered.store(client.subscriber.delivered, std::memory_order_relaxed);
+            client.counters->dropped.store(client.subscriber.dropped, std::memory_order_relaxed);
             
-            // Get latest frame
-            {
-                std::lock_guard<std::mutex> lock(m_frame_mutex);
-                if (!m_frame_queue.empty()) {
-                    frame = m_frame_queue.front();
-                    m_frame_queue.pop();
-                    has_frame = true;
-                }
+            client.pending.push_back(PendingFrame());
+            PendingFrame &pending = client.pending.back();
+            pending.frame = std::move(frame);
+            pending.calibration = calibration;
+            pending.cloud = cloud;
+            pending.registered = registered;
+            pending.ground = ground;
+            if (pending.frame.buffer) {
+                client.cloud = pending.frame.cloud;
+                client.registered = pending.frame.registered;
+                client.ground = pending.frame.ground;
             }
+            pending.sent = 0;
+            pending.zerocopy = false;
+            pending.zerocopy_id = 0;
             
-            if (has_frame) {
-                if (!sendFrameToClient(client_socket, frame)) {
-                    break; // Client disconnected
-                }
+            StreamFrameHeader &header = pending.header;
+            if (calibration) {
+                memset(&header, 0, sizeof(header));
+                header.frame_id = STREAM_CALIBRATION_ID;
+                header.depth_size = sizeof(StreamCalibration);
+                pending.total = sizeof(header) + header.depth_size;
+            } else if (cloud) {
+                memset(&header, 0, sizeof(header));
+                header.timestamp = cloud->timestamp;
+                header.frame_id = STREAM_POINTCLOUD_ID;
+                header.depth_width = cloud->width;
+                header.depth_height = cloud->height;
+                header.depth_size = static_cast<uint32_t>(cloud->x.size() * 3 * sizeof(float));
+                pending.total = sizeof(header) + header.depth_size;
+            } else if (registered) {
+                memset(&header, 0, sizeof(header));
+                header.timestamp = registered->timestamp;
+                header.frame_id = STREAM_REGISTERED_ID;
+                header.depth_width = registered->depth_width;
+                header.depth_height = registered->depth_height;
+                header.depth_size = static_cast<uint32_t>(registered->depth.size() * sizeof(uint16_t));
+                header.rgb_width = registered->rgb_width;
+                header.rgb_height = registered->rgb_height;
+                header.rgb_size = static_cast<uint32_t>(registered->rgb.size());
+                pending.total = sizeof(header) + header.depth_size + header.rgb_size;
+            } else if (ground) {
+                memset(&header, 0, sizeof(header));
+                header.timestamp = ground->timestamp;
+                header.frame_id = STREAM_GROUND_ID;
+                header.depth_width = ground->width;
+                header.depth_height = ground->height;
+                header.depth_size = static_cast<uint32_t>(ground->mask.size());
+                pending.total = sizeof(header) + header.depth_size;
             } else {
-                // No frame available, wait a bit
-                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                // Protocol: header first, then depth, rgb and ir planes
+                const AS_SDK_Data_s *data = pending.frame.buffer.data();
+                header.timestamp = pending.frame.timestamp;
+                header.frame_id = pending.frame.frame_id;
+                header.depth_width = data->depthImg.width;
+                header.depth_height = data->depthImg.height;
+                header.depth_size = data->depthImg.size;
+                header.rgb_width = data->rgbImg.width;
+                header.rgb_height = data->rgbImg.height;
+                header.rgb_size = data->rgbImg.size;
+                header.ir_width = data->irImg.width;
+                header.ir_height = data->irImg.height;
+                header.ir_size = data->irImg.size;
+                pending.total = sizeof(header) + header.depth_size + header.rgb_size + header.ir_size;
             }
         }
-    } catch (const std::exception& e) {
-        std::cerr << "Exception in client handler: " << e.what() << std::endl;
-    } catch (...) {
-        std::cerr << "Unknown exception in client handler" << std::endl;
-    }
-    
-    // Clean shutdown
-    shutdown(client_socket, SHUT_RDWR);
-    close(client_socket);
-    m_connected_clients--;
-    std::cout << "Python client disconnected" << std::endl;
-}
-
-bool PythonStreamServer::sendFrameToClient(int client_socket, const StreamFrame& frame) {
-    try {
-        // Protocol: Send header first, then data
-        struct FrameHeader {
-            uint64_t timestamp;
-            uint32_t frame_id;
-            uint32_t depth_width;
-            uint32_t depth_height;
-            uint32_t depth_size;
-            uint32_t rgb_width;
-            uint32_t rgb_height;
-            uint32_t rgb_size;
-            uint32_t ir_width;
-            uint32_t ir_height;
-            uint32_t ir_size;
-        } header;
-        
-        header.timestamp = frame.timestamp;
-        header.frame_id = frame.frame_id;
-        header.depth_width = frame.depth_width;
-        header.depth_height = frame.depth_height;
-        header.depth_size = frame.depth_size;
-        header.rgb_width = frame.rgb_width;
-        header.rgb_height = frame.rgb_height;
-        header.rgb_size = frame.rgb_size;
-        header.ir_width = frame.ir_width;
-        header.ir_height = frame.ir_height;
-        header.ir_size = frame.ir_size;
         
-        // Send header with error checking
-        ssize_t sent = send(client_socket, &header, sizeof(header), MSG_NOSIGNAL);
-        if (sent != sizeof(header)) {
+        int ret = sendFrameToClient(client);
+        if (ret < 0) {
             return false;
         }
+        if (ret == 0) {
+            // Socket buffer is full, resume once it drains
+            updateWriteInterest(client, true);
+            return true;
+        }
         
-        // Send depth data
-        if (frame.depth_size > 0 && frame.depth_data) {
-            sent = send(client_socket, frame.depth_data.get(), frame.depth_size, MSG_NOSIGNAL);
-            if (sent != (ssize_t)frame.depth_size) {
-                return false;
+        releaseCompleted(client);
+    }
+    return true;
+}
+
+/* returns 1 when the frame is fully written, 0 when the socket would block, -1 on error */
+int PythonStreamServer::sendFrameToClient(ClientConnection &client) {
+    TraceScope trace("sendFrameToClient");
+    PendingFrame &pending = client.pending.back();
+    const void *segments[4] = { &pending.header, pending.calibration.get(), nullptr, nullptr };
+    size_t sizes[4] = { sizeof(pending.header), pending.header.depth_size, 0, 0 };
+    if (pending.cloud) {
+        const PointCloud &cloud = *pending.cloud;
+        segments[1] = cloud.x.data();
+        segments[2] = cloud.y.data();
+        segments[3] = cloud.z.data();
+        sizes[1] = sizes[2] = sizes[3] = cloud.x.size() * sizeof(float);
+    } else if (pending.registered) {
+        segments[1] = pending.registered->depth.data();
+        segments[2] = pending.registered->rgb.data();
+        sizes[2] = pending.header.rgb_size;
+    } else if (pending.ground) {
+        segments[1] = pending.ground->mask.data();
+    } else if (!pending.calibration) {
+        const AS_SDK_Data_s *data = pending.frame.buffer.data();
+        segments[1] = data->depthImg.data;
+        segments[2] = data->rgbImg.data;
+        segments[3] = data->irImg.data;
+        sizes[2] = pending.header.rgb_size;
+        sizes[3] = pending.header.ir_size;
+    }
+    
+    while (pending.sent < pending.total) {
+        // One iovec over whatever is left of the header and planes
+        struct iovec iov[4];
+        int iovcnt = 0;
+        size_t skip = pending.sent;
+        for (int i = 0; i < 4; i++) {
+            if (skip >= sizes[i]) {
+                skip -= sizes[i];
+                continue;
             }
+            iov[iovcnt].iov_base = const_cast<uint8_t *>(static_cast<const uint8_t *>(segments[i])) + skip;
+            iov[iovcnt].iov_len = sizes[i] - skip;
+            iovcnt++;
+            skip = 0;
         }
         
-        // Send RGB data
-        if (frame.rgb_size > 0 && frame.rgb_data) {
-            sent = send(client_socket, frame.rgb_data.get(), frame.rgb_size, MSG_NOSIGNAL);
-            if (sent != (ssize_t)frame.rgb_size) {
-                return false;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
+        
+        bool zerocopy = client.zerocopy && !client.zerocopy_copied;
+        int flags = MSG_NOSIGNAL | MSG_DONTWAIT | (zerocopy ? MSG_ZEROCOPY : 0);
+        ssize_t sent = sendmsg(client.socket, &msg, flags);
+        if (sent < 0) {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                return 0;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno == ENOBUFS) && zerocopy) {
+                // Out of locked memory for pinned pages, copy instead
+                client.zerocopy_copied = true;
+                continue;
             }
+            return -1;
         }
         
-        // Send IR data
-        if (frame.ir_size > 0 && frame.ir_data) {
-            sent = send(client_socket, frame.ir_data.get(), frame.ir_size, MSG_NOSIGNAL);
-            if (sent != (ssize_t)frame.ir_size) {
-                return false;
-            }
+        if (zerocopy) {
+            pending.zerocopy = true;
+            pending.zerocopy_id = client.zerocopy_next++;
+        }
+        if (pending.sent == 0) {
+            LatencyTracer::recordFrame(pending.frame.buffer.get(), LatencyTracer::STAGE_FIRST_BYTE);
         }
+        pending.sent += sent;
+        client.counters->bytes_sent.store(client.counters->bytes_sent.load(std::memory_order_relaxed) + sent,
+                                          std::memory_order_relaxed);
+        m_bytes_sent.fetch_add(sent, std::memory_order_relaxed);
+    }
+    LatencyTracer::recordFrame(pending.frame.buffer.get(), LatencyTracer::STAGE_LAST_BYTE);
+    
+    return 1;
+}
+
+/* drains zero copy notifications, returns false if the error queue held a real error */
+bool PythonStreamServer::readCompletions(ClientConnection &client) {
+    bool ok = true;
+    while (true) {
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
         
-        return true;
+        if (recvmsg(client.socket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            break;
+        }
         
-    } catch (const std::exception& e) {
-        std::cerr << "Exception sending frame: " << e.what() << std::endl;
-        return false;
-    } catch (...) {
-        std::cerr << "Unknown exception sending frame" << std::endl;
-        return false;
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!(((cm->cmsg_level == SOL_IP) && (cm->cmsg_type == IP_RECVERR)) ||
+                  ((cm->cmsg_level == SOL_IPV6) && (cm->cmsg_type == IPV6_RECVERR)))) {
+                continue;
+            }
+            struct sock_extended_err err;
+            memcpy(&err, CMSG_DATA(cm), sizeof(err));
+            if ((err.ee_origin != SO_EE_ORIGIN_ZEROCOPY) || (err.ee_errno != 0)) {
+                ok = false;
+                continue;
+            }
+            
+            // ids ee_info..ee_data are done, TCP reports them in order
+            if (static_cast<int32_t>(err.ee_data + 1 - client.zerocopy_done) > 0) {
+                client.zerocopy_done = err.ee_data + 1;
+            }
+            
+            if (err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                // The kernel copied anyway (e.g. loopback), pinning only costs here
+                client.zerocopy_copied = true;
+            }
+        }
+    }
+    
+    releaseCompleted(client);
+    
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if ((getsockopt(client.socket, SOL_SOCKET, SO_ERROR, &error, &len) == 0) && (error != 0)) {
+        ok = false;
     }
+    
+    if (ok && !client.want_write && !flushClient(client)) {
+        ok = false;
+    }
+    return ok;
 }
 
-StreamFrame PythonStreamServer::convertToStreamFrame(const AS_SDK_Data_s *pstData) {
-    StreamFrame frame;
-    
-    auto now = std::chrono::high_resolution_clock::now();
-    frame.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
-    frame.frame_id = ++m_frame_counter;
-    
-    // Copy depth data
-    if (pstData->depthImg.size > 0) {
-        frame.depth_width = pstData->depthImg.width;
-        frame.depth_height = pstData->depthImg.height;
-        frame.depth_size = pstData->depthImg.size;
-        frame.depth_data = std::shared_ptr<uint8_t>(new uint8_t[frame.depth_size], std::default_delete<uint8_t[]>());
-        memcpy(frame.depth_data.get(), pstData->depthImg.data, frame.depth_size);
-    } else {
-        frame.depth_width = frame.depth_height = frame.depth_size = 0;
-    }
-    
-    // Copy RGB data
-    if (pstData->rgbImg.size > 0) {
-        frame.rgb_width = pstData->rgbImg.width;
-        frame.rgb_height = pstData->rgbImg.height;
-        frame.rgb_size = pstData->rgbImg.size;
-        frame.rgb_data = std::shared_ptr<uint8_t>(new uint8_t[frame.rgb_size], std::default_delete<uint8_t[]>());
-        memcpy(frame.rgb_data.get(), pstData->rgbImg.data, frame.rgb_size);
-    } else {
-        frame.rgb_width = frame.rgb_height = frame.rgb_size = 0;
-    }
-    
-    // Copy IR data
-    if (pstData->irImg.size > 0) {
-        frame.ir_width = pstData->irImg.width;
-        frame.ir_height = pstData->irImg.height;
-        frame.ir_size = pstData->irImg.size;
-        frame.ir_data = std::shared_ptr<uint8_t>(new uint8_t[frame.ir_size], std::default_delete<uint8_t[]>());
-        memcpy(frame.ir_data.get(), pstData->irImg.data, frame.ir_size);
-    } else {
-        frame.ir_width = frame.ir_height = frame.ir_size = 0;
-    }
-    
-    return frame;
+/* drops written frames whose pages the kernel no longer references */
+void PythonStreamServer::releaseCompleted(ClientConnection &client) {
+    while (!client.pending.empty()) {
+        PendingFrame &front = client.pending.front();
+        if (front.sent < front.total) {
+            break;
+        }
+        if (front.zerocopy && (static_cast<int32_t>(client.zerocopy_done - front.zerocopy_id) <= 0)) {
+            break;
+        }
+        client.pending.pop_front();
+    }
 }
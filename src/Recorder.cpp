@@ -0,0 +1,444 @@
+/**
+ * @file      Recorder.cpp
+ * @brief     Continuous session recorder writing chunked, indexed .asrec files
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "Recorder.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "Logger.h"
+#include "EventTracer.h"
+#include "FramePool.h"
+
+/* space reserved ahead of the writes, large extents keep the file contiguous */
+#define RECORDER_PREALLOC (256ULL << 20)
+
+static size_t alignUp(size_t value, size_t align)
+{
+    return (value + align - 1) / align * align;
+}
+
+Recorder::Recorder(size_t chunk_bytes, size_t chunk_count, uint64_t file_bytes)
+    : m_chunk_bytes(alignUp(chunk_bytes > (2 * SESSION_BLOCK) ? chunk_bytes : (2 * SESSION_BLOCK), SESSION_BLOCK))
+    , m_file_bytes(file_bytes)
+    , m_chunks(chunk_count > 1 ? chunk_count : 2)
+    , m_fill(0)
+    , m_flush(0)
+    , m_header_block(nullptr)
+    , m_recording(false)
+    , m_stopping(false)
+    , m_camera_type(0)
+    , m_file_index(0)
+    , m_fd(-1)
+    , m_direct(false)
+    , m_written(0)
+    , m_allocated(0)
+    , m_frames(0)
+    , m_dropped(0)
+    , m_bytes(0)
+{
+    for (size_t i = 0; i < m_chunks.size(); i++) {
+        void *buffer = nullptr;
+        // O_DIRECT needs block aligned memory as well as aligned offsets and sizes
+        if (posix_memalign(&buffer, SESSION_BLOCK, m_chunk_bytes) != 0) {
+            buffer = nullptr;
+        }
+        m_chunks[i].buffer = static_cast<uint8_t *>(buffer);
+        m_chunks[i].used = 0;
+        memset(&m_chunks[i].calibration, 0, sizeof(CameraCalibration));
+        m_chunks[i].full = false;
+    }
+    memset(&m_calibration, 0, sizeof(m_calibration));
+    void *block = nullptr;
+    if (posix_memalign(&block, SESSION_BLOCK, SESSION_BLOCK) == 0) {
+        m_header_block = static_cast<uint8_t *>(block);
+    }
+}
+
+Recorder::~Recorder()
+{
+    stop();
+    for (size_t i = 0; i < m_chunks.size(); i++) {
+        free(m_chunks[i].buffer);
+    }
+    free(m_header_block);
+}
+
+bool Recorder::start(const std::string &directory, const std::string &serial, uint32_t camera_type)
+{
+    std::lock_guard<std::mutex> record_lock(m_record_mutex);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_recording) {
+        return true;
+    }
+    for (size_t i = 0; i < m_chunks.size(); i++) {
+        if ((m_chunks[i].buffer == nullptr) || (m_header_block == nullptr)) {
+            LOG(ERROR) << "recorder: no memory for " << m_chunks.size() << " chunks of " << m_chunk_bytes
+                       << " bytes" << std::endl;
+            return false;
+        }
+        m_chunks[i].used = 0;
+        m_chunks[i].index.clear();
+        m_chunks[i].full = false;
+    }
+
+    char stamp[32] = {0};
+    time_t now = time(nullptr);
+    struct tm tm_now;
+    localtime_r(&now, &tm_now);
+    strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &tm_now);
+
+    m_directory = directory.empty() ? std::string(".") : directory;
+    m_serial = serial;
+    m_session = serial + "_" + stamp;
+    m_camera_type = camera_type;
+    m_file_index = 0;
+    // filled in with the first frame's calibration before any frame is written
+    memset(&m_calibration, 0, sizeof(m_calibration));
+    if (!openFile()) {
+        return false;
+    }
+
+    m_fill = 0;
+    m_flush = 0;
+    m_stopping = false;
+    m_frames = 0;
+    m_dropped = 0;
+    m_bytes = 0;
+    m_thread = std::thread(&Recorder::writerThread, this);
+    m_recording = true;
+    LOG(INFO) << "recording " << m_directory << "/" << m_session << " (" << (m_direct ? "direct" : "buffered")
+              << " io)" << std::endl;
+    return true;
+}
+
+void Recorder::stop()
+{
+    std::lock_guard<std::mutex> record_lock(m_record_mutex);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_recording) {
+            return;
+        }
+        m_recording = false;
+        // the partial chunk goes out with the rest
+        Chunk &chunk = m_chunks[m_fill];
+        if (!chunk.full && !chunk.index.empty()) {
+            sealChunk(chunk);
+        }
+        m_stopping = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    closeFile();
+    logStats();
+}
+
+bool Recorder::record(const AS_SDK_Data_s *data, uint64_t sequence, const CameraCalibration *calibration)
+{
+    std::lock_guard<std::mutex> record_lock(m_record_mutex);
+    if (!m_recording || (data == nullptr)) {
+        return false;
+    }
+
+    const AS_Frame_s *planes[AS_FRAME_TYPE_BUTT];
+    uint32_t types[AS_FRAME_TYPE_BUTT];
+    uint32_t plane_count = 0;
+    for (int type = 0; type < AS_FRAME_TYPE_BUTT; type++) {
+        const AS_Frame_s &frame = framePlane(*data, type);
+        if ((frame.size == 0) || (frame.data == nullptr)) {
+            continue;
+        }
+        planes[plane_count] = &frame;
+        types[plane_count++] = type;
+    }
+    if (plane_count == 0) {
+        return false;
+    }
+    size_t header_bytes = alignUp(sizeof(SessionFrameHeader) + plane_count * sizeof(SessionPlane), SESSION_ALIGN);
+    size_t bytes = header_bytes;
+    for (uint32_t i = 0; i < plane_count; i++) {
+        bytes += alignUp(planes[i]->size, SESSION_ALIGN);
+    }
+    size_t chunk_header = alignUp(sizeof(SessionChunkHeader), SESSION_ALIGN);
+    if (chunk_header + bytes + sizeof(SessionIndexEntry) > m_chunk_bytes) {
+        m_dropped++;
+        LOG(ERROR) << "recorder: frame of " << bytes << " bytes does not fit a " << m_chunk_bytes
+                   << " byte chunk" << std::endl;
+        return false;
+    }
+
+    uint32_t calibration_version = (calibration != nullptr) ? calibration->version : 0;
+    Chunk *chunk = nullptr;
+    bool sealed = false;
+    bool full = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        chunk = &m_chunks[m_fill];
+        // a new calibration goes into a new chunk, and so into a new file
+        if (!chunk->full && !chunk->index.empty() &&
+            ((chunk->used + bytes + (chunk->index.size() + 1) * sizeof(SessionIndexEntry) > m_chunk_bytes) ||
+             (chunk->calibration.version != calibration_version))) {
+            sealChunk(*chunk);
+            m_fill = (m_fill + 1) % m_chunks.size();
+            chunk = &m_chunks[m_fill];
+            sealed = true;
+        }
+        full = chunk->full;
+    }
+    if (sealed) {
+        m_cond.notify_one();
+    }
+    if (full) {
+        // every buffer is still queued for the disk
+        m_dropped++;
+        return false;
+    }
+    if (chunk->index.empty()) {
+        chunk->used = chunk_header;
+        if (calibration != nullptr) {
+            chunk->calibration = *calibration;
+        } else {
+            memset(&chunk->calibration, 0, sizeof(CameraCalibration));
+        }
+    }
+
+    uint8_t *record = chunk->buffer + chunk->used;
+    memset(record, 0, header_bytes);
+    SessionFrameHeader *header = reinterpret_cast<SessionFrameHeader *>(record);
+    header->magic = SESSION_FRAME_MAGIC;
+    header->bytes = static_cast<uint32_t>(bytes);
+    header->sequence = sequence;
+    header->timestamp = planes[0]->ts;
+    header->plane_count = plane_count;
+
+    SessionPlane *plane = reinterpret_cast<SessionPlane *>(record + sizeof(SessionFrameHeader));
+    size_t offset = header_bytes;
+    for (uint32_t i = 0; i < plane_count; i++) {
+        const AS_Frame_s &frame = *planes[i];
+        plane[i].type = types[i];
+        plane[i].width = frame.width;
+        plane[i].height = frame.height;
+        plane[i].size = frame.size;
+        plane[i].frame_id = frame.frameId;
+        plane[i].data_offset = static_cast<uint32_t>(offset);
+        plane[i].timestamp = frame.ts;
+        memcpy(record + offset, frame.data, frame.size);
+        offset += alignUp(frame.size, SESSION_ALIGN);
+    }
+
+    SessionIndexEntry entry;
+    entry.offset = chunk->used;
+    entry.timestamp = header->timestamp;
+    entry.sequence = sequence;
+    entry.bytes = header->bytes;
+    entry.reserved = 0;
+    chunk->index.push_back(entry);
+    chunk->used += bytes;
+    m_frames++;
+    return true;
+}
+
+void Recorder::sealChunk(Chunk &chunk)
+{
+    size_t index_bytes = chunk.index.size() * sizeof(SessionIndexEntry);
+    memcpy(chunk.buffer + chunk.used, chunk.index.data(), index_bytes);
+    size_t index_end = chunk.used + index_bytes;
+    size_t chunk_bytes = alignUp(index_end, SESSION_BLOCK);
+    memset(chunk.buffer + index_end, 0, chunk_bytes - index_end);
+
+    SessionChunkHeader *header = reinterpret_cast<SessionChunkHeader *>(chunk.buffer);
+    memset(header, 0, sizeof(SessionChunkHeader));
+    header->magic = SESSION_CHUNK_MAGIC;
+    header->frame_count = static_cast<uint32_t>(chunk.index.size());
+    header->chunk_bytes = chunk_bytes;
+    header->index_offset = chunk.used;
+    header->first_timestamp = chunk.index.front().timestamp;
+    header->last_timestamp = chunk.index.back().timestamp;
+    header->first_sequence = chunk.index.front().sequence;
+
+    chunk.used = chunk_bytes;
+    chunk.full = true;
+}
+
+void Recorder::writerThread()
+{
+    pthread_setname_np(pthread_self(), "recorder");
+
+    for (;;) {
+        Chunk *chunk = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() {
+                return m_chunks[m_flush].full || m_stopping;
+            });
+            if (!m_chunks[m_flush].full) {
+                break;
+            }
+            chunk = &m_chunks[m_flush];
+        }
+
+        if ((m_fd >= 0) && (chunk->calibration.version != m_calibration.version)) {
+            m_calibration = chunk->calibration;
+            if (m_written > SESSION_BLOCK) {
+                closeFile();
+                m_file_index++;
+                openFile();
+            } else {
+                writeHeader();
+            }
+        }
+
+        // reserve ahead in large steps instead of growing the file write by write
+        if ((m_fd >= 0) && (m_written + chunk->used > m_allocated)) {
+            uint64_t length = RECORDER_PREALLOC > chunk->used ? RECORDER_PREALLOC : chunk->used;
+            if (fallocate(m_fd, FALLOC_FL_KEEP_SIZE, m_written, length) == 0) {
+                m_allocated = m_written + length;
+            } else {
+                // not supported here, the writes allocate as they go
+                m_allocated = UINT64_MAX;
+            }
+        }
+        EventTracer::begin("writeChunk");
+        bool written = (m_fd >= 0) && writeAll(chunk->buffer, chunk->used);
+        EventTracer::end("writeChunk");
+        if (written) {
+            m_bytes += chunk->used;
+        } else {
+            m_dropped += chunk->index.size();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            chunk->used = 0;
+            chunk->index.clear();
+            chunk->full = false;
+            m_flush = (m_flush + 1) % m_chunks.size();
+        }
+
+        if ((m_file_bytes > 0) && (m_written >= m_file_bytes)) {
+            closeFile();
+            m_file_index++;
+            openFile();
+        }
+    }
+}
+
+bool Recorder::openFile()
+{
+    char suffix[16] = {0};
+    snprintf(suffix, sizeof(suffix), "_%03u.asrec", m_file_index);
+    std::string path = m_directory + "/" + m_session + suffix;
+
+    m_direct = true;
+    m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_DIRECT, 0644);
+    if ((m_fd < 0) && (errno == EINVAL)) {
+        // tmpfs and some FUSE mounts refuse O_DIRECT
+        m_direct = false;
+        m_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (m_fd < 0) {
+        LOG(ERROR) << "recorder: open " << path << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    m_written = SESSION_BLOCK;
+    m_allocated = 0;
+    // the header goes in with pwrite, the chunks follow it with write
+    if (!writeHeader() || (lseek(m_fd, SESSION_BLOCK, SEEK_SET) != SESSION_BLOCK)) {
+        closeFile();
+        return false;
+    }
+    return true;
+}
+
+/* at the start of the file, also to put a calibration into a file without frames */
+bool Recorder::writeHeader()
+{
+    // the header block is padded so the chunks stay aligned
+    uint8_t *block = m_header_block;
+    memset(block, 0, SESSION_BLOCK);
+    SessionFileHeader *header = reinterpret_cast<SessionFileHeader *>(block);
+    header->magic = SESSION_FILE_MAGIC;
+    header->version = SESSION_VERSION;
+    header->header_bytes = SESSION_BLOCK;
+    header->camera_type = m_camera_type;
+    header->created_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::system_clock::now().time_since_epoch()).count();
+    header->file_index = m_file_index;
+    strncpy(header->serial, m_serial.c_str(), sizeof(header->serial) - 1);
+    header->calibration = m_calibration;
+    if (pwrite(m_fd, block, SESSION_BLOCK, 0) != SESSION_BLOCK) {
+        LOG(ERROR) << "recorder: header write failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Recorder::closeFile()
+{
+    if (m_fd < 0) {
+        return;
+    }
+    // give back what was reserved past the last chunk
+    if (ftruncate(m_fd, m_written) != 0) {
+        LOG(WARN) << "recorder: truncate failed: " << strerror(errno) << std::endl;
+    }
+    if (fdatasync(m_fd) != 0) {
+        LOG(ERROR) << "recorder: sync failed: " << strerror(errno) << std::endl;
+    }
+    close(m_fd);
+    m_fd = -1;
+}
+
+bool Recorder::writeAll(const uint8_t *data, size_t size)
+{
+    size_t written = 0;
+    while (written < size) {
+        ssize_t ret = write(m_fd, data + written, size - written);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG(ERROR) << "recorder: write failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        written += ret;
+    }
+    m_written += written;
+    if (!m_direct) {
+        // keep hours of recording from crowding out the page cache
+        fdatasync(m_fd);
+        posix_fadvise(m_fd, m_written - written, written, POSIX_FADV_DONTNEED);
+    }
+    return true;
+}
+
+size_t Recorder::backlog()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t count = 0;
+    for (size_t i = 0; i < m_chunks.size(); i++) {
+        count += m_chunks[i].full ? 1 : 0;
+    }
+    return count;
+}
+
+void Recorder::logStats()
+{
+    LOG(INFO) << "recorder [ " << m_serial << " ]: frames " << m_frames << ", dropped " << m_dropped
+              << ", bytes " << m_bytes << std::endl;
+}
@@ -0,0 +1,433 @@
+/**
+ * @file      SessionReplay.cpp
+ * @brief     Replays recorded sessions through ICameraStatus from a memory mapping
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "SessionReplay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "FramePool.h"
+#include "Logger.h"
+#include "VirtualCamera.h"
+
+/* a frame record that stays inside its chunk, with planes inside the record */
+static bool validRecord(const uint8_t *chunk, uint64_t chunk_bytes, const SessionIndexEntry &entry)
+{
+    if ((entry.offset % SESSION_ALIGN != 0) || (entry.offset + sizeof(SessionFrameHeader) > chunk_bytes) ||
+        (entry.offset + entry.bytes > chunk_bytes)) {
+        return false;
+    }
+    const SessionFrameHeader *record = reinterpret_cast<const SessionFrameHeader *>(chunk + entry.offset);
+    if ((record->magic != SESSION_FRAME_MAGIC) || (record->bytes != entry.bytes) ||
+        (record->plane_count > AS_FRAME_TYPE_BUTT) ||
+        (sizeof(SessionFrameHeader) + record->plane_count * sizeof(SessionPlane) > record->bytes)) {
+        return false;
+    }
+    const SessionPlane *planes = reinterpret_cast<const SessionPlane *>(record + 1);
+    for (uint32_t i = 0; i < record->plane_count; i++) {
+        if ((planes[i].type >= AS_FRAME_TYPE_BUTT) ||
+            (static_cast<uint64_t>(planes[i].data_offset) + planes[i].size > record->bytes)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SessionReplay::SessionReplay(ICameraStatus *cameraStatus, const std::vector<std::string> &paths,
+                             double ticks_per_second)
+    : m_camera_status(cameraStatus)
+    , m_paths(paths)
+    , m_ticks_per_second(ticks_per_second > 0 ? ticks_per_second : 1000.0)
+    , m_pacing(PACE_REALTIME)
+    , m_speed(1.0)
+    , m_loop(false)
+    , m_running(false)
+    , m_steps(0)
+    , m_attached(false)
+    , m_finished(false)
+{
+}
+
+SessionReplay::~SessionReplay()
+{
+    stop();
+    for (size_t i = 0; i < m_cameras.size(); i++) {
+        for (size_t j = 0; j < m_cameras[i]->files.size(); j++) {
+            munmap(m_cameras[i]->files[j].base, m_cameras[i]->files[j].size);
+        }
+    }
+}
+
+SessionReplay::Pacing SessionReplay::parsePacing(const std::string &name)
+{
+    if (name == "fast") {
+        return PACE_FAST;
+    } else if (name == "step") {
+        return PACE_STEP;
+    }
+    return PACE_REALTIME;
+}
+
+void SessionReplay::setPacing(Pacing pacing, double speed)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pacing = pacing;
+    m_speed = speed > 0 ? speed : 1.0;
+}
+
+void SessionReplay::setLoop(bool loop)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_loop = loop;
+}
+
+int SessionReplay::start()
+{
+    if (m_running || !m_cameras.empty()) {
+        return 0;
+    }
+
+    std::vector<std::string> files;
+    for (size_t i = 0; i < m_paths.size(); i++) {
+        struct stat st;
+        if (stat(m_paths[i].c_str(), &st) != 0) {
+            LOG(ERROR) << "replay: " << m_paths[i] << ": " << strerror(errno) << std::endl;
+            continue;
+        }
+        if (!S_ISDIR(st.st_mode)) {
+            files.push_back(m_paths[i]);
+            continue;
+        }
+        DIR *dir = opendir(m_paths[i].c_str());
+        if (dir == nullptr) {
+            continue;
+        }
+        struct dirent *entry = nullptr;
+        while ((entry = readdir(dir)) != nullptr) {
+            std::string name = entry->d_name;
+            if ((name.size() > 6) && (name.compare(name.size() - 6, 6, ".asrec") == 0)) {
+                files.push_back(m_paths[i] + "/" + name);
+            }
+        }
+        closedir(dir);
+    }
+    for (size_t i = 0; i < files.size(); i++) {
+        mapFile(files[i]);
+    }
+
+    for (size_t i = 0; i < m_cameras.size(); i++) {
+        ReplayCamera &camera = *m_cameras[i];
+        std::sort(camera.files.begin(), camera.files.end(), [](const Mapping & a, const Mapping & b) {
+            return (a.created_us < b.created_us) ||
+                   ((a.created_us == b.created_us) && (a.file_index < b.file_index));
+        });
+        indexCamera(camera);
+    }
+    std::stable_sort(m_frames.begin(), m_frames.end(), [](const ReplayFrame & a, const ReplayFrame & b) {
+        return a.time < b.time;
+    });
+    if (m_frames.empty()) {
+        LOG(ERROR) << "replay: no frames found" << std::endl;
+        return -1;
+    }
+
+    for (size_t i = 0; i < m_cameras.size(); i++) {
+        ReplayCamera &camera = *m_cameras[i];
+        VirtualCameraInfo info;
+        info.serial = camera.serial;
+        info.type = static_cast<AS_SDK_CAM_MODEL_E>(camera.camera_type);
+        info.location = "replay";
+        for (int type = 0; type < AS_FRAME_TYPE_BUTT; type++) {
+            info.plane_capacity[type] = camera.plane_capacity[type];
+        }
+        // the camera publishes one calibration, the first one recorded
+        memset(&info.calibration, 0, sizeof(info.calibration));
+        for (size_t j = 0; j < camera.files.size(); j++) {
+            const CameraCalibration &calibration = camera.files[j].calibration;
+            if (calibration.version == 0) {
+                continue;
+            }
+            if (info.calibration.version == 0) {
+                info.calibration = calibration;
+            } else if ((calibration.width != info.calibration.width) ||
+                       (calibration.height != info.calibration.height) ||
+                       (memcmp(&calibration.parameter, &info.calibration.parameter, sizeof(calibration.parameter)) != 0)) {
+                LOG(WARN) << "replay: " << camera.files[j].path << " was recorded with another calibration, replaying "
+                          << camera.serial << " with the first one" << std::endl;
+            }
+        }
+        if (info.calibration.version == 0) {
+            LOG(WARN) << "replay: no calibration recorded for " << camera.serial
+                      << ", ground removal, occupancy grid, point clouds, registration and undistortion stay off"
+                      << std::endl;
+        }
+        registerVirtualCamera(&camera, info);
+    }
+
+    LOG(INFO) << "replay: " << m_frames.size() << " frames of " << m_cameras.size() << " camera(s)" << std::endl;
+    m_running = true;
+    m_finished = false;
+    m_thread = std::thread(&SessionReplay::replayThread, this);
+    return 0;
+}
+
+void SessionReplay::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    detachCameras();
+}
+
+void SessionReplay::step()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_steps++;
+    }
+    m_cond.notify_all();
+}
+
+bool SessionReplay::mapFile(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG(ERROR) << "replay: open " << path << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size < SESSION_BLOCK)) {
+        LOG(ERROR) << "replay: " << path << " is not a session file" << std::endl;
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    void *base = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        LOG(ERROR) << "replay: mmap " << path << " failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    const SessionFileHeader *header = static_cast<const SessionFileHeader *>(base);
+    // version 1 files are the same without the calibration
+    size_t header_bytes = (header->version == 1) ? offsetof(SessionFileHeader, calibration) : sizeof(SessionFileHeader);
+    if ((header->magic != SESSION_FILE_MAGIC) || (header->version < 1) || (header->version > SESSION_VERSION) ||
+        (header->header_bytes < header_bytes) || (header->header_bytes > size)) {
+        LOG(ERROR) << "replay: " << path << " is not a session file" << std::endl;
+        munmap(base, size);
+        return false;
+    }
+    // frames are read once, front to back
+    madvise(base, size, MADV_SEQUENTIAL);
+
+    std::string serial(header->serial, strnlen(header->serial, sizeof(header->serial)));
+    ReplayCamera *camera = nullptr;
+    for (size_t i = 0; i < m_cameras.size(); i++) {
+        if (m_cameras[i]->serial == serial) {
+            camera = m_cameras[i].get();
+        }
+    }
+    if (camera == nullptr) {
+        std::unique_ptr<ReplayCamera> created(new ReplayCamera());
+        created->serial = serial;
+        created->camera_type = header->camera_type;
+        for (int type = 0; type < AS_FRAME_TYPE_BUTT; type++) {
+            created->plane_capacity[type] = 0;
+        }
+        created->frames = 0;
+        camera = created.get();
+        m_cameras.push_back(std::move(created));
+    }
+
+    Mapping mapping;
+    mapping.path = path;
+    mapping.base = static_cast<uint8_t *>(base);
+    mapping.size = size;
+    mapping.created_us = header->created_us;
+    mapping.file_index = header->file_index;
+    if (header->version >= 2) {
+        mapping.calibration = header->calibration;
+    } else {
+        memset(&mapping.calibration, 0, sizeof(mapping.calibration));
+    }
+    camera->files.push_back(mapping);
+    return true;
+}
+
+void SessionReplay::indexCamera(ReplayCamera &camera)
+{
+    // the replay clock follows the capture timestamps, but a jump (a new
+    // session, a reset camera clock) only advances it by one frame
+    const uint64_t max_gap = static_cast<uint64_t>(m_ticks_per_second);
+    uint64_t time = 0;
+    uint64_t last = 0;
+    uint64_t gap = 0;
+    bool first = true;
+
+    for (size_t i = 0; i < camera.files.size(); i++) {
+        const Mapping &file = camera.files[i];
+        size_t offset = reinterpret_cast<const SessionFileHeader *>(file.base)->header_bytes;
+        while (offset + sizeof(SessionChunkHeader) <= file.size) {
+            const uint8_t *chunk = file.base + offset;
+            const SessionChunkHeader *header = reinterpret_cast<const SessionChunkHeader *>(chunk);
+            if ((header->magic != SESSION_CHUNK_MAGIC) || (header->chunk_bytes < sizeof(SessionChunkHeader)) ||
+                (header->chunk_bytes > file.size - offset) ||
+                (header->index_offset + header->frame_count * sizeof(SessionIndexEntry) > header->chunk_bytes)) {
+                LOG(WARN) << "replay: " << file.path << " is truncated at " << offset << std::endl;
+                break;
+            }
+            const SessionIndexEntry *index = reinterpret_cast<const SessionIndexEntry *>(chunk + header->index_offset);
+            for (uint32_t k = 0; k < header->frame_count; k++) {
+                if (!validRecord(chunk, header->chunk_bytes, index[k])) {
+                    LOG(WARN) << "replay: " << file.path << " has a bad frame at " << offset + index[k].offset
+                              << std::endl;
+                    continue;
+                }
+                const SessionFrameHeader *record = reinterpret_cast<const SessionFrameHeader *>(chunk + index[k].offset);
+                const SessionPlane *planes = reinterpret_cast<const SessionPlane *>(record + 1);
+                for (uint32_t p = 0; p < record->plane_count; p++) {
+                    camera.plane_capacity[planes[p].type] = std::max<size_t>(camera.plane_capacity[planes[p].type],
+                                                                              planes[p].size);
+                }
+
+                if (!first) {
+                    uint64_t delta = record->timestamp - last;
+                    if ((record->timestamp < last) || (delta > max_gap)) {
+                        delta = gap;
+                    } else {
+                        gap = delta;
+                    }
+                    time += delta;
+                }
+                first = false;
+                last = record->timestamp;
+
+                ReplayFrame frame;
+                frame.camera = &camera;
+                frame.record = record;
+                frame.time = time;
+                m_frames.push_back(frame);
+            }
+            offset += header->chunk_bytes;
+        }
+    }
+}
+
+void SessionReplay::fire(const ReplayFrame &frame)
+{
+    ReplayCamera &camera = *frame.camera;
+    for (int type = 0; type < AS_FRAME_TYPE_BUTT; type++) {
+        memset(&framePlane(camera.data, type), 0, sizeof(AS_Frame_s));
+    }
+    const uint8_t *record = reinterpret_cast<const uint8_t *>(frame.record);
+    const SessionPlane *planes = reinterpret_cast<const SessionPlane *>(frame.record + 1);
+    for (uint32_t i = 0; i < frame.record->plane_count; i++) {
+        AS_Frame_s &plane = framePlane(camera.data, planes[i].type);
+        plane.type = static_cast<AS_FRAME_Type_e>(planes[i].type);
+        plane.width = planes[i].width;
+        plane.height = planes[i].height;
+        // points into the read only mapping, nothing is copied here
+        plane.data = const_cast<uint8_t *>(record + planes[i].data_offset);
+        plane.size = planes[i].size;
+        plane.bufferSize = planes[i].size;
+        plane.frameId = planes[i].frame_id;
+        plane.ts = planes[i].timestamp;
+    }
+    m_camera_status->onCameraNewFrame(&camera, &camera.data);
+    camera.frames++;
+}
+
+void SessionReplay::replayThread()
+{
+    pthread_setname_np(pthread_self(), "replay");
+
+    for (size_t i = 0; i < m_cameras.size(); i++) {
+        ReplayCamera &camera = *m_cameras[i];
+        m_camera_status->onCameraAttached(&camera, static_cast<AS_SDK_CAM_MODEL_E>(camera.camera_type));
+        m_camera_status->onCameraOpen(&camera);
+        m_camera_status->onCameraStart(&camera);
+    }
+    m_attached = true;
+
+    bool running = true;
+    bool again = true;
+    while (again) {
+        auto begin = std::chrono::steady_clock::now();
+        size_t fired = 0;
+        for (size_t i = 0; i < m_frames.size(); i++) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_pacing == PACE_REALTIME) {
+                std::chrono::duration<double> offset(m_frames[i].time / m_ticks_per_second / m_speed);
+                auto due = begin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset);
+                m_cond.wait_until(lock, due, [this]() {
+                    return !m_running;
+                });
+            } else if (m_pacing == PACE_STEP) {
+                m_cond.wait(lock, [this]() {
+                    return (m_steps > 0) || !m_running;
+                });
+                if (m_steps > 0) {
+                    m_steps--;
+                }
+            }
+            if (!m_running) {
+                break;
+            }
+            lock.unlock();
+            fire(m_frames[i]);
+            fired++;
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        double recorded = (fired > 0) ? m_frames[fired - 1].time / m_ticks_per_second : 0.0;
+        LOG(INFO) << "replay: " << fired << " frames in " << elapsed.count() << " s (" << fired / elapsed.count()
+                  << " fps, " << recorded / elapsed.count() << "x real time)" << std::endl;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        running = m_running;
+        again = running && m_loop;
+    }
+
+    // stop() only writes m_running under the lock, use what the loop read
+    if (running) {
+        LOG(INFO) << "replay finished" << std::endl;
+        detachCameras();
+    }
+    m_finished = true;
+}
+
+void SessionReplay::detachCameras()
+{
+    if (!m_attached) {
+        return;
+    }
+    m_attached = false;
+    for (size_t i = 0; i < m_cameras.size(); i++) {
+        ReplayCamera &camera = *m_cameras[i];
+        m_camera_status->onCameraStop(&camera);
+        m_camera_status->onCameraClose(&camera);
+        m_camera_status->onCameraDetached(&camera);
+        unregisterVirtualCamera(&camera);
+    }
+}
@@ -0,0 +1,279 @@
+/**
+ * @file      SyntheticCamera.cpp
+ * @brief     Procedural virtual cameras feeding ICameraStatus without a device
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "SyntheticCamera.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <pthread.h>
+#include "Logger.h"
+#include "VirtualCamera.h"
+
+#define WALL_MM             4000
+#define FLOOR_NEAR_MM       2000
+/* a level camera this high above a flat floor */
+#define CAMERA_HEIGHT_MM    900
+#define OBSTACLE_WIDTH_MM   500
+#define OBSTACLE_HEIGHT_MM  800
+#define APPROACH_SPEED_MM_S 1000.0
+#define APPROACH_NEAR_MM    300
+#define CROSSING_MM         1500
+#define CROSSING_PERIOD_S   4.0
+/* every SPECKLE_STRIDE'th depth pixel reads 0, moving each frame */
+#define SPECKLE_STRIDE      61
+/* focal length in pixels per image width, roughly a 64 degree horizontal field of view */
+#define FOCAL               0.8
+
+SyntheticCameras::SyntheticCameras(ICameraStatus *cameraStatus, const Config &config)
+    : m_camera_status(cameraStatus)
+    , m_config(config)
+    , m_running(false)
+    , m_attached(false)
+{
+    m_config.cameras = std::max<size_t>(m_config.cameras, 1);
+    m_config.width = std::max<uint32_t>(m_config.width, 16);
+    m_config.height = std::max<uint32_t>(m_config.height, 16);
+    if (m_config.ticks_per_second <= 0) {
+        m_config.ticks_per_second = 1000.0;
+    }
+}
+
+SyntheticCameras::~SyntheticCameras()
+{
+    stop();
+}
+
+SyntheticCameras::Scene SyntheticCameras::parseScene(const std::string &name)
+{
+    if (name == "crossing") {
+        return SCENE_CROSSING;
+    } else if (name == "static") {
+        return SCENE_STATIC;
+    }
+    return SCENE_APPROACH;
+}
+
+int SyntheticCameras::start()
+{
+    if (m_attached) {
+        return 0;
+    }
+
+    const size_t pixels = static_cast<size_t>(m_config.width) * m_config.height;
+    for (size_t i = 0; i < m_config.cameras; i++) {
+        std::unique_ptr<Device> device(new Device());
+        device->index = i;
+        device->serial = "SYNTH" + std::to_string(i);
+        device->frames = 0;
+        renderBackground(*device);
+        device->depth.resize(pixels);
+        device->rgb.resize(pixels * 3);
+        device->ir.resize(pixels);
+
+        VirtualCameraInfo info;
+        info.serial = device->serial;
+        info.type = AS_SDK_CAM_MODEL_UNKNOWN;
+        info.location = "synthetic";
+        for (int type = 0; type < AS_FRAME_TYPE_BUTT; type++) {
+            info.plane_capacity[type] = 0;
+        }
+        info.plane_capacity[AS_FRAME_TYPE_DEPTH] = pixels * sizeof(uint16_t);
+        info.plane_capacity[AS_FRAME_TYPE_RGB] = pixels * 3;
+        info.plane_capacity[AS_FRAME_TYPE_IR] = pixels;
+        // the pinhole renderFrame() projects with, RGB registered to depth
+        memset(&info.calibration, 0, sizeof(info.calibration));
+        info.calibration.version = 1;
+        info.calibration.width = m_config.width;
+        info.calibration.height = m_config.height;
+        AS_CAM_Parameter_s &parameter = info.calibration.parameter;
+        parameter.fxir = parameter.fyir = parameter.fxrgb = parameter.fyrgb = FOCAL * m_config.width;
+        parameter.cxir = parameter.cxrgb = m_config.width / 2.0f;
+        parameter.cyir = parameter.cyrgb = m_config.height / 2.0f;
+        parameter.R00 = parameter.R11 = parameter.R22 = 1.0f;
+        registerVirtualCamera(device.get(), info);
+        m_devices.push_back(std::move(device));
+    }
+
+    // hotplug order of a live start, one camera after the other
+    for (size_t i = 0; i < m_devices.size(); i++) {
+        AS_CAM_PTR handle = m_devices[i].get();
+        m_camera_status->onCameraAttached(handle, AS_SDK_CAM_MODEL_UNKNOWN);
+        m_camera_status->onCameraOpen(handle);
+        m_camera_status->onCameraStart(handle);
+    }
+    m_attached = true;
+
+    LOG(INFO) << "synthetic: " << m_devices.size() << " camera(s) " << m_config.width << "x" << m_config.height
+              << " at " << m_config.fps << " fps" << std::endl;
+    m_running = true;
+    for (size_t i = 0; i < m_devices.size(); i++) {
+        m_devices[i]->thread = std::thread(&SyntheticCameras::streamThread, this, m_devices[i].get());
+    }
+    return 0;
+}
+
+void SyntheticCameras::stop()
+{
+    m_running = false;
+    for (size_t i = 0; i < m_devices.size(); i++) {
+        if (m_devices[i]->thread.joinable()) {
+            m_devices[i]->thread.join();
+        }
+    }
+    if (!m_attached) {
+        return;
+    }
+    m_attached = false;
+    for (size_t i = 0; i < m_devices.size(); i++) {
+        AS_CAM_PTR handle = m_devices[i].get();
+        LOG(INFO) << "synthetic [ " << m_devices[i]->serial << " ]: " << m_devices[i]->frames << " frames" << std::endl;
+        m_camera_status->onCameraStop(handle);
+        m_camera_status->onCameraClose(handle);
+        m_camera_status->onCameraDetached(handle);
+        unregisterVirtualCamera(handle);
+    }
+    m_devices.clear();
+}
+
+void SyntheticCameras::renderBackground(Device &device)
+{
+    const uint32_t width = m_config.width;
+    const uint32_t height = m_config.height;
+    const double focal = FOCAL * width;
+    device.background_depth.resize(static_cast<size_t>(width) * height);
+    device.background_rgb.resize(static_cast<size_t>(width) * height * 3);
+    device.background_ir.resize(static_cast<size_t>(width) * height);
+
+    for (uint32_t y = 0; y < height; y++) {
+        // back wall down to where the floor in front of it comes into view, through the same pinhole
+        uint16_t depth = WALL_MM;
+        double below = y - height / 2.0;
+        if ((below > 0) && (focal * CAMERA_HEIGHT_MM / below < WALL_MM)) {
+            depth = static_cast<uint16_t>(focal * CAMERA_HEIGHT_MM / below);
+        }
+        uint8_t shade = static_cast<uint8_t>(60 + 120 * y / height);
+        for (uint32_t x = 0; x < width; x++) {
+            size_t i = static_cast<size_t>(y) * width + x;
+            device.background_depth[i] = depth;
+            device.background_rgb[i * 3 + 0] = shade;
+            device.background_rgb[i * 3 + 1] = static_cast<uint8_t>(shade / 2 + 40 * x / width);
+            device.background_rgb[i * 3 + 2] = static_cast<uint8_t>(shade / 3);
+            device.background_ir[i] = static_cast<uint8_t>(std::min(255, 255 * FLOOR_NEAR_MM / 2 / depth));
+        }
+    }
+}
+
+void SyntheticCameras::renderFrame(Device &device, double seconds)
+{
+    const uint32_t width = m_config.width;
+    const uint32_t height = m_config.height;
+    const size_t pixels = static_cast<size_t>(width) * height;
+    memcpy(device.depth.data(), device.background_depth.data(), pixels * sizeof(uint16_t));
+    memcpy(device.rgb.data(), device.background_rgb.data(), pixels * 3);
+    memcpy(device.ir.data(), device.background_ir.data(), pixels);
+
+    const double focal = FOCAL * width;
+    double distance = 0;
+    double center = 0;
+    switch (m_config.scene) {
+    case SCENE_APPROACH: {
+        double travel = WALL_MM - APPROACH_NEAR_MM;
+        distance = WALL_MM - std::fmod(seconds * APPROACH_SPEED_MM_S, travel);
+        // camera 0 in the center zone, then left, then right
+        static const double centers[3] = { 0.5, 0.15, 0.85 };
+        center = centers[device.index % 3] * width;
+        break;
+    }
+    case SCENE_CROSSING: {
+        double half = focal * OBSTACLE_WIDTH_MM / CROSSING_MM / 2;
+        double phase = std::fmod(seconds / CROSSING_PERIOD_S + device.index * 0.25, 1.0);
+        distance = CROSSING_MM;
+        center = -half + phase * (width + 2 * half);
+        break;
+    }
+    default:
+        break;
+    }
+
+    if (distance > 0) {
+        double half_width = focal * OBSTACLE_WIDTH_MM / distance / 2;
+        double half_height = focal * OBSTACLE_HEIGHT_MM / distance / 2;
+        int x0 = std::max(0, static_cast<int>(center - half_width));
+        int x1 = std::min(static_cast<int>(width), static_cast<int>(center + half_width));
+        int y0 = std::max(0, static_cast<int>(height / 2 - half_height));
+        int y1 = std::min(static_cast<int>(height), static_cast<int>(height / 2 + half_height));
+        uint16_t depth = static_cast<uint16_t>(distance);
+        uint8_t ir = static_cast<uint8_t>(std::min(255.0, 255.0 * FLOOR_NEAR_MM / 2 / distance));
+        for (int y = y0; (y < y1) && (x0 < x1); y++) {
+            size_t row = static_cast<size_t>(y) * width;
+            std::fill(device.depth.begin() + row + x0, device.depth.begin() + row + x1, depth);
+            std::fill(device.ir.begin() + row + x0, device.ir.begin() + row + x1, ir);
+            for (int x = x0; x < x1; x++) {
+                uint8_t *bgr = &device.rgb[(row + x) * 3];
+                bgr[0] = 30;
+                bgr[1] = 30;
+                bgr[2] = 200;
+            }
+        }
+    }
+
+    // dropouts like a real sensor's, the consumers must skip zero depth
+    for (size_t i = device.frames % SPECKLE_STRIDE; i < pixels; i += SPECKLE_STRIDE) {
+        device.depth[i] = 0;
+    }
+}
+
+void SyntheticCameras::streamThread(Device *device)
+{
+    char name[16] = {0};
+    snprintf(name, sizeof(name), "synth%zu", device->index);
+    pthread_setname_np(pthread_self(), name);
+
+    // scene and timestamps run on frame time, the motion stays consistent for TTC at any rate
+    const double interval = 1.0 / ((m_config.fps > 0) ? m_config.fps : 30.0);
+    auto start = std::chrono::steady_clock::now();
+    // stamped like the SDK's default wall clock timestamps
+    std::chrono::duration<double> epoch = std::chrono::system_clock::now().time_since_epoch();
+
+    AS_Frame_s *planes[3] = { &device->data.depthImg, &device->data.rgbImg, &device->data.irImg };
+    memset(&device->data.pointCloud, 0, sizeof(AS_Frame_s));
+    memset(&device->data.yuyvImg, 0, sizeof(AS_Frame_s));
+    memset(&device->data.peakImg, 0, sizeof(AS_Frame_s));
+    memset(&device->data.mjpegImg, 0, sizeof(AS_Frame_s));
+    const AS_FRAME_Type_e types[3] = { AS_FRAME_TYPE_DEPTH, AS_FRAME_TYPE_RGB, AS_FRAME_TYPE_IR };
+    void *buffers[3] = { device->depth.data(), device->rgb.data(), device->ir.data() };
+    const size_t sizes[3] = { device->depth.size() * sizeof(uint16_t), device->rgb.size(), device->ir.size() };
+
+    while (m_running) {
+        double seconds = device->frames * interval;
+        if (m_config.fps > 0) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                              std::chrono::duration<double>(seconds)));
+        }
+        renderFrame(*device, seconds);
+
+        uint64_t ts = static_cast<uint64_t>((epoch.count() + seconds) * m_config.ticks_per_second);
+        for (int i = 0; i < 3; i++) {
+            AS_Frame_s &plane = *planes[i];
+            plane.type = types[i];
+            plane.width = m_config.width;
+            plane.height = m_config.height;
+            plane.data = buffers[i];
+            plane.size = static_cast<unsigned int>(sizes[i]);
+            plane.bufferSize = plane.size;
+            plane.frameId = static_cast<unsigned int>(device->frames);
+            plane.ts = ts;
+        }
+        m_camera_status->onCameraNewFrame(device, &device->data);
+        device->frames++;
+    }
+}
@@ -0,0 +1,134 @@
+/**
+ * @file      TtcEstimator.cpp
+ * @brief     Per-zone time to collision from the nearest obstacle distance
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "TtcEstimator.h"
+#include <cmath>
+
+/* a longer gap than this (or time going backwards) starts the zone over */
+static const double TTC_MAX_GAP = 1.0;
+
+TtcEstimator::TtcEstimator(double ticks_per_second, float warn_ttc, float min_velocity)
+    : m_ticks_per_second(ticks_per_second)
+    , m_warn_ttc(warn_ttc)
+    , m_min_velocity(min_velocity)
+{
+    reset();
+}
+
+void TtcEstimator::reset()
+{
+    for (int i = 0; i < ZONE_COUNT; i++) {
+        ZoneHistory &zone = m_zones[i];
+        zone.head = 0;
+        zone.count = 0;
+        zone.origin = 0;
+        zone.sum_t = 0.0;
+        zone.sum_d = 0.0;
+        zone.sum_tt = 0.0;
+        zone.sum_td = 0.0;
+    }
+}
+
+void TtcEstimator::rebuild(ZoneHistory &zone, uint64_t origin)
+{
+    double shift = static_cast<double>(origin - zone.origin) / m_ticks_per_second;
+    zone.origin = origin;
+    zone.sum_t = 0.0;
+    zone.sum_d = 0.0;
+    zone.sum_tt = 0.0;
+    zone.sum_td = 0.0;
+    for (int i = 0; i < zone.count; i++) {
+        Sample &s = zone.ring[i];
+        s.t -= shift;
+        zone.sum_t += s.t;
+        zone.sum_d += s.d;
+        zone.sum_tt += s.t * s.t;
+        zone.sum_td += s.t * s.d;
+    }
+}
+
+void TtcEstimator::push(ZoneHistory &zone, uint64_t timestamp, double distance)
+{
+    if (zone.count > 0) {
+        const Sample &last = zone.ring[(zone.head + HISTORY_SIZE - 1) % HISTORY_SIZE];
+        double t = (timestamp >= zone.origin) ? static_cast<double>(timestamp - zone.origin) / m_ticks_per_second : -1.0;
+        if ((t <= last.t) || (t - last.t > TTC_MAX_GAP)) {
+            zone.head = 0;
+            zone.count = 0;
+        }
+    }
+    if (zone.count == 0) {
+        zone.origin = timestamp;
+        zone.sum_t = 0.0;
+        zone.sum_d = 0.0;
+        zone.sum_tt = 0.0;
+        zone.sum_td = 0.0;
+    }
+
+    Sample &slot = zone.ring[zone.head];
+    if (zone.count == HISTORY_SIZE) {
+        zone.sum_t -= slot.t;
+        zone.sum_d -= slot.d;
+        zone.sum_tt -= slot.t * slot.t;
+        zone.sum_td -= slot.t * slot.d;
+    } else {
+        zone.count++;
+    }
+    slot.t = static_cast<double>(timestamp - zone.origin) / m_ticks_per_second;
+    slot.d = distance;
+    zone.sum_t += slot.t;
+    zone.sum_d += slot.d;
+    zone.sum_tt += slot.t * slot.t;
+    zone.sum_td += slot.t * slot.d;
+
+    zone.head = (zone.head + 1) % HISTORY_SIZE;
+    if ((zone.head == 0) && (zone.count == HISTORY_SIZE)) {
+        // once per lap: move the origin to the oldest sample, sums from scratch
+        uint64_t oldest = zone.origin + static_cast<uint64_t>(std::llround(zone.ring[0].t * m_ticks_per_second));
+        rebuild(zone, oldest);
+    }
+}
+
+void TtcEstimator::update(ZoneDangerResult &result)
+{
+    for (int i = 0; i < ZONE_COUNT; i++) {
+        ZoneResult &out = result.zones[i];
+        ZoneHistory &zone = m_zones[i];
+        out.velocity = 0.0f;
+        out.ttc = -1.0f;
+        out.ttc_warn = false;
+
+        /* a zone without valid depth has no distance, do not feed it a zero */
+        if (out.min_depth == 0) {
+            continue;
+        }
+        double distance = out.min_depth / 1000.0;
+        push(zone, result.timestamp, distance);
+        if (zone.count < 3) {
+            continue;
+        }
+
+        double n = zone.count;
+        double denom = n * zone.sum_tt - zone.sum_t * zone.sum_t;
+        if (denom <= 1e-12) {
+            continue;
+        }
+        double velocity = (n * zone.sum_td - zone.sum_t * zone.sum_d) / denom;
+        out.velocity = static_cast<float>(velocity);
+        if (velocity < -m_min_velocity) {
+            double ttc = distance / -velocity;
+            if ((ttc >= 0.1) && (ttc <= 60.0)) {
+                out.ttc = static_cast<float>(ttc);
+                out.ttc_warn = out.ttc <= m_warn_ttc;
+            }
+        }
+    }
+}
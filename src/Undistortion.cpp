@@ -0,0 +1,338 @@
+/**
+ * @file      Undistortion.cpp
+ * @brief     Lens distortion removed from depth, IR and RGB planes through remap tables
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "Undistortion.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define REMAP_X86 1
+#endif
+
+/*
+ * Bilinear in 8 bit fractions: rows first, then columns, rounded once at the
+ * end. The largest intermediate, 255 << 16, fits an int32.
+ */
+static inline int bilinear(int a, int b, int c, int d, int fx, int fy)
+{
+    int top = (a << 8) + (b - a) * fx;
+    int bottom = (c << 8) + (d - c) * fx;
+    return ((top << 8) + (bottom - top) * fy + (1 << 15)) >> 16;
+}
+
+static void remapDepth(const uint16_t *src, size_t stride, const int32_t *index, const uint16_t *weight,
+                       uint16_t *dst, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (index[i] < 0) {
+            dst[i] = 0;
+            continue;
+        }
+        // the nearest of the four pixels around the source position
+        size_t nearest = index[i] + ((weight[i] & 0x80) ? 1 : 0) + ((weight[i] & 0x8000) ? stride : 0);
+        dst[i] = src[nearest];
+    }
+}
+
+static void remapGrayScalar(const uint8_t *src, size_t stride, const int32_t *index, const uint16_t *weight,
+                            uint8_t *dst, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (index[i] < 0) {
+            dst[i] = 0;
+            continue;
+        }
+        const uint8_t *p = src + index[i];
+        dst[i] = static_cast<uint8_t>(bilinear(p[0], p[1], p[stride], p[stride + 1], weight[i] & 0xff,
+                                               weight[i] >> 8));
+    }
+}
+
+static void remapBgrScalar(const uint8_t *src, size_t stride, const int32_t *index, const uint16_t *weight,
+                           uint8_t *dst, size_t n)
+{
+    const size_t row = stride * 3;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t *out = dst + i * 3;
+        if (index[i] < 0) {
+            out[0] = out[1] = out[2] = 0;
+            continue;
+        }
+        const uint8_t *p = src + static_cast<size_t>(index[i]) * 3;
+        const int fx = weight[i] & 0xff;
+        const int fy = weight[i] >> 8;
+        for (int ch = 0; ch < 3; ch++) {
+            out[ch] = static_cast<uint8_t>(bilinear(p[ch], p[3 + ch], p[row + ch], p[row + 3 + ch], fx, fy));
+        }
+    }
+}
+
+#ifdef REMAP_X86
+__attribute__((target("avx2")))
+static inline __m256i bilinearAvx2(__m256i a, __m256i b, __m256i c, __m256i d, __m256i fx, __m256i fy)
+{
+    __m256i top = _mm256_add_epi32(_mm256_slli_epi32(a, 8), _mm256_mullo_epi32(_mm256_sub_epi32(b, a), fx));
+    __m256i bottom = _mm256_add_epi32(_mm256_slli_epi32(c, 8), _mm256_mullo_epi32(_mm256_sub_epi32(d, c), fx));
+    __m256i sum = _mm256_add_epi32(_mm256_slli_epi32(top, 8), _mm256_mullo_epi32(_mm256_sub_epi32(bottom, top), fy));
+    return _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(1 << 15)), 16);
+}
+
+/* eight 32 bit lanes of 0..255 to eight bytes */
+__attribute__((target("avx2")))
+static inline void storeBytesAvx2(uint8_t *dst, __m256i value)
+{
+    __m256i words = _mm256_packus_epi32(value, value);
+    __m256i packed = _mm256_packus_epi16(words, words);
+    int32_t low = _mm_cvtsi128_si32(_mm256_castsi256_si128(packed));
+    int32_t high = _mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1));
+    memcpy(dst, &low, 4);
+    memcpy(dst + 4, &high, 4);
+}
+
+/*
+ * One 32 bit gather per row and pixel: bytes 0 and 1 of the word at the top
+ * left pixel are a and b, bytes 2 and 3 of the word two bytes before the
+ * bottom left pixel are c and d. The table keeps every top left pixel off
+ * the last row and column, so neither word reaches past the plane.
+ */
+__attribute__((target("avx2")))
+static void remapGrayAvx2(const uint8_t *src, size_t stride, const int32_t *index, const uint16_t *weight,
+                          uint8_t *dst, size_t n)
+{
+    const int *top_base = reinterpret_cast<const int *>(src);
+    const int *bottom_base = reinterpret_cast<const int *>(src + stride - 2);
+    const __m256i byte = _mm256_set1_epi32(0xff);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i none = _mm256_set1_epi32(-1);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(index + i));
+        __m256i valid = _mm256_cmpgt_epi32(idx, none);
+        __m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(weight + i)));
+        __m256i top = _mm256_mask_i32gather_epi32(zero, top_base, idx, valid, 1);
+        __m256i bottom = _mm256_mask_i32gather_epi32(zero, bottom_base, idx, valid, 1);
+        __m256i value = bilinearAvx2(_mm256_and_si256(top, byte), _mm256_and_si256(_mm256_srli_epi32(top, 8), byte),
+                                     _mm256_and_si256(_mm256_srli_epi32(bottom, 16), byte),
+                                     _mm256_srli_epi32(bottom, 24), _mm256_and_si256(w, byte),
+                                     _mm256_srli_epi32(w, 8));
+        storeBytesAvx2(dst + i, value);
+    }
+    remapGrayScalar(src, stride, index + i, weight + i, dst + i, n - i);
+}
+
+/*
+ * Eight BGR pixels are 24 output bytes, done as three vectors of eight
+ * (pixel, channel) lanes. A channel's left and right neighbours are 3 bytes
+ * apart, bytes 0 and 3 of one gathered word.
+ */
+__attribute__((target("avx2")))
+static void remapBgrAvx2(const uint8_t *src, size_t stride, const int32_t *index, const uint16_t *weight,
+                         uint8_t *dst, size_t n)
+{
+    const int *top_base = reinterpret_cast<const int *>(src);
+    const int *bottom_base = reinterpret_cast<const int *>(src + stride * 3);
+    const __m256i pixel[3] = {
+        _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2),
+        _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5),
+        _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7),
+    };
+    const __m256i channel[3] = {
+        _mm256_setr_epi32(0, 1, 2, 0, 1, 2, 0, 1),
+        _mm256_setr_epi32(2, 0, 1, 2, 0, 1, 2, 0),
+        _mm256_setr_epi32(1, 2, 0, 1, 2, 0, 1, 2),
+    };
+    const __m256i byte = _mm256_set1_epi32(0xff);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i none = _mm256_set1_epi32(-1);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(index + i));
+        __m256i valid = _mm256_cmpgt_epi32(idx, none);
+        __m256i offset = _mm256_add_epi32(idx, _mm256_add_epi32(idx, idx));
+        __m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(weight + i)));
+        for (int k = 0; k < 3; k++) {
+            __m256i lane_offset = _mm256_add_epi32(_mm256_permutevar8x32_epi32(offset, pixel[k]), channel[k]);
+            __m256i lane_valid = _mm256_permutevar8x32_epi32(valid, pixel[k]);
+            __m256i lane_weight = _mm256_permutevar8x32_epi32(w, pixel[k]);
+            __m256i top = _mm256_mask_i32gather_epi32(zero, top_base, lane_offset, lane_valid, 1);
+            __m256i bottom = _mm256_mask_i32gather_epi32(zero, bottom_base, lane_offset, lane_valid, 1);
+            __m256i value = bilinearAvx2(_mm256_and_si256(top, byte), _mm256_srli_epi32(top, 24),
+                                         _mm256_and_si256(bottom, byte), _mm256_srli_epi32(bottom, 24),
+                                         _mm256_and_si256(lane_weight, byte), _mm256_srli_epi32(lane_weight, 8));
+            storeBytesAvx2(dst + i * 3 + k * 8, value);
+        }
+    }
+    remapBgrScalar(src, stride, index + i, weight + i, dst + i * 3, n - i);
+}
+#endif
+
+typedef void (*RemapFunc)(const uint8_t *src, size_t stride, const int32_t *index, const uint16_t *weight,
+                          uint8_t *dst, size_t n);
+
+/* gathers only pay off with AVX2, everywhere else the scalar loops */
+static bool hasAvx2()
+{
+#ifdef REMAP_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+static RemapFunc selectRemapGray()
+{
+#ifdef REMAP_X86
+    if (hasAvx2()) {
+        return remapGrayAvx2;
+    }
+#endif
+    return remapGrayScalar;
+}
+
+static RemapFunc selectRemapBgr()
+{
+#ifdef REMAP_X86
+    if (hasAvx2()) {
+        return remapBgrAvx2;
+    }
+#endif
+    return remapBgrScalar;
+}
+
+static const RemapFunc s_remap_gray = selectRemapGray();
+static const RemapFunc s_remap_bgr = selectRemapBgr();
+
+FrameUndistorter::FrameUndistorter()
+    : m_calibration(nullptr)
+{
+    m_depth.version = m_ir.version = m_rgb.version = 0;
+}
+
+void FrameUndistorter::setCalibration(const CameraCalibration *calibration)
+{
+    m_calibration.store(calibration, std::memory_order_release);
+}
+
+void FrameUndistorter::removeDistortion(CameraCalibration &calibration)
+{
+    AS_CAM_Parameter_s &p = calibration.parameter;
+    p.K1ir = p.K2ir = p.K3ir = p.P1ir = p.P2ir = 0;
+    p.K1rgb = p.K2rgb = p.K3rgb = p.P1rgb = p.P2rgb = 0;
+}
+
+bool FrameUndistorter::prepare(RemapTable &table, const CameraCalibration &calibration, bool rgb, uint32_t width,
+                               uint32_t height)
+{
+    if ((table.version == calibration.version) && (table.width == width) && (table.height == height)) {
+        return true;
+    }
+    const AS_CAM_Parameter_s &p = calibration.parameter;
+    double fx = rgb ? p.fxrgb : p.fxir;
+    double fy = rgb ? p.fyrgb : p.fyir;
+    double cx = rgb ? p.cxrgb : p.cxir;
+    double cy = rgb ? p.cyrgb : p.cyir;
+    const double k1 = rgb ? p.K1rgb : p.K1ir;
+    const double k2 = rgb ? p.K2rgb : p.K2ir;
+    const double k3 = rgb ? p.K3rgb : p.K3ir;
+    const double p1 = rgb ? p.P1rgb : p.P1ir;
+    const double p2 = rgb ? p.P2rgb : p.P2ir;
+    if ((fx <= 0) || (fy <= 0) || (width < 2) || (height < 2)) {
+        return false;
+    }
+    if (!rgb) {
+        /* as in PointCloudProjector, the IR intrinsics belong to the depth stream they were fetched for */
+        double sx = (calibration.width > 0) ? static_cast<double>(width) / calibration.width : 1.0;
+        double sy = (calibration.height > 0) ? static_cast<double>(height) / calibration.height : 1.0;
+        fx *= sx;
+        fy *= sy;
+        cx *= sx;
+        cy *= sy;
+    }
+
+    table.version = calibration.version;
+    table.width = width;
+    table.height = height;
+    table.identity = (k1 == 0) && (k2 == 0) && (k3 == 0) && (p1 == 0) && (p2 == 0);
+    if (table.identity) {
+        table.index.clear();
+        table.weight.clear();
+        return true;
+    }
+
+    table.index.resize(static_cast<size_t>(width) * height);
+    table.weight.resize(static_cast<size_t>(width) * height);
+    for (uint32_t v = 0; v < height; v++) {
+        for (uint32_t u = 0; u < width; u++) {
+            // where the lens put the ray through the ideal pixel (u, v)
+            const double x = (u - cx) / fx;
+            const double y = (v - cy) / fy;
+            const double r2 = x * x + y * y;
+            const double radial = 1 + r2 * (k1 + r2 * (k2 + r2 * k3));
+            const double xs = fx * (x * radial + 2 * p1 * x * y + p2 * (r2 + 2 * x * x)) + cx;
+            const double ys = fy * (y * radial + p1 * (r2 + 2 * y * y) + 2 * p2 * x * y) + cy;
+            const size_t i = static_cast<size_t>(v) * width + u;
+            if (!(xs >= 0) || !(ys >= 0) || (xs > width - 1) || (ys > height - 1)) {
+                table.index[i] = -1;
+                table.weight[i] = 0;
+                continue;
+            }
+            const uint32_t x0 = std::min(static_cast<uint32_t>(xs), width - 2);
+            const uint32_t y0 = std::min(static_cast<uint32_t>(ys), height - 2);
+            const uint32_t wx = std::min(static_cast<uint32_t>((xs - x0) * 256 + 0.5), 255u);
+            const uint32_t wy = std::min(static_cast<uint32_t>((ys - y0) * 256 + 0.5), 255u);
+            table.index[i] = static_cast<int32_t>(y0 * width + x0);
+            table.weight[i] = static_cast<uint16_t>(wx | (wy << 8));
+        }
+    }
+    return true;
+}
+
+bool FrameUndistorter::filter(int type, const AS_Frame_s &src, void *dst)
+{
+    const CameraCalibration *calibration = m_calibration.load(std::memory_order_acquire);
+    if (calibration == nullptr) {
+        return false;
+    }
+    const size_t pixels = static_cast<size_t>(src.width) * src.height;
+    const size_t size = src.size;
+    RemapTable *table = nullptr;
+    switch (type) {
+    case AS_FRAME_TYPE_DEPTH:
+        table = (size == pixels * sizeof(uint16_t)) ? &m_depth : nullptr;
+        break;
+    case AS_FRAME_TYPE_IR:
+        table = (size == pixels) ? &m_ir : nullptr;
+        break;
+    case AS_FRAME_TYPE_RGB:
+        table = (size == pixels * 3) ? &m_rgb : nullptr;
+        break;
+    default:
+        break;
+    }
+    if ((table == nullptr) || !prepare(*table, *calibration, type == AS_FRAME_TYPE_RGB, src.width, src.height)
+        || table->identity) {
+        return false;
+    }
+
+    const uint8_t *in = static_cast<const uint8_t *>(src.data);
+    uint8_t *out = static_cast<uint8_t *>(dst);
+    if (type == AS_FRAME_TYPE_DEPTH) {
+        remapDepth(reinterpret_cast<const uint16_t *>(in), src.width, table->index.data(), table->weight.data(),
+                   reinterpret_cast<uint16_t *>(out), pixels);
+    } else if (type == AS_FRAME_TYPE_IR) {
+        s_remap_gray(in, src.width, table->index.data(), table->weight.data(), out, pixels);
+    } else {
+        s_remap_bgr(in, src.width, table->index.data(), table->weight.data(), out, pixels);
+    }
+    return true;
+}
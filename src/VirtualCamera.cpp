@@ -0,0 +1,40 @@
+/**
+ * @file      VirtualCamera.cpp
+ * @brief     Registry of camera handles that are not backed by the SDK
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "VirtualCamera.h"
+#include <map>
+#include <mutex>
+
+static std::mutex s_mutex;
+static std::map<AS_CAM_PTR, VirtualCameraInfo> s_cameras;
+
+void registerVirtualCamera(AS_CAM_PTR pCamera, const VirtualCameraInfo &info)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_cameras[pCamera] = info;
+}
+
+void unregisterVirtualCamera(AS_CAM_PTR pCamera)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_cameras.erase(pCamera);
+}
+
+bool findVirtualCamera(AS_CAM_PTR pCamera, VirtualCameraInfo &info)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto it = s_cameras.find(pCamera);
+    if (it == s_cameras.end()) {
+        return false;
+    }
+    info = it->second;
+    return true;
+}
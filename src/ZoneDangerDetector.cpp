@@ -0,0 +1,187 @@
+/**
+ * @file      ZoneDangerDetector.cpp
+ * @brief     Per-zone nearest obstacle detection on the depth image
+ *
+ * Copyright (c) 2025 Custom Implementation
+ *
+ * @author    Custom Developer
+ * @date      2025/08/09
+ * @version   1.0
+ */
+
+#include "ZoneDangerDetector.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ZONE_X86 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ZONE_NEON 1
+#endif
+
+/*
+ * Validity and min in one pass: b = sat_add(d - 101, BIAS) maps the valid
+ * range 101..59999 onto BIAS..65534 and everything else onto 65535, so the
+ * plain unsigned min of b is the nearest valid depth, or 65535 for none.
+ */
+static const uint16_t DEPTH_VALID_LOW = 101;
+static const uint16_t DEPTH_VALID_HIGH = 59999;
+static const uint16_t DEPTH_BIAS = 65535 - (DEPTH_VALID_HIGH - DEPTH_VALID_LOW + 1);
+static const uint16_t DEPTH_NONE = 0xffff;
+
+static inline uint16_t biasDepth(uint16_t d)
+{
+    uint32_t t = static_cast<uint16_t>(d - DEPTH_VALID_LOW) + static_cast<uint32_t>(DEPTH_BIAS);
+    return (t > DEPTH_NONE) ? DEPTH_NONE : static_cast<uint16_t>(t);
+}
+
+static uint16_t minBiasedScalar(const uint16_t *depth, size_t n)
+{
+    uint16_t m = DEPTH_NONE;
+    for (size_t i = 0; i < n; i++) {
+        uint16_t b = biasDepth(depth[i]);
+        m = (b < m) ? b : m;
+    }
+    return m;
+}
+
+#ifdef ZONE_X86
+static uint16_t minBiasedSse2(const uint16_t *depth, size_t n)
+{
+    const __m128i low = _mm_set1_epi16(static_cast<short>(DEPTH_VALID_LOW));
+    const __m128i bias = _mm_set1_epi16(static_cast<short>(DEPTH_BIAS));
+    __m128i m = _mm_set1_epi16(static_cast<short>(DEPTH_NONE));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(depth + i));
+        __m128i b = _mm_adds_epu16(_mm_sub_epi16(d, low), bias);
+        /* SSE2 has no unsigned 16 bit min: min(m, b) = m - sat_sub(m, b) */
+        m = _mm_sub_epi16(m, _mm_subs_epu16(m, b));
+    }
+    uint16_t lanes[8];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), m);
+    uint16_t result = minBiasedScalar(depth + i, n - i);
+    for (int k = 0; k < 8; k++) {
+        result = (lanes[k] < result) ? lanes[k] : result;
+    }
+    return result;
+}
+
+__attribute__((target("avx2")))
+static uint16_t minBiasedAvx2(const uint16_t *depth, size_t n)
+{
+    const __m256i low = _mm256_set1_epi16(static_cast<short>(DEPTH_VALID_LOW));
+    const __m256i bias = _mm256_set1_epi16(static_cast<short>(DEPTH_BIAS));
+    __m256i m = _mm256_set1_epi16(static_cast<short>(DEPTH_NONE));
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(depth + i));
+        m = _mm256_min_epu16(m, _mm256_adds_epu16(_mm256_sub_epi16(d, low), bias));
+    }
+    __m128i half = _mm_min_epu16(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+    /* minpos returns the lowest lane in bits 0..15 */
+    uint16_t result = static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_minpos_epu16(half)));
+    uint16_t tail = minBiasedScalar(depth + i, n - i);
+    return (tail < result) ? tail : result;
+}
+#endif
+
+#ifdef ZONE_NEON
+static uint16_t minBiasedNeon(const uint16_t *depth, size_t n)
+{
+    const uint16x8_t low = vdupq_n_u16(DEPTH_VALID_LOW);
+    const uint16x8_t bias = vdupq_n_u16(DEPTH_BIAS);
+    uint16x8_t m = vdupq_n_u16(DEPTH_NONE);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t d = vld1q_u16(depth + i);
+        m = vminq_u16(m, vqaddq_u16(vsubq_u16(d, low), bias));
+    }
+    uint16_t lanes[8];
+    vst1q_u16(lanes, m);
+    uint16_t result = minBiasedScalar(depth + i, n - i);
+    for (int k = 0; k < 8; k++) {
+        result = (lanes[k] < result) ? lanes[k] : result;
+    }
+    return result;
+}
+#endif
+
+typedef uint16_t (*MinBiasedFunc)(const uint16_t *depth, size_t n);
+
+static MinBiasedFunc selectMinBiased()
+{
+#ifdef ZONE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return minBiasedAvx2;
+    }
+    return minBiasedSse2;
+#elif defined(ZONE_NEON)
+    return minBiasedNeon;
+#else
+    return minBiasedScalar;
+#endif
+}
+
+static const MinBiasedFunc s_minBiased = selectMinBiased();
+
+static inline uint16_t unbiasDepth(uint16_t b)
+{
+    return (b == DEPTH_NONE) ? 0 : static_cast<uint16_t>(b - DEPTH_BIAS + DEPTH_VALID_LOW);
+}
+
+ZoneDangerDetector::ZoneDangerDetector(uint16_t center_threshold, uint16_t side_threshold)
+{
+    m_threshold[ZONE_LEFT] = side_threshold;
+    m_threshold[ZONE_CENTER] = center_threshold;
+    m_threshold[ZONE_RIGHT] = side_threshold;
+}
+
+uint16_t ZoneDangerDetector::minValidDepth(const uint16_t *depth, size_t n)
+{
+    return unbiasDepth(s_minBiased(depth, n));
+}
+
+bool ZoneDangerDetector::process(const AS_Frame_s &depth, ZoneDangerResult &result)
+{
+    size_t width = depth.width;
+    size_t height = depth.height;
+    if ((depth.data == nullptr) || (width == 0) || (height == 0) ||
+        (static_cast<size_t>(depth.size) < width * height * sizeof(uint16_t))) {
+        return false;
+    }
+
+    /* same split as the python client, including its float rounding */
+    size_t bounds[ZONE_COUNT + 1] = { 0, static_cast<size_t>(width * 0.3), static_cast<size_t>(width * 0.7), width };
+    uint16_t biased[ZONE_COUNT] = { DEPTH_NONE, DEPTH_NONE, DEPTH_NONE };
+
+    const uint16_t *row = static_cast<const uint16_t *>(depth.data);
+    for (size_t y = 0; y < height; y++, row += width) {
+        for (int zone = 0; zone < ZONE_COUNT; zone++) {
+            uint16_t m = s_minBiased(row + bounds[zone], bounds[zone + 1] - bounds[zone]);
+            biased[zone] = (m < biased[zone]) ? m : biased[zone];
+        }
+    }
+
+    uint16_t nearest[ZONE_COUNT];
+    for (int zone = 0; zone < ZONE_COUNT; zone++) {
+        nearest[zone] = unbiasDepth(biased[zone]);
+    }
+    classify(depth.ts, depth.frameId, nearest, result);
+    return true;
+}
+
+void ZoneDangerDetector::classify(uint64_t timestamp, uint32_t frame_id, const uint16_t nearest[ZONE_COUNT],
+                                  ZoneDangerResult &result)
+{
+    result.timestamp = timestamp;
+    result.frame_id = frame_id;
+    for (int zone = 0; zone < ZONE_COUNT; zone++) {
+        result.zones[zone].min_depth = nearest[zone];
+        /* no valid pixel counts as safe, like the python client */
+        result.zones[zone].warn = (result.zones[zone].min_depth != 0) && (result.zones[zone].min_depth < m_threshold[zone]);
+        result.zones[zone].ttc_warn = false;
+        result.zones[zone].velocity = 0.0f;
+        result.zones[zone].ttc = -1.0f;
+    }
+}
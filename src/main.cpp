@@ -11,9 +11,13 @@
  */
 
 #include <signal.h>
+#include <errno.h>
+#include <semaphore.h>
 #include "Demo.h"
 
 static Demo demo;
+/* posted by SIGUSR1, the trace is written on a thread of its own */
+static sem_t s_dump_trace;
 
 static void Get_CtrlC_handler(int sig)
 {
@@ -24,10 +28,32 @@ static void Get_CtrlC_handler(int sig)
     exit(0);
 }
 
+static void Get_Usr1_handler(int sig)
+{
+    /* sem_post is async-signal-safe, writing the trace is not */
+    sem_post(&s_dump_trace);
+}
+
+static void dumpTraceThread()
+{
+    for (;;) {
+        if (sem_wait(&s_dump_trace) != 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        demo.dumpTrace();
+    }
+}
+
 int main(int argc, char *argv[])
 {
     int ret = 0;
     signal(SIGINT, Get_CtrlC_handler);
+    sem_init(&s_dump_trace, 0, 0);
+    std::thread(dumpTraceThread).detach();
+    signal(SIGUSR1, Get_Usr1_handler);
 
     demo.start();
 
@@ -40,6 +66,21 @@ int main(int argc, char *argv[])
             demo.logFps(!demo.getLogFps());
         } else if (ch == 'q') {
             break;
+        } else if (ch == 'r') {
+            /* start or stop recording every stream */
+            demo.record(!demo.getRecordStatus());
+        } else if (ch == 'n') {
+            /* next frame of a stepped replay */
+            demo.step();
+        } else if (ch == 't') {
+            /* latency percentiles per stage and camera */
+            demo.logLatency();
+        } else if (ch == 'p') {
+            /* timeline of every thread for chrome://tracing or Perfetto */
+            demo.dumpTrace();
+        } else if (ch == 'c') {
+            /* camera parameters, e.g. after a recalibration */
+            demo.refreshCalibration();
         } else if (ch == 'l') {
             /* calculate the frame rate */
             demo.logCfgParameter();